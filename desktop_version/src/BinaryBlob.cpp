@@ -18,6 +18,8 @@ binaryBlob::binaryBlob(void)
 #endif
     SDL_zeroa(m_headers);
     SDL_zeroa(m_memblocks);
+    m_mapping = NULL;
+    m_mapping_size = 0;
 }
 
 #ifdef VVV_COMPILEMUSIC
@@ -88,11 +90,20 @@ bool binaryBlob::unPackBinary(const char* name)
 
 void binaryBlob::clear(void)
 {
-    for (size_t i = 0; i < SDL_arraysize(m_headers); i += 1)
+    if (m_mapping != NULL)
+    {
+        FILESYSTEM_unmapFile(m_mapping, m_mapping_size);
+        m_mapping = NULL;
+        m_mapping_size = 0;
+    }
+    else
     {
-        if (m_memblocks[i] != NULL)
+        for (size_t i = 0; i < SDL_arraysize(m_headers); i += 1)
         {
-            VVV_free(m_memblocks[i]);
+            if (m_memblocks[i] != NULL)
+            {
+                VVV_free(m_memblocks[i]);
+            }
         }
     }
     SDL_zeroa(m_memblocks);
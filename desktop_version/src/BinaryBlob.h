@@ -63,6 +63,11 @@ public:
 #endif
     resourceheader m_headers[max_headers];
     char* m_memblocks[max_headers];
+
+    /* If not NULL, m_memblocks point into this read-only mapping of the
+     * whole file rather than owning their own memory */
+    const unsigned char* m_mapping;
+    size_t m_mapping_size;
 };
 
 
@@ -0,0 +1,927 @@
+#include "BinarySave.h"
+
+#include <SDL.h>
+#include <string>
+#include <tinyxml2.h>
+
+#include "Alloc.h"
+#include "FileSystemUtils.h"
+#include "Vlogging.h"
+
+namespace binsave
+{
+
+/* File layout, everything little-endian:
+ *
+ *   char   magic[4] = "VVVB"
+ *   Uint16 version
+ *   Uint16 reserved
+ *   Uint32 payload size
+ *   Uint32 CRC-32 of the payload
+ *   payload: the root node
+ *
+ * A node is:
+ *
+ *   Uint8  type (NodeType)
+ *   Uint16 name size, name (including null terminator)
+ *   Uint16 number of attributes, then for each attribute:
+ *          Uint16 name size, name (including null terminator)
+ *          Uint32 value size, value (including null terminator)
+ *   NODE_ELEMENT: Uint32 number of children, then the children
+ *   NODE_TEXT:    Uint32 text size, text (including null terminator)
+ *   NODE_INT:     Sint32 value
+ *   NODE_INTS:    Uint32 count, count Sint32s
+ *
+ * Strings keep their null terminators so they can be used straight from the
+ * loaded data without copying.
+ *
+ * Version 1 stored any text that looked like a list of integers as NODE_INTS.
+ * Version 2 only does that for the arrays in int_list_names. Both are read the
+ * same way, but version 1 files can't be read straight from the nodes, see
+ * can_read_nodes(). */
+
+static const char magic[4] = {'V', 'V', 'V', 'B'};
+static const Uint16 version = 2;
+static const Uint16 min_version = 1;
+static const size_t header_size = 16;
+
+/* Saves never nest deeply, anything past this is a broken file */
+static const int max_depth = 16;
+
+static Uint32 crc32(const unsigned char* data, const size_t len)
+{
+    static Uint32 table[256];
+    static bool table_init = false;
+
+    if (!table_init)
+    {
+        for (Uint32 i = 0; i < 256; i++)
+        {
+            Uint32 c = i;
+            for (int k = 0; k < 8; k++)
+            {
+                c = (c & 1) ? (0xEDB88320 ^ (c >> 1)) : (c >> 1);
+            }
+            table[i] = c;
+        }
+        table_init = true;
+    }
+
+    Uint32 crc = 0xFFFFFFFF;
+    for (size_t i = 0; i < len; i++)
+    {
+        crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+    }
+    return crc ^ 0xFFFFFFFF;
+}
+
+static Uint16 read16(const unsigned char* p)
+{
+    return p[0] | (p[1] << 8);
+}
+
+static Uint32 read32(const unsigned char* p)
+{
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((Uint32) p[3] << 24);
+}
+
+static void write16(std::vector<unsigned char>& out, const Uint16 value)
+{
+    out.push_back(value & 0xFF);
+    out.push_back(value >> 8);
+}
+
+static void write32(std::vector<unsigned char>& out, const Uint32 value)
+{
+    out.push_back(value & 0xFF);
+    out.push_back((value >> 8) & 0xFF);
+    out.push_back((value >> 16) & 0xFF);
+    out.push_back(value >> 24);
+}
+
+bool is_binary(const unsigned char* data, const size_t len)
+{
+    return data != NULL && len >= header_size && SDL_memcmp(data, magic, sizeof(magic)) == 0;
+}
+
+struct Reader
+{
+    const unsigned char* data;
+    size_t len;
+    size_t pos;
+};
+
+static bool read_bytes(struct Reader* reader, const size_t size, const unsigned char** out)
+{
+    if (size > reader->len - reader->pos)
+    {
+        return false;
+    }
+    *out = &reader->data[reader->pos];
+    reader->pos += size;
+    return true;
+}
+
+static bool read_string(struct Reader* reader, const size_t size, const char** out)
+{
+    const unsigned char* bytes;
+    if (size == 0 || !read_bytes(reader, size, &bytes) || bytes[size - 1] != '\0')
+    {
+        return false;
+    }
+    *out = (const char*) bytes;
+    return true;
+}
+
+static bool read_u16(struct Reader* reader, Uint16* out)
+{
+    const unsigned char* bytes;
+    if (!read_bytes(reader, 2, &bytes))
+    {
+        return false;
+    }
+    *out = read16(bytes);
+    return true;
+}
+
+static bool read_u32(struct Reader* reader, Uint32* out)
+{
+    const unsigned char* bytes;
+    if (!read_bytes(reader, 4, &bytes))
+    {
+        return false;
+    }
+    *out = read32(bytes);
+    return true;
+}
+
+static bool parse_node(struct Reader* reader, std::vector<Node>& nodes, const int depth)
+{
+    const unsigned char* type;
+    Uint16 name_size;
+    Uint32 value;
+    Node node;
+    SDL_zero(node);
+
+    if (depth > max_depth
+    || !read_bytes(reader, 1, &type)
+    || !read_u16(reader, &name_size)
+    || !read_string(reader, name_size, &node.name)
+    || !read_u16(reader, &node.num_attributes))
+    {
+        return false;
+    }
+    node.type = *type;
+
+    node.attributes = (const char*) &reader->data[reader->pos];
+    for (Uint16 i = 0; i < node.num_attributes; i++)
+    {
+        Uint16 attr_name_size;
+        Uint32 attr_value_size;
+        const char* str;
+        if (!read_u16(reader, &attr_name_size)
+        || !read_string(reader, attr_name_size, &str)
+        || !read_u32(reader, &attr_value_size)
+        || !read_string(reader, attr_value_size, &str))
+        {
+            return false;
+        }
+    }
+
+    if (!read_u32(reader, &value))
+    {
+        return false;
+    }
+
+    const size_t index = nodes.size();
+    switch (node.type)
+    {
+    case NODE_ELEMENT:
+        nodes.push_back(node);
+        for (Uint32 i = 0; i < value; i++)
+        {
+            if (!parse_node(reader, nodes, depth + 1))
+            {
+                return false;
+            }
+        }
+        nodes[index].end = nodes.size();
+        return true;
+    case NODE_TEXT:
+        if (!read_string(reader, value, &node.text))
+        {
+            return false;
+        }
+        break;
+    case NODE_INT:
+        node.value = (Sint32) value;
+        break;
+    case NODE_INTS:
+        if (value > (reader->len - reader->pos) / 4
+        || !read_bytes(reader, value * 4, &node.ints))
+        {
+            return false;
+        }
+        node.count = value;
+        break;
+    default:
+        return false;
+    }
+
+    node.end = index + 1;
+    nodes.push_back(node);
+    return true;
+}
+
+bool can_read_nodes(const unsigned char* data, const size_t len)
+{
+    return is_binary(data, len) && read16(&data[4]) >= 2;
+}
+
+bool parse(const unsigned char* data, const size_t len, std::vector<Node>& nodes)
+{
+    nodes.clear();
+
+    if (!is_binary(data, len))
+    {
+        return false;
+    }
+
+    const Uint16 file_version = read16(&data[4]);
+    const Uint32 payload_size = read32(&data[8]);
+    const Uint32 checksum = read32(&data[12]);
+    if (file_version < min_version || file_version > version)
+    {
+        vlog_error(
+            "Binary save is version %i, only %i to %i are supported",
+            file_version, min_version, version
+        );
+        return false;
+    }
+    if (payload_size != len - header_size)
+    {
+        vlog_error("Binary save has the wrong size");
+        return false;
+    }
+    if (crc32(&data[header_size], payload_size) != checksum)
+    {
+        vlog_error("Binary save checksum doesn't match, file is corrupted");
+        return false;
+    }
+
+    struct Reader reader = {data, len, header_size};
+    if (!parse_node(&reader, nodes, 0) || reader.pos != len)
+    {
+        vlog_error("Binary save is malformed");
+        nodes.clear();
+        return false;
+    }
+    return true;
+}
+
+Sint32 get_int(const Node& node, const Uint32 index)
+{
+    if (node.type != NODE_INTS || index >= node.count)
+    {
+        return 0;
+    }
+    return (Sint32) read32(&node.ints[index * 4]);
+}
+
+const char* get_attribute(const Node& node, const char* name)
+{
+    const char* attr = node.attributes;
+    for (Uint16 i = 0; i < node.num_attributes; i++)
+    {
+        /* Skip the size prefixes */
+        const char* attr_name = attr + 2;
+        const char* attr_value = attr_name + SDL_strlen(attr_name) + 1 + 4;
+        if (SDL_strcmp(attr_name, name) == 0)
+        {
+            return attr_value;
+        }
+        attr = attr_value + SDL_strlen(attr_value) + 1;
+    }
+    return NULL;
+}
+
+const char* get_text(const Node& node, char* buffer, const size_t buffer_size)
+{
+    switch (node.type)
+    {
+    case NODE_TEXT:
+        return node.text;
+    case NODE_INT:
+        SDL_snprintf(buffer, buffer_size, "%i", (int) node.value);
+        return buffer;
+    case NODE_INTS:
+    {
+        size_t pos = 0;
+        if (buffer_size > 0)
+        {
+            buffer[0] = '\0';
+        }
+        for (Uint32 i = 0; i < node.count && pos < buffer_size; i++)
+        {
+            pos += SDL_snprintf(&buffer[pos], buffer_size - pos, "%i,", (int) get_int(node, i));
+        }
+        return buffer;
+    }
+    }
+    return "";
+}
+
+size_t find_data(const std::vector<Node>& nodes)
+{
+    if (nodes.empty() || nodes[0].type != NODE_ELEMENT)
+    {
+        return 0;
+    }
+    for (size_t i = 1; i < nodes[0].end; i = nodes[i].end)
+    {
+        if (nodes[i].type == NODE_ELEMENT && SDL_strcmp(nodes[i].name, "Data") == 0)
+        {
+            return i;
+        }
+    }
+    return 0;
+}
+
+/* Only accept numbers that print back exactly the same, so that converting
+ * to binary and back gives the same XML */
+static bool parse_int(const char* text, const size_t len, Sint32* out)
+{
+    char buffer[16];
+    if (len == 0 || len >= sizeof(buffer))
+    {
+        return false;
+    }
+    SDL_memcpy(buffer, text, len);
+    buffer[len] = '\0';
+
+    char* end;
+    const long value = SDL_strtol(buffer, &end, 10);
+    if (*end != '\0' || value < SDL_MIN_SINT32 || value > SDL_MAX_SINT32)
+    {
+        return false;
+    }
+
+    char check[16];
+    SDL_snprintf(check, sizeof(check), "%li", value);
+    if (SDL_strcmp(check, buffer) != 0)
+    {
+        return false;
+    }
+
+    *out = (Sint32) value;
+    return true;
+}
+
+/* The arrays that are saved as "1,0,1," lists. Only these are stored as
+ * NODE_INTS, so that any other text that happens to look like a list (a
+ * custom room name like "1,2,", say) stays text. */
+static const char* int_list_names[] = {
+    "worldmap",
+    "flags",
+    "moods",
+    "crewstats",
+    "collect",
+    "customcollect"
+};
+
+static bool is_int_list(const char* name, const char* text, const size_t len)
+{
+    if (len == 0 || text[len - 1] != ',')
+    {
+        return false;
+    }
+
+    bool known = false;
+    for (size_t i = 0; i < SDL_arraysize(int_list_names); i++)
+    {
+        if (SDL_strcmp(name, int_list_names[i]) == 0)
+        {
+            known = true;
+            break;
+        }
+    }
+    if (!known)
+    {
+        return false;
+    }
+
+    size_t start = 0;
+    for (size_t i = 0; i < len; i++)
+    {
+        Sint32 value;
+        if (text[i] != ',')
+        {
+            continue;
+        }
+        if (!parse_int(&text[start], i - start, &value))
+        {
+            return false;
+        }
+        start = i + 1;
+    }
+    return true;
+}
+
+static void write_string(std::vector<unsigned char>& out, const char* str, const bool wide)
+{
+    const size_t size = SDL_strlen(str) + 1;
+    if (wide)
+    {
+        write32(out, size);
+    }
+    else
+    {
+        write16(out, size);
+    }
+    out.insert(out.end(), str, str + size);
+}
+
+static void write_node(std::vector<unsigned char>& out, const tinyxml2::XMLElement* element)
+{
+    Uint32 num_children = 0;
+    for (const tinyxml2::XMLElement* child = element->FirstChildElement();
+    child != NULL;
+    child = child->NextSiblingElement())
+    {
+        num_children++;
+    }
+
+    const char* text = element->GetText();
+    if (text == NULL)
+    {
+        text = "";
+    }
+    const size_t len = SDL_strlen(text);
+
+    Uint8 type;
+    Sint32 value = 0;
+    if (num_children > 0)
+    {
+        type = NODE_ELEMENT;
+    }
+    else if (parse_int(text, len, &value))
+    {
+        type = NODE_INT;
+    }
+    else if (is_int_list(element->Name(), text, len))
+    {
+        type = NODE_INTS;
+    }
+    else
+    {
+        type = NODE_TEXT;
+    }
+
+    out.push_back(type);
+    write_string(out, element->Name(), false);
+
+    Uint16 num_attributes = 0;
+    for (const tinyxml2::XMLAttribute* attr = element->FirstAttribute(); attr != NULL; attr = attr->Next())
+    {
+        num_attributes++;
+    }
+    write16(out, num_attributes);
+    for (const tinyxml2::XMLAttribute* attr = element->FirstAttribute(); attr != NULL; attr = attr->Next())
+    {
+        write_string(out, attr->Name(), false);
+        write_string(out, attr->Value(), true);
+    }
+
+    switch (type)
+    {
+    case NODE_ELEMENT:
+        write32(out, num_children);
+        for (const tinyxml2::XMLElement* child = element->FirstChildElement();
+        child != NULL;
+        child = child->NextSiblingElement())
+        {
+            write_node(out, child);
+        }
+        break;
+    case NODE_INT:
+        write32(out, (Uint32) value);
+        break;
+    case NODE_TEXT:
+        write_string(out, text, true);
+        break;
+    case NODE_INTS:
+    {
+        const size_t count_pos = out.size();
+        Uint32 count = 0;
+        size_t start = 0;
+        write32(out, 0); /* Count, filled in below */
+        for (size_t i = 0; i < len; i++)
+        {
+            if (text[i] == ',')
+            {
+                parse_int(&text[start], i - start, &value);
+                write32(out, (Uint32) value);
+                count++;
+                start = i + 1;
+            }
+        }
+        for (int i = 0; i < 4; i++)
+        {
+            out[count_pos + i] = (count >> (i * 8)) & 0xFF;
+        }
+        break;
+    }
+    }
+}
+
+bool from_xml(tinyxml2::XMLDocument& doc, std::vector<unsigned char>& out)
+{
+    const tinyxml2::XMLElement* root = doc.RootElement();
+    if (root == NULL)
+    {
+        return false;
+    }
+
+    out.clear();
+    out.insert(out.end(), magic, magic + sizeof(magic));
+    write16(out, version);
+    write16(out, 0);
+    write32(out, 0); /* Payload size, filled in below */
+    write32(out, 0); /* Checksum, filled in below */
+
+    write_node(out, root);
+
+    const Uint32 payload_size = out.size() - header_size;
+    const Uint32 checksum = crc32(&out[header_size], payload_size);
+    for (int i = 0; i < 4; i++)
+    {
+        out[8 + i] = (payload_size >> (i * 8)) & 0xFF;
+        out[12 + i] = (checksum >> (i * 8)) & 0xFF;
+    }
+    return true;
+}
+
+static void build_element(
+    const std::vector<Node>& nodes,
+    const size_t index,
+    tinyxml2::XMLDocument& doc,
+    tinyxml2::XMLNode* parent
+) {
+    const Node& node = nodes[index];
+    tinyxml2::XMLElement* element = doc.NewElement(node.name);
+    parent->LinkEndChild(element);
+
+    const char* attr = node.attributes;
+    for (Uint16 i = 0; i < node.num_attributes; i++)
+    {
+        const char* attr_name = attr + 2;
+        const char* attr_value = attr_name + SDL_strlen(attr_name) + 1 + 4;
+        element->SetAttribute(attr_name, attr_value);
+        attr = attr_value + SDL_strlen(attr_value) + 1;
+    }
+
+    switch (node.type)
+    {
+    case NODE_ELEMENT:
+        for (size_t i = index + 1; i < node.end; i = nodes[i].end)
+        {
+            build_element(nodes, i, doc, element);
+        }
+        break;
+    case NODE_TEXT:
+        if (node.text[0] != '\0')
+        {
+            element->InsertNewText(node.text);
+        }
+        break;
+    case NODE_INT:
+        element->SetText(node.value);
+        break;
+    case NODE_INTS:
+    {
+        std::string list;
+        list.reserve(node.count * 2);
+        for (Uint32 i = 0; i < node.count; i++)
+        {
+            char buffer[16];
+            SDL_snprintf(buffer, sizeof(buffer), "%i,", (int) get_int(node, i));
+            list += buffer;
+        }
+        element->InsertNewText(list.c_str());
+        break;
+    }
+    }
+}
+
+bool to_xml(const std::vector<Node>& nodes, tinyxml2::XMLDocument& doc)
+{
+    doc.Clear();
+    if (nodes.empty())
+    {
+        return false;
+    }
+
+    doc.InsertFirstChild(doc.NewDeclaration());
+    build_element(nodes, 0, doc, &doc);
+    return true;
+}
+
+void parse_document(const unsigned char* data, const size_t len, tinyxml2::XMLDocument& doc)
+{
+    if (is_binary(data, len))
+    {
+        std::vector<Node> nodes;
+        if (!parse(data, len, nodes) || !to_xml(nodes, doc))
+        {
+            /* Make it look like a parse error to the caller */
+            doc.Parse("");
+        }
+    }
+    else
+    {
+        doc.Parse((const char*) data);
+    }
+}
+
+bool load_document(const char* name, tinyxml2::XMLDocument& doc)
+{
+    unsigned char* mem;
+    size_t len;
+    FILESYSTEM_loadFileToMemory(name, &mem, &len);
+    if (mem == NULL)
+    {
+        return false;
+    }
+
+    parse_document(mem, len, doc);
+
+    VVV_free(mem);
+    return true;
+}
+
+bool save_document(const char* name, tinyxml2::XMLDocument& doc, const bool binary)
+{
+    const Uint64 start = SDL_GetPerformanceCounter();
+    bool success;
+
+    if (binary)
+    {
+        std::vector<unsigned char> out;
+        success = from_xml(doc, out)
+        && FILESYSTEM_saveFileAsync(name, out.data(), out.size());
+    }
+    else
+    {
+        success = FILESYSTEM_saveTiXml2DocumentAsync(name, doc);
+    }
+
+    vlog_debug(
+        "Serialized %s (%s) in %.3f ms",
+        name,
+        binary ? "binary" : "XML",
+        (SDL_GetPerformanceCounter() - start) * 1000.0 / SDL_GetPerformanceFrequency()
+    );
+    return success;
+}
+
+static unsigned char* read_native_file(const char* path, size_t* len)
+{
+    SDL_RWops* rw = SDL_RWFromFile(path, "rb");
+    if (rw == NULL)
+    {
+        vlog_error("Could not open %s: %s", path, SDL_GetError());
+        return NULL;
+    }
+    const Sint64 size = SDL_RWsize(rw);
+    unsigned char* mem = (unsigned char*) SDL_malloc(size > 0 ? size + 1 : 1);
+    if (mem == NULL)
+    {
+        SDL_RWclose(rw);
+        return NULL;
+    }
+    *len = size > 0 ? SDL_RWread(rw, mem, 1, size) : 0;
+    mem[*len] = '\0';
+    SDL_RWclose(rw);
+    return mem;
+}
+
+bool convert_file(const char* in_path, const char* out_path)
+{
+    size_t len;
+    unsigned char* mem = read_native_file(in_path, &len);
+    if (mem == NULL)
+    {
+        return false;
+    }
+
+    tinyxml2::XMLDocument doc;
+    std::vector<unsigned char> out;
+    const bool binary = is_binary(mem, len);
+    bool success;
+
+    if (binary)
+    {
+        std::vector<Node> nodes;
+        const Uint64 start = SDL_GetPerformanceCounter();
+        success = parse(mem, len, nodes);
+        const Uint64 end = SDL_GetPerformanceCounter();
+        vlog_info(
+            "Parsed binary save in %.3f ms",
+            (end - start) * 1000.0 / SDL_GetPerformanceFrequency()
+        );
+        if (success)
+        {
+            tinyxml2::XMLPrinter printer;
+            to_xml(nodes, doc);
+            doc.Print(&printer);
+            out.assign(printer.CStr(), printer.CStr() + printer.CStrSize() - 1);
+        }
+    }
+    else
+    {
+        const Uint64 start = SDL_GetPerformanceCounter();
+        doc.Parse((const char*) mem, len);
+        const Uint64 end = SDL_GetPerformanceCounter();
+        vlog_info(
+            "Parsed XML save in %.3f ms",
+            (end - start) * 1000.0 / SDL_GetPerformanceFrequency()
+        );
+        success = !doc.Error() && from_xml(doc, out);
+        if (doc.Error())
+        {
+            vlog_error("Error parsing %s: %s", in_path, doc.ErrorStr());
+        }
+    }
+    VVV_free(mem);
+
+    if (!success)
+    {
+        vlog_error("Could not convert %s", in_path);
+        return false;
+    }
+
+    SDL_RWops* rw = SDL_RWFromFile(out_path, "wb");
+    if (rw == NULL)
+    {
+        vlog_error("Could not open %s: %s", out_path, SDL_GetError());
+        return false;
+    }
+    success = SDL_RWwrite(rw, out.data(), 1, out.size()) == out.size();
+    success = SDL_RWclose(rw) == 0 && success;
+    if (!success)
+    {
+        vlog_error("Could not write %s: %s", out_path, SDL_GetError());
+        return false;
+    }
+
+    vlog_info(
+        "Converted %s (%s, %i bytes) to %s (%s, %i bytes)",
+        in_path, binary ? "binary" : "XML", (int) len,
+        out_path, binary ? "XML" : "binary", (int) out.size()
+    );
+    return true;
+}
+
+static double elapsed_us(const Uint64 start, const int iterations)
+{
+    return (SDL_GetPerformanceCounter() - start) * 1000000.0
+        / SDL_GetPerformanceFrequency() / iterations;
+}
+
+static std::string print_document(tinyxml2::XMLDocument& doc)
+{
+    tinyxml2::XMLPrinter printer;
+    doc.Print(&printer);
+    return std::string(printer.CStr(), printer.CStrSize() - 1);
+}
+
+static const char* element_text(const tinyxml2::XMLElement* element)
+{
+    const char* text = element->GetText();
+    return text != NULL ? text : "";
+}
+
+/* Compares everything the binary format keeps (so not comments) */
+static bool same_elements(const tinyxml2::XMLElement* a, const tinyxml2::XMLElement* b)
+{
+    if (SDL_strcmp(a->Name(), b->Name()) != 0
+    || SDL_strcmp(element_text(a), element_text(b)) != 0)
+    {
+        vlog_error("<%s> became <%s>: %s", a->Name(), b->Name(), element_text(b));
+        return false;
+    }
+
+    const tinyxml2::XMLAttribute* attr_a = a->FirstAttribute();
+    const tinyxml2::XMLAttribute* attr_b = b->FirstAttribute();
+    for (; attr_a != NULL && attr_b != NULL; attr_a = attr_a->Next(), attr_b = attr_b->Next())
+    {
+        if (SDL_strcmp(attr_a->Name(), attr_b->Name()) != 0
+        || SDL_strcmp(attr_a->Value(), attr_b->Value()) != 0)
+        {
+            vlog_error("Attribute %s of <%s> changed", attr_a->Name(), a->Name());
+            return false;
+        }
+    }
+
+    const tinyxml2::XMLElement* child_a = a->FirstChildElement();
+    const tinyxml2::XMLElement* child_b = b->FirstChildElement();
+    for (; child_a != NULL && child_b != NULL;
+    child_a = child_a->NextSiblingElement(), child_b = child_b->NextSiblingElement())
+    {
+        if (!same_elements(child_a, child_b))
+        {
+            return false;
+        }
+    }
+
+    if (attr_a != attr_b || child_a != child_b)
+    {
+        /* Both are NULL if neither one has any left over */
+        vlog_error("<%s> doesn't have the same contents anymore", a->Name());
+        return false;
+    }
+    return true;
+}
+
+bool benchmark_file(const char* path, const int iterations)
+{
+    size_t len;
+    unsigned char* mem = read_native_file(path, &len);
+    if (mem == NULL)
+    {
+        return false;
+    }
+
+    /* Everything is compared as XML, the way the game would write it */
+    tinyxml2::XMLDocument doc;
+    parse_document(mem, len, doc);
+    VVV_free(mem);
+    if (doc.Error() || doc.RootElement() == NULL)
+    {
+        vlog_error("Error parsing %s", path);
+        return false;
+    }
+    const std::string xml = print_document(doc);
+    tinyxml2::XMLDocument original;
+    original.Parse(xml.c_str(), xml.size());
+
+    std::vector<unsigned char> binary;
+    std::vector<Node> nodes;
+    bool success = true;
+
+    Uint64 start = SDL_GetPerformanceCounter();
+    for (int i = 0; i < iterations; i++)
+    {
+        doc.Parse(xml.c_str(), xml.size());
+    }
+    const double xml_read = elapsed_us(start, iterations);
+
+    start = SDL_GetPerformanceCounter();
+    for (int i = 0; i < iterations; i++)
+    {
+        tinyxml2::XMLPrinter printer;
+        doc.Print(&printer);
+    }
+    const double xml_write = elapsed_us(start, iterations);
+
+    start = SDL_GetPerformanceCounter();
+    for (int i = 0; i < iterations; i++)
+    {
+        success = from_xml(doc, binary) && success;
+    }
+    const double binary_write = elapsed_us(start, iterations);
+
+    start = SDL_GetPerformanceCounter();
+    for (int i = 0; i < iterations; i++)
+    {
+        success = parse(binary.data(), binary.size(), nodes) && success;
+    }
+    const double binary_read = elapsed_us(start, iterations);
+
+    start = SDL_GetPerformanceCounter();
+    for (int i = 0; i < iterations; i++)
+    {
+        success = to_xml(nodes, doc) && success;
+    }
+    const double binary_to_xml = elapsed_us(start, iterations);
+
+    /* XML -> binary -> XML has to give back what we started with */
+    if (!success || !same_elements(original.RootElement(), doc.RootElement()))
+    {
+        vlog_error("%s doesn't survive converting to binary and back", path);
+        return false;
+    }
+
+    vlog_info("%s, average of %i runs:", path, iterations);
+    vlog_info(
+        "XML:    %7i bytes, read %9.2f us, write %9.2f us",
+        (int) xml.size(), xml_read, xml_write
+    );
+    vlog_info(
+        "Binary: %7i bytes, read %9.2f us, write %9.2f us, to XML %9.2f us",
+        (int) binary.size(), binary_read, binary_write, binary_to_xml
+    );
+    return true;
+}
+
+} // namespace binsave
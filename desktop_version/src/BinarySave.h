@@ -0,0 +1,88 @@
+#ifndef BINARYSAVE_H
+#define BINARYSAVE_H
+
+#include <SDL_stdinc.h>
+#include <stddef.h>
+#include <vector>
+
+// Forward decl, avoid including tinyxml2.h
+namespace tinyxml2
+{
+    class XMLDocument;
+}
+
+/* A compact binary encoding of the XML save files. It mirrors the XML tree
+ * exactly (elements, attributes, text), except that text which is an integer
+ * or a comma-separated list of integers is stored as raw little-endian
+ * integers, so loading doesn't have to parse any numbers. */
+namespace binsave
+{
+
+enum NodeType
+{
+    NODE_ELEMENT, /* Has child nodes */
+    NODE_TEXT,
+    NODE_INT,
+    NODE_INTS
+};
+
+/* A view into a loaded binary save; all pointers point into the loaded data.
+ * Nodes are stored depth-first, so the children of nodes[i] are the nodes
+ * from i + 1 up to (but not including) nodes[i].end. */
+struct Node
+{
+    Uint8 type;
+    const char* name;
+    Uint16 num_attributes;
+    const char* attributes; /* Raw, use get_attribute() */
+    const char* text; /* NODE_TEXT */
+    Sint32 value; /* NODE_INT */
+    const unsigned char* ints; /* NODE_INTS */
+    Uint32 count; /* NODE_INTS */
+    size_t end;
+};
+
+bool is_binary(const unsigned char* data, size_t len);
+
+/* Whether the nodes of this binary save can be read directly. In version 1
+ * files any text that looked like a list of integers is stored as NODE_INTS,
+ * which get_text() may not have room for, so those go through to_xml(). */
+bool can_read_nodes(const unsigned char* data, size_t len);
+
+bool parse(const unsigned char* data, size_t len, std::vector<Node>& nodes);
+
+Sint32 get_int(const Node& node, Uint32 index);
+
+const char* get_attribute(const Node& node, const char* name);
+
+/* Returns the node's value as it would appear in XML. Integers and lists
+ * of integers are printed into the buffer, and cut off if it's too small. */
+const char* get_text(const Node& node, char* buffer, size_t buffer_size);
+
+/* Returns the index of the <Data> node inside the root node, or 0 if not found */
+size_t find_data(const std::vector<Node>& nodes);
+
+bool from_xml(tinyxml2::XMLDocument& doc, std::vector<unsigned char>& out);
+
+bool to_xml(const std::vector<Node>& nodes, tinyxml2::XMLDocument& doc);
+
+/* Parses a save that's already in memory, binary or XML. The data must be
+ * null-terminated, like FILESYSTEM_loadFileToMemory() leaves it. */
+void parse_document(const unsigned char* data, size_t len, tinyxml2::XMLDocument& doc);
+
+/* Like FILESYSTEM_loadTiXml2Document(), but also accepts binary saves */
+bool load_document(const char* name, tinyxml2::XMLDocument& doc);
+
+/* Saves in binary if `binary` is set, otherwise as XML */
+bool save_document(const char* name, tinyxml2::XMLDocument& doc, bool binary);
+
+/* Converts a save file on disk (not through PhysFS) to the other format */
+bool convert_file(const char* in_path, const char* out_path);
+
+/* Times reading and writing a save file on disk (either format) as XML and as
+ * binary, and checks that converting it to binary and back changes nothing */
+bool benchmark_file(const char* path, int iterations);
+
+} // namespace binsave
+
+#endif /* BINARYSAVE_H */
@@ -1,6 +1,8 @@
 #define CL_DEFINITION
 #include "CustomLevels.h"
 
+#include <algorithm>
+#include <map>
 #include <physfs.h>
 #include <stdio.h>
 #include <string>
@@ -41,6 +43,20 @@
 
 #define VMULT(y) (y * SCREEN_WIDTH_TILES * maxwidth)
 #define Y_INBOUNDS(y) (y >= 0 && y < SCREEN_HEIGHT_TILES * maxheight)
+#define ROOM_TILES (SCREEN_WIDTH_TILES * SCREEN_HEIGHT_TILES)
+#define BAND_TILES (ROOM_TILES * customlevelclass::maxwidth)
+#define TILE_IDX_INBOUNDS(idx) (idx >= 0 && idx < ROOM_TILES * customlevelclass::numrooms)
+
+/* Splits an index from gettileidx() into a room and a tile in that room */
+static void split_tile_idx(const int idx, int* room, int* tile)
+{
+    const int row_width = SCREEN_WIDTH_TILES * customlevelclass::maxwidth;
+    const int x = idx % row_width;
+    const int y = idx / row_width;
+
+    *room = (y / SCREEN_HEIGHT_TILES) * customlevelclass::maxwidth + x / SCREEN_WIDTH_TILES;
+    *tile = TILE_IDX(x % SCREEN_WIDTH_TILES, y % SCREEN_HEIGHT_TILES);
+}
 
 RoomProperty::RoomProperty(void)
 {
@@ -61,13 +77,25 @@ RoomProperty::RoomProperty(void)
     directmode=0;
 }
 
+RoomTiles::RoomTiles(void)
+{
+    tiles = NULL;
+    dirty = false;
+    newer = -1;
+    older = -1;
+}
+
 customlevelclass::customlevelclass(void)
 {
+    compressrooms = false;
+    numdecodedrooms = 0;
+    newestroom = -1;
+    oldestroom = -1;
     reset();
 }
 
 // comparison, not case sensitive.
-static bool compare_nocase (std::string first, std::string second)
+static bool compare_nocase (const std::string& first, const std::string& second)
 {
     unsigned int i=0;
     while ( (i<first.length()) && (i<second.length()) )
@@ -84,6 +112,16 @@ static bool compare_nocase (std::string first, std::string second)
         return false;
 }
 
+static bool compare_title(const LevelMetaData& first, const LevelMetaData& second)
+{
+    return compare_nocase(first.title, second.title);
+}
+
+static bool compare_filename(const LevelMetaData& first, const LevelMetaData& second)
+{
+    return first.filename < second.filename;
+}
+
 /* translate_title and translate_creator are used to display default title/author
  * as being translated, while they're actually stored in English in the level file.
  * This way we translate "Untitled Level" and "Unknown" without
@@ -98,24 +136,6 @@ bool translate_creator(const std::string& creator)
     return creator == "Unknown";
 }
 
-static void levelZipCallback(const char* filename)
-{
-    if (!FILESYSTEM_isFile(filename))
-    {
-        return;
-    }
-
-    if (endsWith(filename, ".zip"))
-    {
-        FILESYSTEM_loadZip(filename);
-    }
-}
-
-void customlevelclass::loadZips(void)
-{
-    FILESYSTEM_enumerateLevelDirFileNames(levelZipCallback);
-}
-
 static void replace_all(std::string& str, const std::string& from, const std::string& to)
 {
     if (from.empty())
@@ -229,11 +249,379 @@ TAG_FINDER(find_playmusic, "playmusic")
 
 #undef TAG_FINDER
 
-static void levelMetaDataCallback(const char* filename)
+/* Metadata of every level in the levels list, kept in saves/levelmeta.vvv.
+ * An entry is reused as long as the level file has the same size and
+ * modification time, so only new or changed levels need to be read. */
+#define LEVEL_META_CACHE_VERSION 2
+
+struct LevelMetaCacheEntry
+{
+    PHYSFS_sint64 size;
+    PHYSFS_sint64 mtime;
+    LevelMetaData data;
+    std::string font;
+    bool seen;
+};
+
+static std::map<std::string, LevelMetaCacheEntry> level_meta_cache;
+
+struct LevelScanJob
+{
+    std::string filename;
+    PHYSFS_sint64 size;
+    PHYSFS_sint64 mtime;
+    LevelMetaData data;
+    std::string font;
+    bool success;
+};
+
+static std::vector<LevelScanJob> level_scan_jobs;
+static bool level_meta_cache_loaded = false;
+static bool level_meta_cache_dirty = false;
+
+/* Level zips, indexed from their central directories, and also kept in
+ * saves/levelmeta.vvv. A zip only gets mounted once one of its levels is
+ * actually read, instead of all of them being mounted up front. */
+struct LevelZipEntry
+{
+    std::string path;
+    PHYSFS_sint64 size;
+    PHYSFS_sint64 crc32;
+};
+
+struct LevelZip
+{
+    PHYSFS_sint64 size;
+    PHYSFS_sint64 mtime;
+    std::vector<LevelZipEntry> levels;
+    bool indexed;
+    bool mounted;
+    bool seen;
+};
+
+static std::map<std::string, LevelZip> level_zips;
+
+/* Level path -> the zip it's in. If several zips have the same level, the
+ * first one wins, same as it would with all of them mounted. */
+static std::map<std::string, std::string> level_zip_index;
+
+static const char* cached_tag(tinyxml2::XMLElement* parent, const char* name)
+{
+    tinyxml2::XMLElement* element = parent->FirstChildElement(name);
+    if (element == NULL || element->GetText() == NULL)
+    {
+        return "";
+    }
+    return element->GetText();
+}
+
+static void load_level_meta_cache(void)
+{
+    tinyxml2::XMLDocument doc;
+    tinyxml2::XMLElement* root;
+    tinyxml2::XMLElement* pElem;
+
+    level_meta_cache_loaded = true;
+    level_meta_cache.clear();
+    level_zips.clear();
+
+    if (!FILESYSTEM_loadTiXml2Document("saves/levelmeta.vvv", doc))
+    {
+        return;
+    }
+
+    root = doc.FirstChildElement("LevelMetaCache");
+    if (doc.Error()
+    || root == NULL
+    || root->IntAttribute("version") != LEVEL_META_CACHE_VERSION)
+    {
+        vlog_info("Level metadata cache is outdated, rebuilding it");
+        level_meta_cache_dirty = true;
+        return;
+    }
+
+    for (pElem = root->FirstChildElement("level"); pElem != NULL; pElem = pElem->NextSiblingElement("level"))
+    {
+        const char* path = pElem->Attribute("path");
+        if (path == NULL)
+        {
+            continue;
+        }
+
+        LevelMetaCacheEntry entry;
+        entry.size = pElem->Int64Attribute("size", -1);
+        entry.mtime = pElem->Int64Attribute("mtime", -1);
+        entry.seen = false;
+
+        entry.data.title = cached_tag(pElem, "title");
+        entry.data.creator = cached_tag(pElem, "creator");
+        entry.data.Desc1 = cached_tag(pElem, "Desc1");
+        entry.data.Desc2 = cached_tag(pElem, "Desc2");
+        entry.data.Desc3 = cached_tag(pElem, "Desc3");
+        entry.data.website = cached_tag(pElem, "website");
+        entry.font = cached_tag(pElem, "font");
+        entry.data.rtl = help.Int(cached_tag(pElem, "rtl"));
+
+        entry.data.title_is_gettext = translate_title(entry.data.title);
+        entry.data.creator_is_gettext = translate_creator(entry.data.creator);
+        entry.data.filename = path;
+
+        level_meta_cache[path] = entry;
+    }
+
+    for (pElem = root->FirstChildElement("zip"); pElem != NULL; pElem = pElem->NextSiblingElement("zip"))
+    {
+        const char* path = pElem->Attribute("path");
+        if (path == NULL)
+        {
+            continue;
+        }
+
+        LevelZip zip;
+        zip.size = pElem->Int64Attribute("size", -1);
+        zip.mtime = pElem->Int64Attribute("mtime", -1);
+        zip.indexed = true;
+        zip.mounted = false;
+        zip.seen = false;
+
+        for (tinyxml2::XMLElement* level = pElem->FirstChildElement("level"); level != NULL; level = level->NextSiblingElement("level"))
+        {
+            const char* level_path = level->Attribute("path");
+            if (level_path == NULL)
+            {
+                continue;
+            }
+
+            LevelZipEntry entry;
+            entry.path = level_path;
+            entry.size = level->Int64Attribute("size", -1);
+            entry.crc32 = level->Int64Attribute("crc32", -1);
+            zip.levels.push_back(entry);
+        }
+
+        level_zips[path] = zip;
+    }
+}
+
+static void save_level_meta_cache(void)
+{
+    tinyxml2::XMLDocument doc;
+
+    xml::update_declaration(doc);
+
+    tinyxml2::XMLElement* root = doc.NewElement("LevelMetaCache");
+    root->SetAttribute("version", LEVEL_META_CACHE_VERSION);
+    doc.LinkEndChild(root);
+
+    for (std::map<std::string, LevelMetaCacheEntry>::const_iterator it = level_meta_cache.begin();
+    it != level_meta_cache.end();
+    ++it)
+    {
+        const LevelMetaCacheEntry& entry = it->second;
+        tinyxml2::XMLElement* level = doc.NewElement("level");
+        level->SetAttribute("path", it->first.c_str());
+        level->SetAttribute("size", (int64_t) entry.size);
+        level->SetAttribute("mtime", (int64_t) entry.mtime);
+
+        xml::update_tag(level, "title", entry.data.title.c_str());
+        xml::update_tag(level, "creator", entry.data.creator.c_str());
+        xml::update_tag(level, "Desc1", entry.data.Desc1.c_str());
+        xml::update_tag(level, "Desc2", entry.data.Desc2.c_str());
+        xml::update_tag(level, "Desc3", entry.data.Desc3.c_str());
+        xml::update_tag(level, "website", entry.data.website.c_str());
+        xml::update_tag(level, "font", entry.font.c_str());
+        xml::update_tag(level, "rtl", (int) entry.data.rtl);
+
+        root->LinkEndChild(level);
+    }
+
+    for (std::map<std::string, LevelZip>::const_iterator it = level_zips.begin();
+    it != level_zips.end();
+    ++it)
+    {
+        const LevelZip& zip = it->second;
+        if (!zip.indexed)
+        {
+            continue;
+        }
+
+        tinyxml2::XMLElement* zip_element = doc.NewElement("zip");
+        zip_element->SetAttribute("path", it->first.c_str());
+        zip_element->SetAttribute("size", (int64_t) zip.size);
+        zip_element->SetAttribute("mtime", (int64_t) zip.mtime);
+
+        for (size_t i = 0; i < zip.levels.size(); i++)
+        {
+            tinyxml2::XMLElement* level = doc.NewElement("level");
+            level->SetAttribute("path", zip.levels[i].path.c_str());
+            level->SetAttribute("size", (int64_t) zip.levels[i].size);
+            level->SetAttribute("crc32", (int64_t) zip.levels[i].crc32);
+            zip_element->LinkEndChild(level);
+        }
+
+        root->LinkEndChild(zip_element);
+    }
+
+    FILESYSTEM_saveTiXml2DocumentAsync("saves/levelmeta.vvv", doc);
+    level_meta_cache_dirty = false;
+}
+
+static void add_zip_entry(const ZipEntryInfo* info, void* userdata)
+{
+    LevelZip* zip = (LevelZip*) userdata;
+
+    /* Only levels at the top of the zip, like PHYSFS_enumerate("levels")
+     * would list; not ones in subfolders, or macOS's __MACOSX/._*.vvvvvv */
+    if (!endsWith(info->name, ".vvvvvv") || SDL_strchr(info->name, '/') != NULL)
+    {
+        return;
+    }
+
+    /* Zips get mounted in levels/ */
+    LevelZipEntry entry;
+    entry.path = std::string("levels/") + info->name;
+    entry.size = info->size;
+    entry.crc32 = info->crc32;
+    zip->levels.push_back(entry);
+}
+
+static void levelZipCallback(const char* filename)
+{
+    PHYSFS_Stat stat;
+
+    if (!FILESYSTEM_isFile(filename) || !endsWith(filename, ".zip"))
+    {
+        return;
+    }
+
+    if (!PHYSFS_stat(filename, &stat))
+    {
+        stat.filesize = -1;
+        stat.modtime = -1;
+    }
+
+    LevelZip& zip = level_zips[filename];
+    if (!zip.indexed
+    || zip.size != stat.filesize
+    || zip.mtime != stat.modtime
+    || stat.modtime == -1)
+    {
+        zip.size = stat.filesize;
+        zip.mtime = stat.modtime;
+        zip.levels.clear();
+        zip.indexed = FILESYSTEM_enumerateZipEntries(filename, add_zip_entry, &zip);
+        level_meta_cache_dirty = true;
+    }
+    zip.seen = true;
+
+    if (!zip.indexed)
+    {
+        /* Can't read this one ourselves, so mount it and let PhysFS find
+         * the levels in it */
+        vlog_warn("Could not index %s, mounting it", filename);
+        zip.levels.clear();
+        if (!zip.mounted)
+        {
+            FILESYSTEM_loadZip(filename);
+            zip.mounted = true;
+        }
+        return;
+    }
+
+    for (size_t i = 0; i < zip.levels.size(); i++)
+    {
+        if (level_zip_index.find(zip.levels[i].path) == level_zip_index.end())
+        {
+            level_zip_index[zip.levels[i].path] = filename;
+        }
+    }
+}
+
+void customlevelclass::loadZips(void)
+{
+    if (!level_meta_cache_loaded)
+    {
+        load_level_meta_cache();
+    }
+
+    level_zip_index.clear();
+    for (std::map<std::string, LevelZip>::iterator it = level_zips.begin();
+    it != level_zips.end();
+    ++it)
+    {
+        it->second.seen = false;
+    }
+
+    FILESYSTEM_enumerateLevelDirFileNames(levelZipCallback);
+
+    /* Forget about zips that are gone */
+    for (std::map<std::string, LevelZip>::iterator it = level_zips.begin();
+    it != level_zips.end();
+    /* Increment code handled separately */)
+    {
+        if (!it->second.seen)
+        {
+            level_zips.erase(it++);
+            level_meta_cache_dirty = true;
+        }
+        else
+        {
+            ++it;
+        }
+    }
+}
+
+void customlevelclass::mountZipFor(const std::string& path)
+{
+    std::map<std::string, std::string>::const_iterator found = level_zip_index.find(path);
+    if (found == level_zip_index.end())
+    {
+        return;
+    }
+
+    LevelZip& zip = level_zips[found->second];
+    if (!zip.mounted)
+    {
+        FILESYSTEM_loadZip(found->second.c_str());
+        zip.mounted = true;
+    }
+}
+
+static void queue_level_scan(const std::string& filename, const PHYSFS_sint64 size, const PHYSFS_sint64 mtime)
 {
     extern customlevelclass cl;
-    LevelMetaData temp;
-    std::string filename_ = filename;
+
+    std::map<std::string, LevelMetaCacheEntry>::iterator cached = level_meta_cache.find(filename);
+    if (cached != level_meta_cache.end()
+    && cached->second.size == size
+    && cached->second.mtime == mtime
+    && mtime != -1)
+    {
+        LevelMetaCacheEntry& entry = cached->second;
+        entry.seen = true;
+        /* Font indices depend on what fonts are loaded, so look it up again */
+        if (!font::find_main_font_by_name(entry.font.c_str(), &entry.data.level_main_font_idx))
+        {
+            entry.data.level_main_font_idx = font::get_font_idx_8x8();
+        }
+        cl.ListOfMetaData.push_back(entry.data);
+        return;
+    }
+
+    /* Not cached, read it later along with all the others */
+    cl.mountZipFor(filename);
+
+    LevelScanJob job;
+    job.filename = filename;
+    job.size = size;
+    job.mtime = mtime;
+    job.success = false;
+    level_scan_jobs.push_back(job);
+}
+
+static void levelMetaDataCallback(const char* filename)
+{
+    PHYSFS_Stat stat;
 
     if (!endsWith(filename, ".vvvvvv")
     || !FILESYSTEM_isFile(filename)
@@ -242,18 +630,85 @@ static void levelMetaDataCallback(const char* filename)
         return;
     }
 
-    if (cl.getLevelMetaData(filename_, temp))
+    if (!PHYSFS_stat(filename, &stat))
     {
-        cl.ListOfMetaData.push_back(temp);
+        stat.filesize = -1;
+        stat.modtime = -1;
     }
-    else
+
+    queue_level_scan(filename, stat.filesize, stat.modtime);
+}
+
+static int level_scan_thread(void* userdata)
+{
+    extern customlevelclass cl;
+    SDL_atomic_t* next_job = (SDL_atomic_t*) userdata;
+
+    while (true)
+    {
+        const int i = SDL_AtomicAdd(next_job, 1);
+        if (i >= (int) level_scan_jobs.size())
+        {
+            break;
+        }
+
+        LevelScanJob& job = level_scan_jobs[i];
+        job.success = cl.getLevelMetaDataAndPlaytestArgs(job.filename, job.data, NULL, &job.font);
+    }
+
+    return 0;
+}
+
+/* Reads all the queued levels, spread over as many threads as there are CPUs.
+ * Each job only writes to its own slot, so no locking is needed, and the
+ * results come out in the same order no matter which thread finishes first. */
+static void run_level_scan_jobs(void)
+{
+    SDL_Thread* threads[16];
+    int num_threads = SDL_clamp(SDL_GetCPUCount(), 1, (int) SDL_arraysize(threads));
+    SDL_atomic_t next_job;
+    const Uint64 start = SDL_GetPerformanceCounter();
+
+    if (level_scan_jobs.empty())
+    {
+        return;
+    }
+
+    /* Not worth spinning up threads for a handful of levels */
+    num_threads = SDL_min(num_threads, (int) (level_scan_jobs.size() + 7) / 8);
+
+    SDL_AtomicSet(&next_job, 0);
+    for (int i = 1; i < num_threads; i++)
+    {
+        threads[i] = SDL_CreateThread(level_scan_thread, "level_scan", &next_job);
+    }
+    /* The main thread helps out too */
+    level_scan_thread(&next_job);
+    for (int i = 1; i < num_threads; i++)
     {
-        vlog_warn("Level %s not found :(", filename_.c_str());
+        if (threads[i] != NULL)
+        {
+            SDL_WaitThread(threads[i], NULL);
+        }
     }
+
+    vlog_debug(
+        "Read metadata of %i levels on %i threads in %.2f ms",
+        (int) level_scan_jobs.size(),
+        num_threads,
+        (SDL_GetPerformanceCounter() - start) * 1000.0 / SDL_GetPerformanceFrequency()
+    );
 }
 
 static void unloadZips(void)
 {
+    for (std::map<std::string, LevelZip>::iterator it = level_zips.begin();
+    it != level_zips.end();
+    ++it)
+    {
+        it->second.mounted = false;
+    }
+
     char** list = PHYSFS_getSearchPath();
     if (list == NULL)
     {
@@ -280,155 +735,562 @@ void customlevelclass::getDirectoryData(void)
 
     loadZips();
 
+    for (std::map<std::string, LevelMetaCacheEntry>::iterator it = level_meta_cache.begin();
+    it != level_meta_cache.end();
+    ++it)
+    {
+        it->second.seen = false;
+    }
+
+    level_scan_jobs.clear();
+
     FILESYSTEM_enumerateLevelDirFileNames(levelMetaDataCallback);
 
-    for(size_t i = 0; i < ListOfMetaData.size(); i++)
+    /* Then the levels in zips, unless a level file with the same name is in
+     * the way. Check that before queueing anything, since queueing can mount
+     * zips, and then their levels would count as files too. Zipped levels
+     * are cached by CRC instead of modification time. */
+    std::vector<const LevelZipEntry*> zipped_levels;
+    for (std::map<std::string, std::string>::const_iterator it = level_zip_index.begin();
+    it != level_zip_index.end();
+    ++it)
     {
-        for(size_t k = 0; k < ListOfMetaData.size(); k++)
+        if (FILESYSTEM_isFile(it->first.c_str()))
         {
-            if(compare_nocase(ListOfMetaData[i].title, ListOfMetaData[k].title ))
+            continue;
+        }
+
+        const LevelZip& zip = level_zips[it->second];
+        for (size_t i = 0; i < zip.levels.size(); i++)
+        {
+            if (zip.levels[i].path == it->first)
             {
-                std::swap(ListOfMetaData[i] , ListOfMetaData[k]);
+                zipped_levels.push_back(&zip.levels[i]);
+                break;
             }
         }
     }
+    for (size_t i = 0; i < zipped_levels.size(); i++)
+    {
+        const LevelZipEntry* entry = zipped_levels[i];
+        queue_level_scan(entry->path, entry->size, entry->crc32);
+    }
+
+    run_level_scan_jobs();
+
+    for (size_t i = 0; i < level_scan_jobs.size(); i++)
+    {
+        const LevelScanJob& job = level_scan_jobs[i];
+        if (!job.success)
+        {
+            vlog_warn("Level %s not found :(", job.filename.c_str());
+            continue;
+        }
+
+        ListOfMetaData.push_back(job.data);
+
+        LevelMetaCacheEntry entry;
+        entry.size = job.size;
+        entry.mtime = job.mtime;
+        entry.data = job.data;
+        entry.font = job.font;
+        entry.seen = true;
+        level_meta_cache[job.filename] = entry;
+        level_meta_cache_dirty = true;
+    }
+    level_scan_jobs.clear();
+
+    /* Forget about levels that are gone */
+    for (std::map<std::string, LevelMetaCacheEntry>::iterator it = level_meta_cache.begin();
+    it != level_meta_cache.end();
+    /* Increment code handled separately */)
+    {
+        if (!it->second.seen)
+        {
+            level_meta_cache.erase(it++);
+            level_meta_cache_dirty = true;
+        }
+        else
+        {
+            ++it;
+        }
+    }
+
+    if (level_meta_cache_dirty)
+    {
+        save_level_meta_cache();
+    }
+
+    /* Cached levels and freshly read ones got added separately, so sort by
+     * filename first to make ties between titles come out the same every time */
+    std::sort(ListOfMetaData.begin(), ListOfMetaData.end(), compare_filename);
+    std::stable_sort(ListOfMetaData.begin(), ListOfMetaData.end(), compare_title);
+}
+/* <MetaData> is near the start of a level file, so there's no need to read
+ * the whole thing (which is mostly room contents) just to get to it. Reads
+ * the file in growing chunks until the end of the metadata shows up. */
+static bool load_level_header(const char* path, std::string& buf)
+{
+    static const char end_tag[] = "</MetaData>";
+    PHYSFS_File* handle = PHYSFS_openRead(path);
+    size_t chunk = 4096;
+
+    buf.clear();
+    if (handle == NULL)
+    {
+        return false;
+    }
+
+    while (true)
+    {
+        const size_t old_size = buf.size();
+        buf.resize(old_size + chunk);
+        const PHYSFS_sint64 bytes_read = PHYSFS_readBytes(handle, &buf[old_size], chunk);
+        buf.resize(old_size + (bytes_read > 0 ? bytes_read : 0));
+
+        /* The end tag might straddle two chunks */
+        const size_t search_from = old_size >= sizeof(end_tag) ? old_size - sizeof(end_tag) : 0;
+        const size_t found = buf.find(end_tag, search_from);
+        if (found != std::string::npos)
+        {
+            buf.resize(found + sizeof(end_tag) - 1);
+            break;
+        }
+        if (bytes_read < (PHYSFS_sint64) chunk)
+        {
+            break;
+        }
+        chunk *= 2;
+    }
 
+    PHYSFS_close(handle);
+    return true;
 }
-bool customlevelclass::getLevelMetaDataAndPlaytestArgs(const std::string& _path, LevelMetaData& _data, CliPlaytestArgs* pt_args)
+
+bool customlevelclass::getLevelMetaDataAndPlaytestArgs(const std::string& _path, LevelMetaData& _data, CliPlaytestArgs* pt_args, std::string* font_name /*= NULL*/)
 {
-    unsigned char *uMem;
-    FILESYSTEM_loadFileToMemory(_path.c_str(), &uMem, NULL);
+    std::string buf;
+
+    if (pt_args == NULL)
+    {
+        if (!load_level_header(_path.c_str(), buf))
+        {
+            return false;
+        }
+    }
+    else
+    {
+        /* <Playtest> can be anywhere in the file */
+        unsigned char *uMem;
+        FILESYSTEM_loadFileToMemory(_path.c_str(), &uMem, NULL);
+
+        if (uMem == NULL)
+        {
+            return false;
+        }
+
+        buf = (char*) uMem;
+
+        VVV_free(uMem);
+    }
+
+    if (find_metadata(buf) == "")
+    {
+        vlog_warn("Couldn't load metadata for %s", _path.c_str());
+        return false;
+    }
+
+    _data.creator = find_creator(buf);
+    _data.creator_is_gettext = translate_creator(_data.creator);
+    _data.title = find_title(buf);
+    _data.title_is_gettext = translate_title(_data.title);
+    _data.Desc1 = find_desc1(buf);
+    _data.Desc2 = find_desc2(buf);
+    _data.Desc3 = find_desc3(buf);
+    _data.website = find_website(buf);
+    const std::string font = find_font(buf);
+    if (!font::find_main_font_by_name(font.c_str(), &_data.level_main_font_idx))
+    {
+        _data.level_main_font_idx = font::get_font_idx_8x8();
+    }
+    if (font_name != NULL)
+    {
+        *font_name = font;
+    }
+    _data.rtl = help.Int(find_rtl(buf).c_str());
+
+
+    if (pt_args != NULL)
+    {
+        const std::string playtest = find_playtest(buf);
+        if (playtest == "")
+        {
+            pt_args->valid = false;
+        }
+        else
+        {
+            pt_args->valid = true;
+            pt_args->x = help.Int(find_playx(playtest).c_str());
+            pt_args->y = help.Int(find_playy(playtest).c_str());
+            pt_args->rx = help.Int(find_playrx(playtest).c_str());
+            pt_args->ry = help.Int(find_playry(playtest).c_str());
+            pt_args->gc = help.Int(find_playgc(playtest).c_str());
+            pt_args->music = help.Int(find_playmusic(playtest).c_str());
+        }
+    }
+
+    _data.filename = _path;
+    return true;
+}
+
+bool customlevelclass::getLevelMetaData(const std::string& _path, LevelMetaData& _data)
+{
+    return getLevelMetaDataAndPlaytestArgs(_path, _data, NULL);
+}
+
+void customlevelclass::reset(void)
+{
+    version=2; //New smaller format change is 2
+
+    mapwidth=5;
+    mapheight=5;
+
+    title="Untitled Level"; // Already translatable
+    creator="Unknown";
+
+    levmusic=0;
+
+    customentities.clear();
+    levmusic=0;
+
+    for (int j = 0; j < maxheight; j++)
+    {
+        for (int i = 0; i < maxwidth; i++)
+        {
+            roomproperties[i+(j*maxwidth)].tileset=0;
+            roomproperties[i+(j*maxwidth)].tilecol=(i+j)%32;
+            roomproperties[i+(j*maxwidth)].roomname="";
+            roomproperties[i+(j*maxwidth)].warpdir=0;
+            roomproperties[i+(j*maxwidth)].platx1=0;
+            roomproperties[i+(j*maxwidth)].platy1=0;
+            roomproperties[i+(j*maxwidth)].platx2=320;
+            roomproperties[i+(j*maxwidth)].platy2=240;
+            roomproperties[i+(j*maxwidth)].platv=4;
+            roomproperties[i+(j*maxwidth)].enemyx1=0;
+            roomproperties[i+(j*maxwidth)].enemyy1=0;
+            roomproperties[i+(j*maxwidth)].enemyx2=320;
+            roomproperties[i+(j*maxwidth)].enemyy2=240;
+            roomproperties[i+(j*maxwidth)].enemytype=0;
+            roomproperties[i+(j*maxwidth)].enemyv=0;
+            roomproperties[i+(j*maxwidth)].directmode=0;
+        }
+    }
+
+    for (int i = 0; i < numrooms; i++)
+    {
+        freeroomtiles(i);
+    }
+
+    script.clearcustom();
+
+    onewaycol_override = false;
+
+    script.textbox_colours.clear();
+    script.add_default_colours();
+    map.specialroomnames.clear();
+
+    player_colour = 0;
+}
+
+const int* customlevelclass::loadlevel( int rxi, int ryi )
+{
+    //Set up our buffer array to be picked up by mapclass
+    rxi -= 100;
+    ryi -= 100;
+    if(rxi<0)rxi+=mapwidth;
+    if(ryi<0)ryi+=mapheight;
+    if(rxi>=mapwidth)rxi-=mapwidth;
+    if(ryi>=mapheight)ryi-=mapheight;
+
+    static int result[1200];
+
+    const int idx = gettileidx(rxi, ryi, 0, 0);
+    int room = 0;
+    int tile = -1;
+    if (TILE_IDX_INBOUNDS(idx))
+    {
+        split_tile_idx(idx, &room, &tile);
+    }
+
+    if (tile == 0 && ryi >= 0 && ryi < maxheight)
+    {
+        /* Straight from the compressed room, no need to cache it */
+        copyroomtiles(room, result);
+        return result;
+    }
+
+    for (int j = 0; j < 30; j++)
+    {
+        for (int i = 0; i < 40; i++)
+        {
+            result[i + j*40] = gettile(rxi, ryi, i, j);
+        }
+    }
+
+    return result;
+}
+
+static void encode_room_runs(const int* tiles, std::vector<int>& runs)
+{
+    runs.clear();
+
+    for (int i = 0; i < ROOM_TILES;)
+    {
+        int length = 1;
+        while (i + length < ROOM_TILES && tiles[i + length] == tiles[i])
+        {
+            length++;
+        }
+
+        runs.push_back(length);
+        runs.push_back(tiles[i]);
+        i += length;
+    }
+}
+
+static void decode_room_runs(const std::vector<int>& runs, int* tiles)
+{
+    int pos = 0;
+
+    for (size_t i = 0; i + 1 < runs.size(); i += 2)
+    {
+        const int end = SDL_min(pos + runs[i], ROOM_TILES);
+        while (pos < end)
+        {
+            tiles[pos++] = runs[i + 1];
+        }
+    }
+
+    while (pos < ROOM_TILES)
+    {
+        tiles[pos++] = 0;
+    }
+}
+
+static bool room_is_empty(const int* tiles)
+{
+    for (int i = 0; i < ROOM_TILES; i++)
+    {
+        if (tiles[i] != 0)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+/* Returns the decoded tiles of a room, decoding it if needed. Returns NULL for
+ * an empty room, unless `create` is set. */
+int* customlevelclass::getroomtiles(const int room, const bool create)
+{
+    RoomTiles& rt = roomtiles[room];
+
+    if (rt.tiles == NULL)
+    {
+        if (rt.runs.empty() && !create)
+        {
+            return NULL;
+        }
+
+        if (compressrooms && numdecodedrooms >= maxdecodedrooms)
+        {
+            evictroomtiles();
+        }
+
+        rt.tiles = (int*) SDL_malloc(ROOM_TILES * sizeof(int));
+        if (rt.tiles == NULL)
+        {
+            VVV_exit(1);
+        }
+        decode_room_runs(rt.runs, rt.tiles);
+        rt.dirty = false;
+        numdecodedrooms++;
+        linkroomtiles(room);
+    }
+    else if (room != newestroom)
+    {
+        unlinkroomtiles(room);
+        linkroomtiles(room);
+    }
+
+    return rt.tiles;
+}
+
+/* Puts a decoded room at the newest end of the list */
+void customlevelclass::linkroomtiles(const int room)
+{
+    RoomTiles& rt = roomtiles[room];
+
+    rt.newer = -1;
+    rt.older = newestroom;
+    if (newestroom != -1)
+    {
+        roomtiles[newestroom].newer = room;
+    }
+    else
+    {
+        oldestroom = room;
+    }
+    newestroom = room;
+}
+
+void customlevelclass::unlinkroomtiles(const int room)
+{
+    RoomTiles& rt = roomtiles[room];
+
+    if (rt.newer != -1)
+    {
+        roomtiles[rt.newer].older = rt.older;
+    }
+    else
+    {
+        newestroom = rt.older;
+    }
 
-    if (uMem == NULL)
+    if (rt.older != -1)
     {
-        return false;
+        roomtiles[rt.older].newer = rt.newer;
     }
-
-    std::string buf((char*) uMem);
-
-    VVV_free(uMem);
-
-    if (find_metadata(buf) == "")
+    else
     {
-        vlog_warn("Couldn't load metadata for %s", _path.c_str());
-        return false;
+        oldestroom = rt.newer;
     }
 
-    _data.creator = find_creator(buf);
-    _data.creator_is_gettext = translate_creator(_data.creator);
-    _data.title = find_title(buf);
-    _data.title_is_gettext = translate_title(_data.title);
-    _data.Desc1 = find_desc1(buf);
-    _data.Desc2 = find_desc2(buf);
-    _data.Desc3 = find_desc3(buf);
-    _data.website = find_website(buf);
-    if (!font::find_main_font_by_name(find_font(buf).c_str(), &_data.level_main_font_idx))
+    rt.newer = -1;
+    rt.older = -1;
+}
+
+/* Compresses the least recently used decoded room */
+void customlevelclass::evictroomtiles(void)
+{
+    const int oldest = oldestroom;
+
+    if (oldest == -1)
     {
-        _data.level_main_font_idx = font::get_font_idx_8x8();
+        return;
     }
-    _data.rtl = help.Int(find_rtl(buf).c_str());
-
 
-    if (pt_args != NULL)
+    RoomTiles& rt = roomtiles[oldest];
+    if (rt.dirty)
     {
-        const std::string playtest = find_playtest(buf);
-        if (playtest == "")
+        if (room_is_empty(rt.tiles))
         {
-            pt_args->valid = false;
+            std::vector<int>().swap(rt.runs);
         }
         else
         {
-            pt_args->valid = true;
-            pt_args->x = help.Int(find_playx(playtest).c_str());
-            pt_args->y = help.Int(find_playy(playtest).c_str());
-            pt_args->rx = help.Int(find_playrx(playtest).c_str());
-            pt_args->ry = help.Int(find_playry(playtest).c_str());
-            pt_args->gc = help.Int(find_playgc(playtest).c_str());
-            pt_args->music = help.Int(find_playmusic(playtest).c_str());
+            encode_room_runs(rt.tiles, rt.runs);
         }
     }
 
-    _data.filename = _path;
-    return true;
+    VVV_free(rt.tiles);
+    rt.dirty = false;
+    unlinkroomtiles(oldest);
+    numdecodedrooms--;
 }
 
-bool customlevelclass::getLevelMetaData(const std::string& _path, LevelMetaData& _data)
+void customlevelclass::freeroomtiles(const int room)
 {
-    return getLevelMetaDataAndPlaytestArgs(_path, _data, NULL);
+    RoomTiles& rt = roomtiles[room];
+
+    if (rt.tiles != NULL)
+    {
+        VVV_free(rt.tiles);
+        unlinkroomtiles(room);
+        numdecodedrooms--;
+    }
+
+    std::vector<int>().swap(rt.runs);
+    rt.dirty = false;
 }
 
-void customlevelclass::reset(void)
+void customlevelclass::copyroomtiles(const int room, int* out)
 {
-    version=2; //New smaller format change is 2
-
-    mapwidth=5;
-    mapheight=5;
+    const RoomTiles& rt = roomtiles[room];
 
-    title="Untitled Level"; // Already translatable
-    creator="Unknown";
+    if (rt.tiles != NULL)
+    {
+        SDL_memcpy(out, rt.tiles, ROOM_TILES * sizeof(int));
+    }
+    else
+    {
+        decode_room_runs(rt.runs, out);
+    }
+}
 
-    levmusic=0;
+void customlevelclass::setroomtiles(const int room, const int* tiles)
+{
+    RoomTiles& rt = roomtiles[room];
 
-    customentities.clear();
-    levmusic=0;
+    if (room_is_empty(tiles))
+    {
+        freeroomtiles(room);
+        return;
+    }
 
-    for (int j = 0; j < maxheight; j++)
+    if (compressrooms)
     {
-        for (int i = 0; i < maxwidth; i++)
+        /* Don't go through the cache, there's no sign it'll be used soon */
+        encode_room_runs(tiles, rt.runs);
+        if (rt.tiles != NULL)
         {
-            roomproperties[i+(j*maxwidth)].tileset=0;
-            roomproperties[i+(j*maxwidth)].tilecol=(i+j)%32;
-            roomproperties[i+(j*maxwidth)].roomname="";
-            roomproperties[i+(j*maxwidth)].warpdir=0;
-            roomproperties[i+(j*maxwidth)].platx1=0;
-            roomproperties[i+(j*maxwidth)].platy1=0;
-            roomproperties[i+(j*maxwidth)].platx2=320;
-            roomproperties[i+(j*maxwidth)].platy2=240;
-            roomproperties[i+(j*maxwidth)].platv=4;
-            roomproperties[i+(j*maxwidth)].enemyx1=0;
-            roomproperties[i+(j*maxwidth)].enemyy1=0;
-            roomproperties[i+(j*maxwidth)].enemyx2=320;
-            roomproperties[i+(j*maxwidth)].enemyy2=240;
-            roomproperties[i+(j*maxwidth)].enemytype=0;
-            roomproperties[i+(j*maxwidth)].enemyv=0;
-            roomproperties[i+(j*maxwidth)].directmode=0;
+            SDL_memcpy(rt.tiles, tiles, ROOM_TILES * sizeof(int));
+            rt.dirty = false;
         }
+        return;
     }
 
-    SDL_zeroa(contents);
-
-    script.clearcustom();
+    SDL_memcpy(getroomtiles(room, true), tiles, ROOM_TILES * sizeof(int));
+}
 
-    onewaycol_override = false;
+/* A band is a row of rooms, laid out like one row of the whole map, so that
+ * loading and saving can go through the tiles in file order. */
+void customlevelclass::loadroomband(const int band, int* out)
+{
+    int room_tiles[ROOM_TILES];
 
-    script.textbox_colours.clear();
-    script.add_default_colours();
-    map.specialroomnames.clear();
+    for (int rx = 0; rx < maxwidth; rx++)
+    {
+        copyroomtiles(rx + band*maxwidth, room_tiles);
 
-    player_colour = 0;
+        for (int y = 0; y < SCREEN_HEIGHT_TILES; y++)
+        {
+            SDL_memcpy(
+                &out[rx*SCREEN_WIDTH_TILES + VMULT(y)],
+                &room_tiles[TILE_IDX(0, y)],
+                SCREEN_WIDTH_TILES * sizeof(int)
+            );
+        }
+    }
 }
 
-const int* customlevelclass::loadlevel( int rxi, int ryi )
+void customlevelclass::storeroomband(const int band, const int* tiles)
 {
-    //Set up our buffer array to be picked up by mapclass
-    rxi -= 100;
-    ryi -= 100;
-    if(rxi<0)rxi+=mapwidth;
-    if(ryi<0)ryi+=mapheight;
-    if(rxi>=mapwidth)rxi-=mapwidth;
-    if(ryi>=mapheight)ryi-=mapheight;
-
-    static int result[1200];
+    int room_tiles[ROOM_TILES];
 
-    for (int j = 0; j < 30; j++)
+    for (int rx = 0; rx < maxwidth; rx++)
     {
-        for (int i = 0; i < 40; i++)
+        for (int y = 0; y < SCREEN_HEIGHT_TILES; y++)
         {
-            result[i + j*40] = gettile(rxi, ryi, i, j);
+            SDL_memcpy(
+                &room_tiles[TILE_IDX(0, y)],
+                &tiles[rx*SCREEN_WIDTH_TILES + VMULT(y)],
+                SCREEN_WIDTH_TILES * sizeof(int)
+            );
         }
-    }
 
-    return result;
+        setroomtiles(rx + band*maxwidth, room_tiles);
+    }
 }
 
 int customlevelclass::getlevelcol(const int tileset, const int tilecol)
@@ -817,13 +1679,25 @@ void customlevelclass::settile(
     const int t
 ) {
     const int idx = gettileidx(rx, ry, x, y);
+    int room;
+    int tile;
+
+    if (!TILE_IDX_INBOUNDS(idx))
+    {
+        return;
+    }
+
+    split_tile_idx(idx, &room, &tile);
 
-    if (!INBOUNDS_ARR(idx, contents))
+    int* tiles = getroomtiles(room, t != 0);
+    if (tiles == NULL)
     {
+        /* Setting a tile in an empty room to 0, nothing to do */
         return;
     }
 
-    contents[idx] = t;
+    tiles[tile] = t;
+    roomtiles[room].dirty = true;
 }
 
 int customlevelclass::gettile(
@@ -832,14 +1706,7 @@ int customlevelclass::gettile(
     const int x,
     const int y
 ) {
-    const int idx = gettileidx(rx, ry, x, y);
-
-    if (!INBOUNDS_ARR(idx, contents))
-    {
-        return 0;
-    }
-
-    return contents[idx];
+    return gettilebyidx(gettileidx(rx, ry, x, y));
 }
 
 int customlevelclass::getabstile(const int x, const int y)
@@ -858,12 +1725,28 @@ int customlevelclass::getabstile(const int x, const int y)
 
     idx = x + yoff;
 
-    if (!INBOUNDS_ARR(idx, contents))
+    return gettilebyidx(idx);
+}
+
+int customlevelclass::gettilebyidx(const int idx)
+{
+    int room;
+    int tile;
+
+    if (!TILE_IDX_INBOUNDS(idx))
+    {
+        return 0;
+    }
+
+    split_tile_idx(idx, &room, &tile);
+
+    const int* tiles = getroomtiles(room, false);
+    if (tiles == NULL)
     {
         return 0;
     }
 
-    return contents[idx];
+    return tiles[tile];
 }
 
 
@@ -1002,22 +1885,227 @@ int customlevelclass::findwarptoken(int t)
 }
 
 
-bool customlevelclass::load(std::string _path)
+/* A level being read in the background, for load() to pick up. This reads
+ * and parses the XML, and decodes the tiles into bands of rooms, which is
+ * most of the work for a big level. Mounting assets and loading the font
+ * reload textures, so those stay on the main thread. */
+struct LevelLoadJob
 {
+    bool active;
+    std::string path;
     tinyxml2::XMLDocument doc;
-    tinyxml2::XMLHandle hDoc(&doc);
-    tinyxml2::XMLElement* pElem;
+    bool found;
+    SDL_Thread* thread;
+    SDL_atomic_t progress;
 
-    reset();
-    ed.reset();
+    /* The decoded <contents>, if it was found */
+    const tinyxml2::XMLElement* contents;
+    int contents_mapwidth;
+    std::vector<std::vector<int> > bands;
+};
+
+static LevelLoadJob level_load_job;
 
+static std::string get_level_path(const std::string& _path)
+{
     static const char *levelDir = "levels/";
     if (_path.compare(0, SDL_strlen(levelDir), levelDir) != 0)
     {
-        _path = levelDir + _path;
+        return levelDir + _path;
+    }
+    return _path;
+}
+
+/* Reading, parsing and decoding the tiles each count for a third. The first
+ * two can only be done or not, decoding goes by how far into the tiles we are */
+static void set_load_progress(LevelLoadJob* job, const int stage, const size_t done, const size_t total)
+{
+    const int percent = total > 0 ? (int) (100 * (Uint64) done / total) : 100;
+    SDL_AtomicSet(&job->progress, (stage * 100 + SDL_min(percent, 99)) / 3);
+}
+
+/* Decodes the tiles in <contents> into bands (rows of rooms), laid out the
+ * way storeroomband() takes them. Bands with no tiles in the text are left
+ * empty. If `job` is given, progress is reported as each band is reached. */
+static void decode_level_contents(
+    const char* text,
+    const int mapwidth,
+    std::vector<std::vector<int> >& bands,
+    LevelLoadJob* job
+) {
+    const size_t text_len = job != NULL ? SDL_strlen(text) : 0;
+    int x = 0;
+    int y = 0;
+    int value;
+    size_t start = 0;
+    int band = -1;
+    int* band_tiles = NULL;
+
+    bands.clear();
+    bands.resize(customlevelclass::maxheight);
+
+    while (next_split_int(&value, &start, text, ','))
+    {
+        const int idx = x + customlevelclass::maxwidth*40*y;
+
+        if (TILE_IDX_INBOUNDS(idx))
+        {
+            if (idx / BAND_TILES != band)
+            {
+                band = idx / BAND_TILES;
+                if (bands[band].empty())
+                {
+                    bands[band].resize(BAND_TILES, 0);
+                }
+                band_tiles = bands[band].data();
+
+                if (job != NULL)
+                {
+                    set_load_progress(job, 2, start, text_len);
+                }
+            }
+
+            band_tiles[idx % BAND_TILES] = value;
+        }
+
+        ++x;
+
+        if (x == mapwidth*40)
+        {
+            x = 0;
+            ++y;
+        }
+    }
+}
+
+/* Finds <contents> the way load() will, and decodes it ahead of time */
+static void decode_job_contents(LevelLoadJob* job)
+{
+    tinyxml2::XMLHandle hDoc(&job->doc);
+    int mapwidth = 5;
+
+    for (const tinyxml2::XMLElement* pElem = hDoc
+        .FirstChildElement()
+        .FirstChildElement("Data")
+        .FirstChildElement()
+        .ToElement();
+    pElem != NULL;
+    pElem = pElem->NextSiblingElement())
+    {
+        const char* pKey = pElem->Value();
+        const char* pText = pElem->GetText();
+        if (pText == NULL)
+        {
+            pText = "";
+        }
+
+        if (SDL_strcmp(pKey, "mapwidth") == 0)
+        {
+            mapwidth = help.Int(pText);
+        }
+
+        if (SDL_strcmp(pKey, "contents") == 0 && pText[0] != '\0')
+        {
+            decode_level_contents(pText, mapwidth, job->bands, job);
+            job->contents = pElem;
+            job->contents_mapwidth = mapwidth;
+            return;
+        }
+    }
+}
+
+static int SDLCALL level_load_thread(void* userdata)
+{
+    LevelLoadJob* job = (LevelLoadJob*) userdata;
+    unsigned char* mem;
+    size_t len;
+
+    FILESYSTEM_loadFileToMemory(job->path.c_str(), &mem, &len);
+
+    job->found = mem != NULL;
+    if (job->found)
+    {
+        set_load_progress(job, 1, 0, len);
+        job->doc.Parse((const char*) mem);
+        VVV_free(mem);
+
+        if (!job->doc.Error())
+        {
+            set_load_progress(job, 2, 0, len);
+            decode_job_contents(job);
+        }
+    }
+
+    SDL_AtomicSet(&job->progress, 100);
+    return 0;
+}
+
+static void wait_level_load_job(void)
+{
+    if (level_load_job.thread != NULL)
+    {
+        SDL_WaitThread(level_load_job.thread, NULL);
+        level_load_job.thread = NULL;
+    }
+}
+
+static void discard_level_load_job(void)
+{
+    wait_level_load_job();
+    level_load_job.active = false;
+    level_load_job.path.clear();
+    level_load_job.doc.Clear();
+    level_load_job.contents = NULL;
+    std::vector<std::vector<int> >().swap(level_load_job.bands);
+}
+
+void customlevelclass::startloading(const std::string& _path)
+{
+    discard_level_load_job();
+
+    level_load_job.active = true;
+    level_load_job.path = get_level_path(_path);
+    mountZipFor(level_load_job.path);
+    level_load_job.found = false;
+    level_load_job.contents = NULL;
+    SDL_AtomicSet(&level_load_job.progress, 0);
+
+    level_load_job.thread = SDL_CreateThread(
+        level_load_thread,
+        "level_load",
+        &level_load_job
+    );
+    if (level_load_job.thread == NULL)
+    {
+        vlog_warn("Could not create level loading thread, loading synchronously: %s", SDL_GetError());
+        level_load_thread(&level_load_job);
+    }
+}
+
+int customlevelclass::loadingprogress(void)
+{
+    if (!level_load_job.active)
+    {
+        return 100;
     }
 
-    FILESYSTEM_unmountAssets();
+    return SDL_AtomicGet(&level_load_job.progress);
+}
+
+bool customlevelclass::load(std::string _path)
+{
+    tinyxml2::XMLDocument local_doc;
+    tinyxml2::XMLDocument* doc = &local_doc;
+    tinyxml2::XMLHandle hDoc(doc);
+    tinyxml2::XMLElement* pElem;
+    bool found;
+
+    reset();
+    ed.reset();
+
+    _path = get_level_path(_path);
+    mountZipFor(_path);
+
     if (game.cliplaytest && game.playassets != "")
     {
         MAYBE_FAIL(FILESYSTEM_mountAssets(game.playassets.c_str()));
@@ -1027,7 +2115,21 @@ bool customlevelclass::load(std::string _path)
         MAYBE_FAIL(FILESYSTEM_mountAssets(_path.c_str()));
     }
 
-    if (!FILESYSTEM_loadTiXml2Document(_path.c_str(), doc))
+    if (level_load_job.active && level_load_job.path == _path)
+    {
+        /* Already read by startloading() */
+        wait_level_load_job();
+        found = level_load_job.found;
+        doc = &level_load_job.doc;
+        hDoc = tinyxml2::XMLHandle(doc);
+    }
+    else
+    {
+        discard_level_load_job();
+        found = FILESYSTEM_loadTiXml2Document(_path.c_str(), local_doc);
+    }
+
+    if (!found)
     {
         FILESYSTEM_setLevelDirError(
             loc::gettext("Level {path} not found"),
@@ -1037,13 +2139,13 @@ bool customlevelclass::load(std::string _path)
         goto fail;
     }
 
-    if (doc.Error())
+    if (doc->Error())
     {
         FILESYSTEM_setLevelDirError(
             loc::gettext("Error parsing {path}: {error}"),
             "path:str, error:str",
             _path.c_str(),
-            doc.ErrorStr()
+            doc->ErrorStr()
         );
         goto fail;
     }
@@ -1144,27 +2246,28 @@ bool customlevelclass::load(std::string _path)
 
         if (SDL_strcmp(pKey, "contents") == 0 && pText[0] != '\0')
         {
-            int x = 0;
-            int y = 0;
+            /* Tiles are in map order, so they're gathered a whole row of
+             * rooms at a time before going to the room storage */
+            std::vector<std::vector<int> > local_bands;
+            std::vector<std::vector<int> >* bands = &local_bands;
 
-            char buffer[16];
-            size_t start = 0;
-
-            while (next_split_s(buffer, sizeof(buffer), &start, pText, ','))
+            if (pElem == level_load_job.contents
+            && mapwidth == level_load_job.contents_mapwidth)
             {
-                const int idx = x + maxwidth*40*y;
-
-                if (INBOUNDS_ARR(idx, contents))
-                {
-                    contents[idx] = help.Int(buffer);
-                }
-
-                ++x;
+                /* Already decoded by startloading() */
+                bands = &level_load_job.bands;
+            }
+            else
+            {
+                decode_level_contents(pText, mapwidth, local_bands, NULL);
+            }
 
-                if (x == mapwidth*40)
+            for (int band = 0; band < (int) bands->size(); band++)
+            {
+                if (!(*bands)[band].empty())
                 {
-                    x = 0;
-                    ++y;
+                    storeroomband(band, (*bands)[band].data());
+                    std::vector<int>().swap((*bands)[band]);
                 }
             }
         }
@@ -1468,9 +2571,11 @@ next:
 
     version=2;
 
+    discard_level_load_job();
     return true;
 
 fail:
+    discard_level_load_job();
     return false;
 }
 
@@ -1573,15 +2678,38 @@ bool customlevelclass::save(const std::string& _path)
     xml::update_tag(data, "levmusic", levmusic);
 
     //New save format
-    std::string contentsString="";
-    for(int y = 0; y < mapheight*30; y++ )
     {
-        for(int x = 0; x < mapwidth*40; x++ )
+        const int row_width = SDL_max(mapwidth*40, 0);
+        std::vector<int> row(row_width);
+        std::vector<int> band_tiles(BAND_TILES);
+        int band = -1;
+        std::string contentsString;
+        contentsString.reserve(row_width * SDL_max(mapheight*30, 0) * 4);
+        for(int y = 0; y < mapheight*30; y++ )
         {
-            contentsString += help.String(getabstile(x, y)) + ",";
+            /* Same as getabstile(), but decodes a row of rooms at a time */
+            const int yoff = Y_INBOUNDS(y) ? VMULT(y) : 0;
+            for(int x = 0; x < row_width; x++ )
+            {
+                const int idx = x + yoff;
+
+                if (!TILE_IDX_INBOUNDS(idx))
+                {
+                    row[x] = 0;
+                    continue;
+                }
+
+                if (idx / BAND_TILES != band)
+                {
+                    band = idx / BAND_TILES;
+                    loadroomband(band, band_tiles.data());
+                }
+                row[x] = band_tiles[idx % BAND_TILES];
+            }
+            append_split_ints(contentsString, row.data(), row.size(), ',');
         }
+        xml::update_tag(data, "contents", contentsString.c_str());
     }
-    xml::update_tag(data, "contents", contentsString.c_str());
 
 
     msg = xml::update_element_delete_contents(data, "edEntities");
@@ -43,6 +43,19 @@ public:
 #undef FOREACH_PROP
 };
 
+/* The tiles of one room. Empty rooms have no tiles and no runs. */
+class RoomTiles
+{
+public:
+    RoomTiles(void);
+
+    int* tiles; /* Decoded tiles, or NULL */
+    std::vector<int> runs; /* (length, tile) pairs, only with compressrooms */
+    bool dirty; /* The decoded tiles have changed since the runs were made */
+    int newer; /* Neighbours in the list of decoded rooms, or -1 */
+    int older;
+};
+
 struct LevelMetaData
 {
     std::string title;
@@ -99,9 +112,11 @@ public:
 
     std::vector<LevelMetaData> ListOfMetaData;
 
+    /* Indexes level zips; they're only mounted by mountZipFor() */
     void loadZips(void);
+    void mountZipFor(const std::string& path);
     void getDirectoryData(void);
-    bool getLevelMetaDataAndPlaytestArgs(const std::string& filename, LevelMetaData& _data, CliPlaytestArgs* pt_args);
+    bool getLevelMetaDataAndPlaytestArgs(const std::string& filename, LevelMetaData& _data, CliPlaytestArgs* pt_args, std::string* font_name = NULL);
     bool getLevelMetaData(const std::string& filename, LevelMetaData& _data);
 
     void reset(void);
@@ -138,6 +153,10 @@ public:
     int absfree(int x, int y);
 
     bool load(std::string _path);
+    /* Reads and parses a level in the background; load() with the same
+     * path then waits for it and carries on from there */
+    void startloading(const std::string& _path);
+    int loadingprogress(void);
     bool save(const std::string& _path);
 
     void generatecustomminimap(void);
@@ -154,7 +173,27 @@ public:
 
     static const int maxwidth = 20, maxheight = 20; //Special; the physical max the engine allows
     static const int numrooms = maxwidth * maxheight;
-    int contents[40 * 30 * numrooms];
+    static const int maxdecodedrooms = 8; /* With compressrooms */
+
+    /* Tiles are stored per room, using the same indices as gettileidx().
+     * With compressrooms, rooms are run-length encoded and only a few are
+     * kept decoded at a time, which saves memory on huge maps. */
+    RoomTiles roomtiles[numrooms];
+    bool compressrooms;
+    int numdecodedrooms;
+    int newestroom; /* Ends of the list of decoded rooms, or -1 */
+    int oldestroom;
+    int* getroomtiles(const int room, const bool create);
+    void linkroomtiles(const int room);
+    void unlinkroomtiles(const int room);
+    void evictroomtiles(void);
+    void freeroomtiles(const int room);
+    void copyroomtiles(const int room, int* out);
+    void setroomtiles(const int room, const int* tiles);
+    void loadroomband(const int band, int* out);
+    void storeroomband(const int band, const int* tiles);
+    int gettilebyidx(const int idx);
+
     int numtrinkets(void);
     int numcrewmates(void);
     RoomProperty roomproperties[numrooms]; //Maxwidth*maxheight
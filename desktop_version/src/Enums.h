@@ -4,7 +4,8 @@
 enum GameGamestate
 {
 
-    GAMEMODE, TITLEMODE, MAPMODE, TELEPORTERMODE, GAMECOMPLETE,  GAMECOMPLETE2, EDITORMODE, PRELOADER
+    GAMEMODE, TITLEMODE, MAPMODE, TELEPORTERMODE, GAMECOMPLETE,  GAMECOMPLETE2, EDITORMODE, PRELOADER,
+    LOADINGMODE
 
 };
 
@@ -5,12 +5,14 @@
 #include <stdarg.h>
 #include <stdio.h>
 #include <tinyxml2.h>
+#include <vector>
 
 #include "Alloc.h"
 #include "BinaryBlob.h"
 #include "Constants.h"
 #include "Exit.h"
 #include "Graphics.h"
+#include "Hash.h"
 #include "Localization.h"
 #include "Maths.h"
 #include "Screen.h"
@@ -36,9 +38,14 @@ static int mkdir(char* path, int mode)
 #include <emscripten.h>
 #define MAX_PATH PATH_MAX
 #elif defined(__linux__) || defined(__APPLE__) || defined(__FreeBSD__) || defined(__OpenBSD__) || defined(__HAIKU__) || defined(__DragonFly__) || defined(__unix__)
+#include <fcntl.h>
 #include <limits.h>
+#include <sys/mman.h>
 #include <sys/stat.h>
+#include <unistd.h>
 #define MAX_PATH PATH_MAX
+#define VVV_HAVE_MMAP
+#define VVV_HAVE_FSYNC
 #endif
 
 static bool isInit = false;
@@ -56,6 +63,9 @@ static bool doesFontsDirExist = false;
 
 static char assetDir[MAX_PATH] = {'\0'};
 static char virtualMountPath[MAX_PATH] = {'\0'};
+static char assetSource[MAX_PATH] = {'\0'};
+static Uint64 assetFingerprint = 0;
+static unsigned int assetGeneration = 0;
 
 static int PLATFORM_getOSDirectory(char* output, const size_t output_size);
 
@@ -384,8 +394,14 @@ bool FILESYSTEM_isInit(void)
 static unsigned char* stdin_buffer = NULL;
 static size_t stdin_length = 0;
 
+#ifndef __EMSCRIPTEN__
+static bool load_pending_save(const char* name, unsigned char** mem, size_t* len);
+static void cancel_pending_save(const char* name);
+#endif
+
 void FILESYSTEM_deinit(void)
 {
+    FILESYSTEM_waitForSaves();
     if (PHYSFS_isInit())
     {
         PHYSFS_deinit();
@@ -584,6 +600,89 @@ static bool FILESYSTEM_mountAssetsFrom(const char *fname)
     }
 
     SDL_strlcpy(assetDir, path, sizeof(assetDir));
+    SDL_strlcpy(assetSource, fname, sizeof(assetSource));
+    assetGeneration++;
+    return true;
+}
+
+static Uint64 fingerprint_stat(const char* path, PHYSFS_Stat* stat)
+{
+    Uint64 hash = HASH_FNV1A64_INIT;
+
+    if (!PHYSFS_stat(path, stat))
+    {
+        return 0;
+    }
+
+    hash = hash_fnv1a64_str(hash, path);
+    hash = hash_fnv1a64(hash, &stat->filesize, sizeof(stat->filesize));
+    hash = hash_fnv1a64(hash, &stat->modtime, sizeof(stat->modtime));
+    return hash;
+}
+
+Uint64 FILESYSTEM_fingerprintFile(const char* path)
+{
+    PHYSFS_Stat stat;
+    return fingerprint_stat(path, &stat);
+}
+
+static PHYSFS_EnumerateCallbackResult fingerprintCallback(
+    void* data,
+    const char* origdir,
+    const char* filename
+) {
+    Uint64* fingerprint = (Uint64*) data;
+    char path[MAX_PATH];
+    PHYSFS_Stat stat;
+
+    SDL_snprintf(
+        path,
+        sizeof(path),
+        endsWith(origdir, "/") ? "%s%s" : "%s/%s",
+        origdir,
+        filename
+    );
+
+    /* Added up, so the order files are listed in doesn't matter */
+    const Uint64 hash = fingerprint_stat(path, &stat);
+    *fingerprint += hash;
+
+    if (hash != 0 && stat.filetype == PHYSFS_FILETYPE_DIRECTORY)
+    {
+        PHYSFS_enumerate(path, fingerprintCallback, data);
+    }
+
+    return PHYSFS_ENUM_OK;
+}
+
+/* A cheap stand-in for hashing all the contents of an asset zip or folder:
+ * the names, sizes and modification times of everything in it. Good enough
+ * to tell if anything changed on disk since it was mounted. */
+static Uint64 fingerprintAssets(const char* fname)
+{
+    PHYSFS_Stat stat;
+    Uint64 fingerprint = fingerprint_stat(fname, &stat);
+
+    if (fingerprint != 0 && stat.filetype == PHYSFS_FILETYPE_DIRECTORY)
+    {
+        PHYSFS_enumerate(fname, fingerprintCallback, &fingerprint);
+    }
+
+    return fingerprint;
+}
+
+static bool unmountAssetsNoReload(void)
+{
+    if (assetDir[0] == '\0')
+    {
+        return false;
+    }
+
+    vlog_info("Unmounting %s", assetDir);
+    PHYSFS_unmount(assetDir);
+    assetDir[0] = '\0';
+    assetSource[0] = '\0';
+    assetGeneration++;
     return true;
 }
 
@@ -609,9 +708,137 @@ void FILESYSTEM_loadZip(const char* filename)
     }
 }
 
+static Uint16 zip_u16(const unsigned char* data)
+{
+    return data[0] | (data[1] << 8);
+}
+
+static Uint32 zip_u32(const unsigned char* data)
+{
+    return data[0] | (data[1] << 8) | (data[2] << 16) | ((Uint32) data[3] << 24);
+}
+
+bool FILESYSTEM_enumerateZipEntries(
+    const char* filename,
+    void (*callback)(const ZipEntryInfo* entry, void* userdata),
+    void* userdata
+) {
+    /* End of central directory record, plus the longest possible comment */
+    static const size_t eocd_size = 22;
+    std::vector<unsigned char> tail;
+    std::vector<unsigned char> directory;
+    PHYSFS_File* file;
+    PHYSFS_sint64 length;
+    size_t tail_size;
+    const unsigned char* eocd = NULL;
+    Uint32 directory_size;
+    Uint32 directory_offset;
+    Uint16 num_entries;
+    size_t pos = 0;
+    bool success = false;
+
+    file = PHYSFS_openRead(filename);
+    if (file == NULL)
+    {
+        return false;
+    }
+
+    length = PHYSFS_fileLength(file);
+    if (length < (PHYSFS_sint64) eocd_size)
+    {
+        goto end;
+    }
+
+    tail_size = (size_t) SDL_min(length, (PHYSFS_sint64) (eocd_size + 0xFFFF));
+    tail.resize(tail_size);
+    if (!PHYSFS_seek(file, length - tail_size)
+    || PHYSFS_readBytes(file, tail.data(), tail_size) != (PHYSFS_sint64) tail_size)
+    {
+        goto end;
+    }
+
+    for (size_t i = tail_size - eocd_size + 1; i-- > 0;)
+    {
+        if (zip_u32(&tail[i]) == 0x06054b50)
+        {
+            eocd = &tail[i];
+            break;
+        }
+    }
+    if (eocd == NULL)
+    {
+        goto end;
+    }
+
+    num_entries = zip_u16(&eocd[10]);
+    directory_size = zip_u32(&eocd[12]);
+    directory_offset = zip_u32(&eocd[16]);
+    if (num_entries == 0xFFFF
+    || directory_offset == 0xFFFFFFFF
+    || (PHYSFS_sint64) directory_offset + directory_size > length)
+    {
+        /* Zip64 or garbage; leave it to PhysFS */
+        goto end;
+    }
+
+    directory.resize(directory_size);
+    if (directory_size > 0
+    && (!PHYSFS_seek(file, directory_offset)
+    || PHYSFS_readBytes(file, directory.data(), directory_size) != (PHYSFS_sint64) directory_size))
+    {
+        goto end;
+    }
+
+    for (Uint16 i = 0; i < num_entries; i++)
+    {
+        static const size_t header_size = 46;
+        char name[MAX_PATH];
+        ZipEntryInfo entry;
+
+        if (pos + header_size > directory.size()
+        || zip_u32(&directory[pos]) != 0x02014b50)
+        {
+            goto end;
+        }
+
+        const unsigned char* header = &directory[pos];
+        const Uint16 name_length = zip_u16(&header[28]);
+        const size_t record_size = header_size
+            + name_length
+            + zip_u16(&header[30])
+            + zip_u16(&header[32]);
+
+        if (pos + record_size > directory.size())
+        {
+            goto end;
+        }
+
+        const size_t copy_length = SDL_min((size_t) name_length, sizeof(name) - 1);
+        SDL_memcpy(name, &header[header_size], copy_length);
+        name[copy_length] = '\0';
+
+        entry.name = name;
+        entry.crc32 = zip_u32(&header[16]);
+        entry.size = zip_u32(&header[24]);
+        entry.offset = zip_u32(&header[42]);
+        callback(&entry, userdata);
+
+        pos += record_size;
+    }
+
+    success = true;
+
+end:
+    PHYSFS_close(file);
+    return success;
+}
+
 bool FILESYSTEM_mountAssets(const char* path)
 {
     const char* real_dir = PHYSFS_getRealDir(path);
+    char source[MAX_PATH];
+    Uint64 fingerprint;
+    bool was_mounted;
 
     if (real_dir != NULL &&
     SDL_strncmp(real_dir, "levels/", sizeof("levels/") - 1) == 0 &&
@@ -620,46 +847,64 @@ bool FILESYSTEM_mountAssets(const char* path)
         /* This is a level zip */
         vlog_info("Asset directory is .zip at %s", real_dir);
 
-        if (!FILESYSTEM_mountAssetsFrom(real_dir))
-        {
-            return false;
-        }
-
-        MAYBE_FAIL(graphics.reloadresources());
+        SDL_strlcpy(source, real_dir, sizeof(source));
     }
     else
     {
         /* If it's not a zip, look for a level folder */
         char filename[MAX_PATH];
-        char virtual_path[MAX_PATH];
 
         VVV_between(path, "levels/", filename, ".vvvvvv");
 
         SDL_snprintf(
-            virtual_path,
-            sizeof(virtual_path),
+            source,
+            sizeof(source),
             "levels/%s/",
             filename
         );
 
-        if (FILESYSTEM_exists(virtual_path))
+        if (FILESYSTEM_exists(source))
         {
-            vlog_info("Asset directory exists at %s", virtual_path);
-
-            if (!FILESYSTEM_mountAssetsFrom(virtual_path))
-            {
-                return false;
-            }
-
-            MAYBE_FAIL(graphics.reloadresources());
+            vlog_info("Asset directory exists at %s", source);
         }
         else
         {
             /* Wasn't a level zip or folder! */
             vlog_debug("Asset directory does not exist");
+            FILESYSTEM_unmountAssets();
+            return true;
         }
     }
 
+    /* Loading the same level again from the editor? Then there's no need to
+     * remount it and reload every texture, as long as nothing changed on
+     * disk. (Going back to the menu does unmount assets, but the textures
+     * and fonts are kept by the same fingerprint, see
+     * GraphicsResources::reload() and font::load_custom().) */
+    fingerprint = fingerprintAssets(source);
+    if (assetDir[0] != '\0'
+    && SDL_strcmp(assetSource, source) == 0
+    && fingerprint == assetFingerprint)
+    {
+        vlog_info("Assets at %s are unchanged, reusing them", source);
+        return true;
+    }
+
+    /* Don't reload the default assets just to replace them right after */
+    was_mounted = unmountAssetsNoReload();
+
+    if (!FILESYSTEM_mountAssetsFrom(source))
+    {
+        if (was_mounted)
+        {
+            graphics.reloadresources();
+        }
+        return false;
+    }
+    assetFingerprint = fingerprint;
+
+    MAYBE_FAIL(graphics.reloadresources());
+
     return true;
 
 fail:
@@ -669,11 +914,8 @@ fail:
 
 void FILESYSTEM_unmountAssets(void)
 {
-    if (assetDir[0] != '\0')
+    if (unmountAssetsNoReload())
     {
-        vlog_info("Unmounting %s", assetDir);
-        PHYSFS_unmount(assetDir);
-        assetDir[0] = '\0';
         graphics.reloadresources();
     }
     else
@@ -682,6 +924,20 @@ void FILESYSTEM_unmountAssets(void)
     }
 }
 
+unsigned int FILESYSTEM_getAssetGeneration(void)
+{
+    return assetGeneration;
+}
+
+Uint64 FILESYSTEM_getAssetFingerprint(void)
+{
+    if (assetDir[0] == '\0')
+    {
+        return 0;
+    }
+    return assetFingerprint;
+}
+
 static void getMountedPath(
     char* buffer,
     const size_t buffer_size,
@@ -914,6 +1170,13 @@ void FILESYSTEM_loadFileToMemory(
         return;
     }
 
+#ifndef __EMSCRIPTEN__
+    if (load_pending_save(name, mem, len))
+    {
+        return;
+    }
+#endif
+
     handle = PHYSFS_openRead(name);
     if (handle == NULL)
     {
@@ -971,10 +1234,95 @@ void FILESYSTEM_loadAssetToMemory(
     FILESYSTEM_loadFileToMemory(path, mem, len);
 }
 
+bool FILESYSTEM_mapFile(
+    const char* name,
+    const unsigned char** mem,
+    size_t* len
+) {
+#ifdef VVV_HAVE_MMAP
+    const char* real_dir;
+    const char* mount_point;
+    const char* relative = name;
+    char path[MAX_PATH];
+    struct stat st;
+    int fd;
+    void* mapping;
+
+    if (name == NULL || mem == NULL || len == NULL)
+    {
+        return false;
+    }
+
+    /* Only files sitting in a plain directory can be mapped,
+     * anything inside an archive has to go through PhysFS. */
+    real_dir = PHYSFS_getRealDir(name);
+    if (real_dir == NULL || stat(real_dir, &st) != 0 || !S_ISDIR(st.st_mode))
+    {
+        return false;
+    }
+
+    mount_point = PHYSFS_getMountPoint(real_dir);
+    if (mount_point != NULL && SDL_strcmp(mount_point, "/") != 0)
+    {
+        const size_t mount_point_len = SDL_strlen(mount_point);
+        if (SDL_strncmp(name, mount_point, mount_point_len) != 0)
+        {
+            return false;
+        }
+        relative = &name[mount_point_len];
+    }
+
+    SDL_snprintf(path, sizeof(path), "%s/%s", real_dir, relative);
+
+    fd = open(path, O_RDONLY);
+    if (fd < 0)
+    {
+        return false;
+    }
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) || st.st_size <= 0)
+    {
+        close(fd);
+        return false;
+    }
+
+    mapping = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED)
+    {
+        vlog_warn("Could not map %s, falling back to reading it", path);
+        return false;
+    }
+
+    *mem = (const unsigned char*) mapping;
+    *len = st.st_size;
+    return true;
+#else
+    UNUSED(name);
+    UNUSED(mem);
+    UNUSED(len);
+    return false;
+#endif
+}
+
+void FILESYSTEM_unmapFile(const unsigned char* mem, const size_t len)
+{
+#ifdef VVV_HAVE_MMAP
+    if (mem != NULL)
+    {
+        munmap((void*) mem, len);
+    }
+#else
+    UNUSED(mem);
+    UNUSED(len);
+#endif
+}
+
 bool FILESYSTEM_loadBinaryBlob(binaryBlob* blob, const char* filename)
 {
     PHYSFS_sint64 size;
-    PHYSFS_File* handle;
+    PHYSFS_File* handle = NULL;
+    const unsigned char* mapping = NULL;
+    size_t mapping_size = 0;
     int valid, offset;
     size_t i;
     char path[MAX_PATH];
@@ -986,25 +1334,42 @@ bool FILESYSTEM_loadBinaryBlob(binaryBlob* blob, const char* filename)
 
     getMountedPath(path, sizeof(path), filename);
 
-    handle = PHYSFS_openRead(path);
-    if (handle == NULL)
+    /* If the blob is a loose file, point straight into a read-only mapping
+     * of it instead of copying every track onto the heap */
+    if (FILESYSTEM_mapFile(path, &mapping, &mapping_size))
     {
-        vlog_debug(
-            "Could not read binary blob %s: %s",
-            filename,
-            PHYSFS_getErrorByCode(PHYSFS_getLastErrorCode())
-        );
-        return false;
+        if (mapping_size < sizeof(blob->m_headers))
+        {
+            vlog_error("%s: File is too small to be a binary blob", filename);
+            FILESYSTEM_unmapFile(mapping, mapping_size);
+            return false;
+        }
+
+        size = mapping_size;
+        SDL_memcpy(&blob->m_headers, mapping, sizeof(blob->m_headers));
     }
+    else
+    {
+        handle = PHYSFS_openRead(path);
+        if (handle == NULL)
+        {
+            vlog_debug(
+                "Could not read binary blob %s: %s",
+                filename,
+                PHYSFS_getErrorByCode(PHYSFS_getLastErrorCode())
+            );
+            return false;
+        }
 
-    size = PHYSFS_fileLength(handle);
+        size = PHYSFS_fileLength(handle);
 
-    read_bytes(
-        filename,
-        handle,
-        &blob->m_headers,
-        sizeof(blob->m_headers)
-    );
+        read_bytes(
+            filename,
+            handle,
+            &blob->m_headers,
+            sizeof(blob->m_headers)
+        );
+    }
 
     valid = 0;
     offset = sizeof(blob->m_headers);
@@ -1053,6 +1418,17 @@ bool FILESYSTEM_loadBinaryBlob(binaryBlob* blob, const char* filename)
             );
         }
 
+        if (mapping != NULL)
+        {
+            /* Same as a short read below: keep whatever is actually there */
+            const int available = offset < size ? size - offset : 0;
+            *memblock = (char*) &mapping[offset < size ? offset : 0];
+            offset += header->size;
+            header->size = SDL_min(header->size, available);
+            valid += 1;
+            continue;
+        }
+
         PHYSFS_seek(handle, offset);
         *memblock = (char*) SDL_malloc(header->size);
         if (*memblock == NULL)
@@ -1068,13 +1444,20 @@ fail:
         header->valid = false;
     }
 
-    PHYSFS_close(handle);
+    if (handle != NULL)
+    {
+        PHYSFS_close(handle);
+    }
 
     if (valid == 0)
     {
+        FILESYSTEM_unmapFile(mapping, mapping_size);
         return false;
     }
 
+    blob->m_mapping = mapping;
+    blob->m_mapping_size = mapping_size;
+
     vlog_debug("The complete reloaded file size: %lli", size);
 
     for (i = 0; i < SDL_arraysize(blob->m_headers); ++i)
@@ -1130,6 +1513,421 @@ bool FILESYSTEM_saveTiXml2Document(const char *name, tinyxml2::XMLDocument& doc,
     return true;
 }
 
+/* Saves that happen during gameplay are handed off to a writer thread, so the
+ * game loop never has to wait on the disk. Each save is an immutable snapshot
+ * of the file contents. If a file is saved again before the previous snapshot
+ * has been written, only the newest one gets written. Files are written to a
+ * temporary file first, flushed to the disk and then renamed over the old one,
+ * so a crash or power loss leaves either the old save or the new one behind,
+ * never a truncated one. */
+#ifndef __EMSCRIPTEN__
+struct PendingSave
+{
+    char name[MAX_PATH];
+    char path[MAX_PATH]; /* Native path, resolved when the save was queued */
+    unsigned char* data;
+    size_t len;
+};
+
+static SDL_Thread* save_thread = NULL;
+static SDL_mutex* save_lock = NULL;
+static SDL_cond* save_wake = NULL;
+static SDL_cond* save_idle = NULL;
+static bool save_quit = false;
+static std::vector<struct PendingSave> save_queue;
+static struct PendingSave save_in_flight; /* data is NULL when idle */
+static SDL_atomic_t save_failed;
+static SDL_atomic_t save_failures; /* Never reset, unlike save_failed */
+
+/* Write the file and make sure it's on the disk before returning,
+ * otherwise the rename could reach the disk before the contents do. */
+static bool write_file_synced(const char* path, const unsigned char* data, const size_t len)
+{
+#if defined(_WIN32)
+    WCHAR utf16_path[MAX_PATH];
+    MultiByteToWideChar(CP_UTF8, 0, path, -1, utf16_path, MAX_PATH);
+    HANDLE file = CreateFileW(
+        utf16_path,
+        GENERIC_WRITE,
+        0,
+        NULL,
+        CREATE_ALWAYS,
+        FILE_ATTRIBUTE_NORMAL,
+        NULL
+    );
+    if (file == INVALID_HANDLE_VALUE)
+    {
+        vlog_error("Could not open %s: error %lu", path, GetLastError());
+        return false;
+    }
+    DWORD written = 0;
+    const bool success = WriteFile(file, data, (DWORD) len, &written, NULL)
+        && written == len
+        && FlushFileBuffers(file);
+    if (!success)
+    {
+        vlog_error("Could not write %s: error %lu", path, GetLastError());
+    }
+    CloseHandle(file);
+    return success;
+
+#elif defined(VVV_HAVE_FSYNC)
+    const int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0666);
+    if (fd == -1)
+    {
+        vlog_error("Could not open %s", path);
+        return false;
+    }
+    size_t written = 0;
+    while (written < len)
+    {
+        const ssize_t result = write(fd, data + written, len - written);
+        if (result <= 0)
+        {
+            break;
+        }
+        written += result;
+    }
+    const bool success = written == len && fsync(fd) == 0;
+    if (close(fd) != 0 || !success)
+    {
+        vlog_error("Could not write %s", path);
+        return false;
+    }
+    return true;
+
+#else
+    /* No way to flush, this is the best we can do */
+    SDL_RWops* rw = SDL_RWFromFile(path, "wb");
+    if (rw == NULL)
+    {
+        vlog_error("Could not open %s: %s", path, SDL_GetError());
+        return false;
+    }
+    const size_t written = SDL_RWwrite(rw, data, 1, len);
+    if (SDL_RWclose(rw) != 0 || written != len)
+    {
+        vlog_error("Could not write %s: %s", path, SDL_GetError());
+        return false;
+    }
+    return true;
+#endif
+}
+
+#ifdef VVV_HAVE_FSYNC
+/* The rename itself is only durable once the directory is flushed too */
+static void sync_parent_dir(const char* path)
+{
+    char dir[MAX_PATH];
+    SDL_strlcpy(dir, path, sizeof(dir));
+    char* slash = SDL_strrchr(dir, '/');
+    if (slash == NULL)
+    {
+        return;
+    }
+    *slash = '\0';
+
+    const int fd = open(dir[0] != '\0' ? dir : "/", O_RDONLY);
+    if (fd == -1)
+    {
+        return;
+    }
+    if (fsync(fd) != 0)
+    {
+        vlog_warn("Could not sync %s", dir);
+    }
+    close(fd);
+}
+#endif
+
+static bool write_save_atomically(const struct PendingSave* save)
+{
+    char temp_path[MAX_PATH];
+    SDL_snprintf(temp_path, sizeof(temp_path), "%s.tmp", save->path);
+
+    if (!write_file_synced(temp_path, save->data, save->len))
+    {
+        return false;
+    }
+
+#ifdef _WIN32
+    WCHAR utf16_temp[MAX_PATH];
+    WCHAR utf16_path[MAX_PATH];
+    MultiByteToWideChar(CP_UTF8, 0, temp_path, -1, utf16_temp, MAX_PATH);
+    MultiByteToWideChar(CP_UTF8, 0, save->path, -1, utf16_path, MAX_PATH);
+    if (!MoveFileExW(utf16_temp, utf16_path, MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH))
+    {
+        vlog_error("Could not replace %s: error %lu", save->path, GetLastError());
+        return false;
+    }
+#else
+    if (rename(temp_path, save->path) != 0)
+    {
+        vlog_error("Could not replace %s", save->path);
+        return false;
+    }
+#ifdef VVV_HAVE_FSYNC
+    sync_parent_dir(save->path);
+#endif
+#endif
+
+    return true;
+}
+
+static int save_thread_func(void* userdata)
+{
+    UNUSED(userdata);
+
+    SDL_LockMutex(save_lock);
+    while (true)
+    {
+        while (save_queue.empty() && !save_quit)
+        {
+            SDL_CondWait(save_wake, save_lock);
+        }
+        if (save_queue.empty())
+        {
+            break;
+        }
+
+        save_in_flight = save_queue.front();
+        save_queue.erase(save_queue.begin());
+        SDL_UnlockMutex(save_lock);
+
+        if (!write_save_atomically(&save_in_flight))
+        {
+            SDL_AtomicSet(&save_failed, 1);
+            SDL_AtomicIncRef(&save_failures);
+        }
+        else
+        {
+            vlog_debug("%s saved", save_in_flight.name);
+        }
+
+        SDL_LockMutex(save_lock);
+        VVV_free(save_in_flight.data);
+        SDL_CondBroadcast(save_idle);
+    }
+    SDL_UnlockMutex(save_lock);
+
+    return 0;
+}
+
+/* Must be called with save_lock held */
+static struct PendingSave* find_pending_save(const char* name)
+{
+    for (int i = (int) save_queue.size() - 1; i >= 0; i--)
+    {
+        if (SDL_strcmp(save_queue[i].name, name) == 0)
+        {
+            return &save_queue[i];
+        }
+    }
+    if (save_in_flight.data != NULL && SDL_strcmp(save_in_flight.name, name) == 0)
+    {
+        return &save_in_flight;
+    }
+    return NULL;
+}
+
+/* Hands out a copy of a save that hasn't hit the disk yet, if there is one */
+static bool load_pending_save(const char* name, unsigned char** mem, size_t* len)
+{
+    bool found = false;
+
+    if (save_lock == NULL)
+    {
+        return false;
+    }
+
+    SDL_LockMutex(save_lock);
+    const struct PendingSave* save = find_pending_save(name);
+    if (save != NULL)
+    {
+        *mem = (unsigned char*) SDL_malloc(save->len + 1); /* + 1 for null */
+        if (*mem == NULL)
+        {
+            VVV_exit(1);
+        }
+        SDL_memcpy(*mem, save->data, save->len);
+        (*mem)[save->len] = '\0';
+        if (len != NULL)
+        {
+            *len = save->len;
+        }
+        found = true;
+    }
+    SDL_UnlockMutex(save_lock);
+
+    return found;
+}
+
+/* Drops queued saves of a file and waits out one that's being written */
+static void cancel_pending_save(const char* name)
+{
+    if (save_lock == NULL)
+    {
+        return;
+    }
+
+    SDL_LockMutex(save_lock);
+    for (size_t i = 0; i < save_queue.size(); i++)
+    {
+        if (SDL_strcmp(save_queue[i].name, name) == 0)
+        {
+            VVV_free(save_queue[i].data);
+            save_queue.erase(save_queue.begin() + i);
+            i--;
+        }
+    }
+    while (save_in_flight.data != NULL && SDL_strcmp(save_in_flight.name, name) == 0)
+    {
+        SDL_CondWait(save_idle, save_lock);
+    }
+    SDL_UnlockMutex(save_lock);
+}
+#endif
+
+bool FILESYSTEM_saveFileAsync(const char* name, const unsigned char* data, const size_t len)
+{
+#ifdef __EMSCRIPTEN__
+    /* No threads here, and the write is only to IDBFS anyway */
+    return FILESYSTEM_saveFile(name, data, len);
+#else
+    struct PendingSave* save;
+    const char* real_dir;
+    unsigned char* copy;
+
+    if (!isInit)
+    {
+        vlog_warn("Filesystem not initialized! Not writing just to be safe.");
+        return false;
+    }
+
+    real_dir = PHYSFS_getWriteDir();
+    if (real_dir == NULL)
+    {
+        return false;
+    }
+
+    if (save_thread == NULL)
+    {
+        save_lock = SDL_CreateMutex();
+        save_wake = SDL_CreateCond();
+        save_idle = SDL_CreateCond();
+        save_quit = false;
+        SDL_zero(save_in_flight);
+        SDL_AtomicSet(&save_failed, 0);
+        save_thread = SDL_CreateThread(save_thread_func, "save_writer", NULL);
+        if (save_thread == NULL)
+        {
+            vlog_warn("Could not create save thread, saving synchronously: %s", SDL_GetError());
+            SDL_DestroyCond(save_idle);
+            SDL_DestroyCond(save_wake);
+            SDL_DestroyMutex(save_lock);
+            save_lock = NULL;
+            return FILESYSTEM_saveFile(name, data, len);
+        }
+    }
+
+    copy = (unsigned char*) SDL_malloc(len);
+    if (copy == NULL)
+    {
+        VVV_exit(1);
+    }
+    SDL_memcpy(copy, data, len);
+
+    SDL_LockMutex(save_lock);
+    save = NULL;
+    for (size_t i = 0; i < save_queue.size(); i++)
+    {
+        if (SDL_strcmp(save_queue[i].name, name) == 0)
+        {
+            save = &save_queue[i];
+            break;
+        }
+    }
+    if (save != NULL)
+    {
+        /* Not written yet, so just replace what would've been written */
+        VVV_free(save->data);
+    }
+    else
+    {
+        struct PendingSave new_save;
+        SDL_zero(new_save);
+        SDL_strlcpy(new_save.name, name, sizeof(new_save.name));
+        SDL_snprintf(new_save.path, sizeof(new_save.path), "%s%s", real_dir, name);
+        save_queue.push_back(new_save);
+        save = &save_queue.back();
+    }
+    save->data = copy;
+    save->len = len;
+    SDL_CondSignal(save_wake);
+    SDL_UnlockMutex(save_lock);
+
+    return true;
+#endif
+}
+
+bool FILESYSTEM_saveTiXml2DocumentAsync(const char* name, tinyxml2::XMLDocument& doc, bool sync /*= true*/)
+{
+#ifdef __EMSCRIPTEN__
+    return FILESYSTEM_saveTiXml2Document(name, doc, sync);
+#else
+    UNUSED(sync);
+    tinyxml2::XMLPrinter printer;
+    doc.Print(&printer);
+    return FILESYSTEM_saveFileAsync(
+        name,
+        (const unsigned char*) printer.CStr(),
+        printer.CStrSize() - 1 /* subtract one because CStrSize includes terminating null */
+    );
+#endif
+}
+
+void FILESYSTEM_waitForSaves(void)
+{
+#ifndef __EMSCRIPTEN__
+    if (save_thread == NULL)
+    {
+        return;
+    }
+
+    SDL_LockMutex(save_lock);
+    save_quit = true;
+    SDL_CondSignal(save_wake);
+    SDL_UnlockMutex(save_lock);
+    SDL_WaitThread(save_thread, NULL);
+    save_thread = NULL;
+
+    SDL_DestroyCond(save_idle);
+    SDL_DestroyCond(save_wake);
+    SDL_DestroyMutex(save_lock);
+    save_idle = NULL;
+    save_wake = NULL;
+    save_lock = NULL;
+#endif
+}
+
+bool FILESYSTEM_asyncSaveFailed(void)
+{
+#ifdef __EMSCRIPTEN__
+    return false;
+#else
+    return SDL_AtomicSet(&save_failed, 0) != 0;
+#endif
+}
+
+int FILESYSTEM_asyncSaveFailureCount(void)
+{
+#ifdef __EMSCRIPTEN__
+    return 0;
+#else
+    return SDL_AtomicGet(&save_failures);
+#endif
+}
+
 bool FILESYSTEM_loadTiXml2Document(const char *name, tinyxml2::XMLDocument& doc)
 {
     /* XMLDocument.LoadFile doesn't account for Unicode paths, PHYSFS does */
@@ -1405,6 +2203,9 @@ bool FILESYSTEM_openDirectory(const char *dname)
 
 bool FILESYSTEM_delete(const char *name)
 {
+#ifndef __EMSCRIPTEN__
+    cancel_pending_save(name);
+#endif
     return PHYSFS_delete(name) != 0;
 }
 
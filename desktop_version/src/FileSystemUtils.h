@@ -4,6 +4,7 @@
 /* Forward declaration */
 class binaryBlob;
 
+#include <SDL_stdinc.h>
 #include <stddef.h>
 
 // Forward declaration, including the entirety of tinyxml2.h across all files this file is included in is unnecessary
@@ -27,8 +28,28 @@ bool FILESYSTEM_isFile(const char* filename);
 bool FILESYSTEM_isMounted(const char* filename);
 
 void FILESYSTEM_loadZip(const char* filename);
+
+struct ZipEntryInfo
+{
+    const char* name;
+    unsigned int crc32;
+    unsigned int size; /* Uncompressed */
+    unsigned int offset; /* Of the local header */
+};
+
+/* Lists the files in a zip from its central directory, without mounting it.
+ * Returns false if the zip can't be read this way (e.g. Zip64). */
+bool FILESYSTEM_enumerateZipEntries(
+    const char* filename,
+    void (*callback)(const ZipEntryInfo* entry, void* userdata),
+    void* userdata
+);
 bool FILESYSTEM_mountAssets(const char *path);
 void FILESYSTEM_unmountAssets(void);
+/* Changes every time the mounted assets do */
+unsigned int FILESYSTEM_getAssetGeneration(void);
+/* Identifies the contents of the mounted assets, 0 if none are mounted */
+Uint64 FILESYSTEM_getAssetFingerprint(void);
 bool FILESYSTEM_isAssetMounted(const char* filename);
 bool FILESYSTEM_areAssetsInSameRealDir(const char* filenameA, const char* filenameB);
 
@@ -41,9 +62,26 @@ void FILESYSTEM_loadAssetToMemory(
     size_t* len
 );
 
+bool FILESYSTEM_mapFile(
+    const char* name,
+    const unsigned char** mem,
+    size_t* len
+);
+void FILESYSTEM_unmapFile(const unsigned char* mem, size_t len);
+
+/* A hash of the file's path, size and modification time, 0 if it's missing */
+Uint64 FILESYSTEM_fingerprintFile(const char* path);
+
 bool FILESYSTEM_loadBinaryBlob(binaryBlob* blob, const char* filename);
 
 bool FILESYSTEM_saveTiXml2Document(const char *name, tinyxml2::XMLDocument& doc, bool sync = true);
+bool FILESYSTEM_saveFileAsync(const char* name, const unsigned char* data, size_t len);
+bool FILESYSTEM_saveTiXml2DocumentAsync(const char* name, tinyxml2::XMLDocument& doc, bool sync = true);
+void FILESYSTEM_waitForSaves(void);
+bool FILESYSTEM_asyncSaveFailed(void);
+/* How many background writes have failed so far. Unlike
+ * FILESYSTEM_asyncSaveFailed(), checking this doesn't reset anything. */
+int FILESYSTEM_asyncSaveFailureCount(void);
 bool FILESYSTEM_loadTiXml2Document(const char *name, tinyxml2::XMLDocument& doc);
 bool FILESYSTEM_loadAssetTiXml2Document(const char *name, tinyxml2::XMLDocument& doc);
 
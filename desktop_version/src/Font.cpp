@@ -1,6 +1,7 @@
 #include "Font.h"
 
 #include <tinyxml2.h>
+#include <vector>
 
 #include "Alloc.h"
 #include "Constants.h"
@@ -10,7 +11,9 @@
 #include "Graphics.h"
 #include "GraphicsResources.h"
 #include "GraphicsUtil.h"
+#include "Hash.h"
 #include "Localization.h"
+#include "Screen.h"
 #include "UTF8.h"
 #include "UtilityClass.h"
 #include "Vlogging.h"
@@ -39,6 +42,23 @@ struct GlyphInfo
 #define FONT_N_PAGES 0x110
 #define FONT_PAGE_SIZE 0x1000
 
+/* Glyphs with consecutive codepoints and image positions */
+struct GlyphRange
+{
+    uint32_t start;
+    uint32_t end;
+    int image_idx;
+};
+
+/* A <special> range in the fontmeta, applied to glyphs that exist */
+struct SpecialRange
+{
+    uint32_t start;
+    uint32_t end;
+    int advance;
+    int color;
+};
+
 enum FontType
 {
     FontType_FONT,
@@ -57,7 +77,31 @@ struct Font
 
     SDL_Texture* image;
 
+    /* Where the image is in the shared atlas, if it fit */
+    bool in_atlas;
+    int atlas_x;
+    int atlas_y;
+
+    /* Glyph pages are only filled in the first time a codepoint in them is
+     * looked up, from the ranges below (see load_glyph_page) */
     GlyphInfo* glyph_page[FONT_N_PAGES];
+    bool glyph_page_loaded[FONT_N_PAGES];
+    GlyphRange* ranges;
+    size_t n_ranges;
+    size_t cap_ranges;
+    SpecialRange* specials;
+    size_t n_specials;
+    size_t cap_specials;
+    bool narrow_control_chars;
+
+    /* For 2.2-style fonts, codepoints from 0x80 up to scan_end only exist
+     * if they have pixels, which is checked in scan_surface. It's freed once
+     * every page it covers has been filled in. */
+    SDL_Surface* scan_surface;
+    uint32_t scan_end;
+    uint32_t scan_chars_per_line;
+
+    uint16_t n_pages; /* Glyph pages allocated, for the stats in the log */
 
     char fallback_key[64];
     uint8_t fallback_idx;
@@ -95,6 +139,53 @@ uint8_t font_idx_options_n = 0;
 uint8_t font_idx_options[20];
 
 static bool font_level_is_interface = false;
+
+/* Which assets fonts_custom was loaded from, see FILESYSTEM_getAssetGeneration() */
+static bool custom_fonts_loaded = false;
+static unsigned int custom_fonts_generation = 0;
+
+/* The custom fonts of the last level that was unloaded, and the fingerprint
+ * of its assets, in case the same level is loaded again */
+static FontContainer fonts_parked = {};
+static Uint64 custom_fonts_fingerprint = 0;
+static Uint64 parked_fonts_fingerprint = 0;
+
+/* The images of all loaded fonts are packed into one texture (as far as they
+ * fit), so that text mixing fonts - like button glyphs or fallback glyphs -
+ * can still be drawn from a single texture. */
+#define ATLAS_MAX_SIZE 2048
+
+static SDL_Texture* atlas_image = NULL;
+
+/* Bordered text is drawn up to nine times per glyph, so text that's printed
+ * with a border every frame (like HUD labels) gets drawn into a texture once
+ * and copied from then on. Text is only cached once it has been printed
+ * twice, so that strings that change every frame (like timers) don't keep
+ * creating textures that are never used again. */
+#define TEXT_CACHE_SIZE 32
+#define TEXT_CACHE_RECENT 64
+
+struct CachedText
+{
+    SDL_Texture* texture;
+    uint32_t flags;
+    const Font* font;
+    bool rtl;
+    bool flipmode;
+    uint8_t r, g, b;
+    std::string text;
+    int pad;
+    int w;
+    int h;
+    Uint32 last_used;
+};
+
+static CachedText text_cache[TEXT_CACHE_SIZE];
+static Uint32 text_cache_clock = 0;
+static uint32_t text_cache_recent[TEXT_CACHE_RECENT];
+static int text_cache_recent_pos = 0;
+static bool text_cache_baking = false;
+
 bool font_idx_level_is_custom = false;
 uint8_t font_idx_level = 0;
 
@@ -114,14 +205,22 @@ static void codepoint_split(
     *glyph = codepoint % FONT_PAGE_SIZE;
 }
 
+static void load_glyph_page(Font* f, short page);
+
+/* Not const, since the page the codepoint is on may be filled in first */
 static GlyphInfo* get_glyphinfo(
-    const Font* f,
+    Font* f,
     const uint32_t codepoint
 )
 {
     short page, glyph;
     codepoint_split(codepoint, &page, &glyph);
 
+    if (!f->glyph_page_loaded[page])
+    {
+        load_glyph_page(f, page);
+    }
+
     if (f->glyph_page[page] == NULL)
     {
         return NULL;
@@ -151,6 +250,7 @@ static void add_glyphinfo(
         {
             return;
         }
+        f->n_pages++;
     }
 
     f->glyph_page[page][glyph].image_idx = image_idx;
@@ -158,6 +258,176 @@ static void add_glyphinfo(
     f->glyph_page[page][glyph].flags = GLYPH_EXISTS;
 }
 
+static void add_glyph_range(
+    Font* f,
+    const uint32_t start,
+    const uint32_t end,
+    const int image_idx
+)
+{
+    if (f->n_ranges > 0)
+    {
+        // Extend the last range if this continues it (like font.txt does)
+        GlyphRange* last = &f->ranges[f->n_ranges - 1];
+        if (start == last->end + 1
+        && image_idx == last->image_idx + (int) (last->end - last->start + 1))
+        {
+            last->end = end;
+            return;
+        }
+    }
+
+    if (f->n_ranges >= f->cap_ranges)
+    {
+        const size_t new_cap = SDL_max(f->cap_ranges * 2, 16);
+        GlyphRange* new_ranges = (GlyphRange*) SDL_realloc(f->ranges, new_cap * sizeof(GlyphRange));
+        if (new_ranges == NULL)
+        {
+            return;
+        }
+        f->ranges = new_ranges;
+        f->cap_ranges = new_cap;
+    }
+
+    GlyphRange* range = &f->ranges[f->n_ranges++];
+    range->start = start;
+    range->end = end;
+    range->image_idx = image_idx;
+}
+
+static void add_special_range(
+    Font* f,
+    const uint32_t start,
+    const uint32_t end,
+    const int advance,
+    const int color
+)
+{
+    if (f->n_specials >= f->cap_specials)
+    {
+        const size_t new_cap = SDL_max(f->cap_specials * 2, 4);
+        SpecialRange* new_specials = (SpecialRange*) SDL_realloc(f->specials, new_cap * sizeof(SpecialRange));
+        if (new_specials == NULL)
+        {
+            return;
+        }
+        f->specials = new_specials;
+        f->cap_specials = new_cap;
+    }
+
+    SpecialRange* special = &f->specials[f->n_specials++];
+    special->start = start;
+    special->end = end;
+    special->advance = advance;
+    special->color = color;
+}
+
+static bool glyph_has_pixels(const Font* f, const uint32_t codepoint)
+{
+    const int glyph_x = (codepoint % f->scan_chars_per_line) * f->glyph_w;
+    const int glyph_y = (codepoint / f->scan_chars_per_line) * f->glyph_h;
+
+    for (int pixel_y = 0; pixel_y < f->glyph_h; pixel_y++)
+    {
+        for (int pixel_x = 0; pixel_x < f->glyph_w; pixel_x++)
+        {
+            if (ReadPixel(f->scan_surface, glyph_x+pixel_x, glyph_y+pixel_y).a > 0)
+            {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+static bool scan_pages_loaded(const Font* f)
+{
+    const uint32_t last_page = SDL_min((f->scan_end - 1) / FONT_PAGE_SIZE, (uint32_t) FONT_N_PAGES - 1);
+    for (uint32_t page = 0; page <= last_page; page++)
+    {
+        if (!f->glyph_page_loaded[page])
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void load_glyph_page(Font* f, const short page)
+{
+    f->glyph_page_loaded[page] = true;
+
+    const uint32_t first = page * FONT_PAGE_SIZE;
+    const uint32_t last = first + FONT_PAGE_SIZE - 1;
+
+    for (size_t i = 0; i < f->n_ranges; i++)
+    {
+        const GlyphRange* range = &f->ranges[i];
+        const uint32_t start = SDL_max(range->start, first);
+        const uint32_t end = SDL_min(range->end, last);
+        for (uint32_t codepoint = start; codepoint <= end && start <= end; codepoint++)
+        {
+            add_glyphinfo(f, codepoint, range->image_idx + (codepoint - range->start));
+        }
+    }
+
+    if (f->scan_surface != NULL && first < f->scan_end && last >= 0x80)
+    {
+        /* Only include characters with actual pixels...
+         * If the font.png is too big (normally it is) we _want_ question marks. */
+        const uint32_t end = SDL_min(f->scan_end - 1, last);
+        for (uint32_t codepoint = SDL_max(first, 0x80); codepoint <= end; codepoint++)
+        {
+            if (glyph_has_pixels(f, codepoint))
+            {
+                add_glyphinfo(f, codepoint, codepoint);
+            }
+        }
+
+        if (scan_pages_loaded(f))
+        {
+            VVV_freefunc(SDL_FreeSurface, f->scan_surface);
+        }
+    }
+
+    GlyphInfo* glyphs = f->glyph_page[page];
+    if (glyphs == NULL)
+    {
+        return;
+    }
+
+    for (size_t i = 0; i < f->n_specials; i++)
+    {
+        const SpecialRange* special = &f->specials[i];
+        const uint32_t start = SDL_max(special->start, first);
+        const uint32_t end = SDL_min(special->end, last);
+        for (uint32_t codepoint = start; codepoint <= end && start <= end; codepoint++)
+        {
+            GlyphInfo* glyph = &glyphs[codepoint - first];
+            if (special->advance >= 0 && special->advance < 256)
+            {
+                glyph->advance = special->advance;
+            }
+            if (special->color == 0)
+            {
+                glyph->flags &= ~GLYPH_COLOR;
+            }
+            else if (special->color == 1)
+            {
+                glyph->flags |= GLYPH_COLOR;
+            }
+        }
+    }
+
+    if (page == 0 && f->narrow_control_chars)
+    {
+        for (uint32_t codepoint = 0x00; codepoint < 0x20; codepoint++)
+        {
+            glyphs[codepoint].advance = 6;
+        }
+    }
+}
+
 static bool glyph_is_valid(const GlyphInfo* glyph)
 {
     return glyph->flags & GLYPH_EXISTS;
@@ -172,7 +442,7 @@ static Font* fallback_for(const Font* f)
     return &fonts_main.fonts[f->fallback_idx];
 }
 
-static GlyphInfo* find_glyphinfo(const Font* f, const uint32_t codepoint, const Font** f_glyph)
+static GlyphInfo* find_glyphinfo(Font* f, const uint32_t codepoint, const Font** f_glyph)
 {
     /* Get the GlyphInfo for a specific codepoint, or <?> or ? if it doesn't exist.
      * f_glyph may be either set to f (the main specified font) or its fallback font, if it exists.
@@ -226,7 +496,7 @@ static int get_advance_ff(const Font* f, const Font* f_glyph, const GlyphInfo* g
     return glyph->advance;
 }
 
-int get_advance(const Font* f, const uint32_t codepoint)
+int get_advance(Font* f, const uint32_t codepoint)
 {
     // Get the width of a single character in a font
     if (f == NULL)
@@ -270,6 +540,7 @@ static uint8_t load_font(FontContainer* container, const char* name)
     Font* f = &container->fonts[f_idx];
 
     vlog_info("Loading font \"%s\"...", name);
+    const Uint64 load_start = SDL_GetPerformanceCounter();
 
     char name_png[256];
     char name_txt[256];
@@ -288,6 +559,8 @@ static uint8_t load_font(FontContainer* container, const char* name)
     f->fallback_key[0] = '\0';
     f->fallback_idx_valid = false;
 
+    f->in_atlas = false;
+
     bool white_teeth = false;
 
     tinyxml2::XMLDocument doc;
@@ -334,6 +607,18 @@ static uint8_t load_font(FontContainer* container, const char* name)
 
     f->image = LoadImage(name_png, white_teeth ? TEX_COLOR : TEX_WHITE);
     SDL_zeroa(f->glyph_page);
+    SDL_zeroa(f->glyph_page_loaded);
+    f->ranges = NULL;
+    f->n_ranges = 0;
+    f->cap_ranges = 0;
+    f->specials = NULL;
+    f->n_specials = 0;
+    f->cap_specials = 0;
+    f->narrow_control_chars = false;
+    f->scan_surface = NULL;
+    f->scan_end = 0;
+    f->scan_chars_per_line = 1;
+    f->n_pages = 0;
 
     if (f->image == NULL)
     {
@@ -362,7 +647,7 @@ static uint8_t load_font(FontContainer* container, const char* name)
         while (current < end)
         {
             uint32_t codepoint = UTF8_next(&current);
-            add_glyphinfo(f, codepoint, pos);
+            add_glyph_range(f, codepoint, codepoint, pos);
             ++pos;
         }
 
@@ -385,11 +670,8 @@ static uint8_t load_font(FontContainer* container, const char* name)
                 continue;
             }
 
-            for (uint32_t codepoint = start; codepoint <= end; codepoint++)
-            {
-                add_glyphinfo(f, codepoint, pos);
-                ++pos;
-            }
+            add_glyph_range(f, start, end, pos);
+            pos += end - start + 1;
         }
         charset_loaded = true;
     }
@@ -407,38 +689,22 @@ static uint8_t load_font(FontContainer* container, const char* name)
             const uint32_t chars_per_line = temp_surface->w / f->glyph_w;
             const uint32_t max_codepoint = (temp_surface->h / f->glyph_h) * chars_per_line;
 
-            for (uint32_t codepoint = 0x00; codepoint < max_codepoint; codepoint++)
+            if (max_codepoint > 0)
             {
-                if (codepoint > 0x7F)
-                {
-                    /* Only include characters with actual pixels...
-                     * If the font.png is too big (normally it is) we _want_ question marks. */
-                    const int glyph_x = (codepoint % chars_per_line) * f->glyph_w;
-                    const int glyph_y = (codepoint / chars_per_line) * f->glyph_h;
-
-                    bool found_pixel = false;
-                    for (int pixel_y = 0; pixel_y < f->glyph_h; pixel_y++)
-                    {
-                        for (int pixel_x = 0; pixel_x < f->glyph_w; pixel_x++)
-                        {
-                            if (ReadPixel(temp_surface, glyph_x+pixel_x, glyph_y+pixel_y).a > 0)
-                            {
-                                found_pixel = true;
-                                goto no_more_pixels;
-                            }
-                        }
-                    }
-                    no_more_pixels:
-                    if (!found_pixel)
-                    {
-                        // Do not add it
-                        continue;
-                    }
-                }
-                add_glyphinfo(f, codepoint, codepoint);
+                add_glyph_range(f, 0x00, SDL_min(max_codepoint - 1, 0x7F), 0x00);
             }
 
-            VVV_freefunc(SDL_FreeSurface, temp_surface);
+            if (max_codepoint > 0x80 && chars_per_line > 0)
+            {
+                // The pixels of the rest are only checked when they're needed
+                f->scan_surface = temp_surface;
+                f->scan_end = max_codepoint;
+                f->scan_chars_per_line = chars_per_line;
+            }
+            else
+            {
+                VVV_freefunc(SDL_FreeSurface, temp_surface);
+            }
         }
     }
 
@@ -458,26 +724,7 @@ static uint8_t load_font(FontContainer* container, const char* name)
             int advance = subElem->IntAttribute("advance", -1);
             int color = subElem->IntAttribute("color", -1);
 
-            for (uint32_t codepoint = start; codepoint <= end; codepoint++)
-            {
-                GlyphInfo* glyph = get_glyphinfo(f, codepoint);
-                if (glyph == NULL)
-                {
-                    continue;
-                }
-                if (advance >= 0 && advance < 256)
-                {
-                    glyph->advance = advance;
-                }
-                if (color == 0)
-                {
-                    glyph->flags &= ~GLYPH_COLOR;
-                }
-                else if (color == 1)
-                {
-                    glyph->flags |= GLYPH_COLOR;
-                }
-            }
+            add_special_range(f, start, end, advance, color);
         }
         special_loaded = true;
     }
@@ -486,16 +733,17 @@ static uint8_t load_font(FontContainer* container, const char* name)
     {
         /* If we don't have <special>, and the font is 8x8,
          * 0x00-0x1F will be less wide because that's how it has always been. */
-        for (uint32_t codepoint = 0x00; codepoint < 0x20; codepoint++)
-        {
-            GlyphInfo* glyph = get_glyphinfo(f, codepoint);
-            if (glyph != NULL)
-            {
-                glyph->advance = 6;
-            }
-        }
+        f->narrow_control_chars = true;
     }
 
+    vlog_debug(
+        "Loaded font \"%s\" (%d glyph ranges, %d KB of image kept for finding glyphs) in %.2f ms",
+        name,
+        (int) f->n_ranges,
+        f->scan_surface != NULL ? f->scan_surface->pitch * f->scan_surface->h / 1024 : 0,
+        (SDL_GetPerformanceCounter() - load_start) * 1000.0 / SDL_GetPerformanceFrequency()
+    );
+
     return f_idx;
 }
 
@@ -649,6 +897,247 @@ static void load_font_filename(bool is_custom, const char* filename)
     }
 }
 
+struct SkylineNode
+{
+    int x;
+    int y;
+    int w;
+};
+
+static bool skyline_fit(
+    const std::vector<SkylineNode>& nodes,
+    const size_t idx,
+    const int w,
+    const int h,
+    const int atlas_w,
+    const int atlas_h,
+    int* y
+)
+{
+    // Can a w*h rectangle be placed on top of the skyline, starting at idx?
+    if (nodes[idx].x + w > atlas_w)
+    {
+        return false;
+    }
+
+    *y = nodes[idx].y;
+    int width_left = w;
+    for (size_t i = idx; width_left > 0; i++)
+    {
+        if (i >= nodes.size())
+        {
+            return false;
+        }
+        *y = SDL_max(*y, nodes[i].y);
+        if (*y + h > atlas_h)
+        {
+            return false;
+        }
+        width_left -= nodes[i].w;
+    }
+    return true;
+}
+
+static bool skyline_insert(
+    std::vector<SkylineNode>& nodes,
+    const int w,
+    const int h,
+    const int atlas_w,
+    const int atlas_h,
+    int* x,
+    int* y
+)
+{
+    /* Place a w*h rectangle as low as possible on the skyline,
+     * and raise the skyline to cover it. */
+    size_t best_idx = 0;
+    int best_top = SDL_MAX_SINT32;
+    int best_y = 0;
+    for (size_t i = 0; i < nodes.size(); i++)
+    {
+        int fit_y;
+        if (skyline_fit(nodes, i, w, h, atlas_w, atlas_h, &fit_y) && fit_y + h < best_top)
+        {
+            best_idx = i;
+            best_top = fit_y + h;
+            best_y = fit_y;
+        }
+    }
+    if (best_top == SDL_MAX_SINT32)
+    {
+        return false;
+    }
+
+    *x = nodes[best_idx].x;
+    *y = best_y;
+
+    const SkylineNode node = {*x, best_y + h, w};
+    nodes.insert(nodes.begin() + best_idx, node);
+
+    // The nodes now under the new one get cut off or removed
+    for (size_t i = best_idx + 1; i < nodes.size(); i++)
+    {
+        const int prev_end = nodes[i - 1].x + nodes[i - 1].w;
+        if (nodes[i].x >= prev_end)
+        {
+            break;
+        }
+        const int shrink = prev_end - nodes[i].x;
+        nodes[i].x += shrink;
+        nodes[i].w -= shrink;
+        if (nodes[i].w > 0)
+        {
+            break;
+        }
+        nodes.erase(nodes.begin() + i);
+        i--;
+    }
+
+    // Merge neighbours of the same height
+    for (size_t i = 0; i + 1 < nodes.size(); i++)
+    {
+        if (nodes[i].y == nodes[i + 1].y)
+        {
+            nodes[i].w += nodes[i + 1].w;
+            nodes.erase(nodes.begin() + i + 1);
+            i--;
+        }
+    }
+
+    return true;
+}
+
+void redraw_atlas(void)
+{
+    /* Copy the font images into the atlas. This also has to be redone when
+     * the renderer has thrown away the contents of target textures. */
+    if (atlas_image == NULL)
+    {
+        return;
+    }
+
+    SDL_Texture* target = SDL_GetRenderTarget(gameScreen.m_renderer);
+    graphics.set_render_target(atlas_image);
+    graphics.clear(0, 0, 0, 0);
+
+    FontContainer* containers[] = {&fonts_main, &fonts_custom};
+    for (size_t c = 0; c < SDL_arraysize(containers); c++)
+    {
+        for (uint8_t i = 0; i < containers[c]->count; i++)
+        {
+            Font* f = &containers[c]->fonts[i];
+            if (!f->in_atlas)
+            {
+                continue;
+            }
+
+            SDL_Rect dest = {f->atlas_x, f->atlas_y, 0, 0};
+            graphics.query_texture(f->image, NULL, NULL, &dest.w, &dest.h);
+            graphics.set_blendmode(f->image, SDL_BLENDMODE_NONE);
+            graphics.copy_texture(f->image, NULL, &dest);
+            graphics.set_blendmode(f->image, SDL_BLENDMODE_BLEND);
+        }
+    }
+
+    graphics.set_render_target(target);
+}
+
+static void build_atlas(void)
+{
+    VVV_freefunc(SDL_DestroyTexture, atlas_image);
+
+    SDL_RendererInfo info;
+    if (SDL_GetRendererInfo(gameScreen.m_renderer, &info) != 0)
+    {
+        return;
+    }
+    const int atlas_w = info.max_texture_width > 0 ? SDL_min(info.max_texture_width, ATLAS_MAX_SIZE) : ATLAS_MAX_SIZE;
+    const int atlas_h = info.max_texture_height > 0 ? SDL_min(info.max_texture_height, ATLAS_MAX_SIZE) : ATLAS_MAX_SIZE;
+
+    // Small fonts first, so one huge font can't push out all the others
+    std::vector<Font*> fonts;
+    FontContainer* containers[] = {&fonts_main, &fonts_custom};
+    for (size_t c = 0; c < SDL_arraysize(containers); c++)
+    {
+        for (uint8_t i = 0; i < containers[c]->count; i++)
+        {
+            Font* f = &containers[c]->fonts[i];
+            f->in_atlas = false;
+            if (f->image != NULL)
+            {
+                fonts.push_back(f);
+            }
+        }
+    }
+    for (size_t i = 1; i < fonts.size(); i++)
+    {
+        for (size_t j = i; j > 0; j--)
+        {
+            int w_a, h_a, w_b, h_b;
+            graphics.query_texture(fonts[j - 1]->image, NULL, NULL, &w_a, &h_a);
+            graphics.query_texture(fonts[j]->image, NULL, NULL, &w_b, &h_b);
+            if (w_a * h_a <= w_b * h_b)
+            {
+                break;
+            }
+            Font* temp = fonts[j - 1];
+            fonts[j - 1] = fonts[j];
+            fonts[j] = temp;
+        }
+    }
+
+    std::vector<SkylineNode> skyline;
+    const SkylineNode ground = {0, 0, atlas_w};
+    skyline.push_back(ground);
+
+    int n_packed = 0;
+    int used_h = 0;
+    for (size_t i = 0; i < fonts.size(); i++)
+    {
+        Font* f = fonts[i];
+        int w, h;
+        if (graphics.query_texture(f->image, NULL, NULL, &w, &h) != 0)
+        {
+            continue;
+        }
+        if (skyline_insert(skyline, w, h, atlas_w, atlas_h, &f->atlas_x, &f->atlas_y))
+        {
+            f->in_atlas = true;
+            n_packed++;
+            used_h = SDL_max(used_h, f->atlas_y + h);
+        }
+        else
+        {
+            vlog_info("Font \"%s\" doesn't fit in the font atlas", f->name);
+        }
+    }
+
+    if (n_packed == 0)
+    {
+        return;
+    }
+
+    atlas_image = SDL_CreateTexture(
+        gameScreen.m_renderer,
+        SDL_PIXELFORMAT_ARGB8888,
+        SDL_TEXTUREACCESS_TARGET,
+        atlas_w,
+        used_h
+    );
+    if (atlas_image == NULL)
+    {
+        vlog_error("Could not create font atlas: %s", SDL_GetError());
+        for (size_t i = 0; i < fonts.size(); i++)
+        {
+            fonts[i]->in_atlas = false;
+        }
+        return;
+    }
+    graphics.set_blendmode(atlas_image, SDL_BLENDMODE_BLEND);
+
+    redraw_atlas();
+}
+
 void load_main(void)
 {
     // Load all global fonts
@@ -684,38 +1173,98 @@ void load_main(void)
             break;
         }
     }
+
+    build_atlas();
 }
 
+static bool release_custom(void);
+
 void load_custom(const char* name)
 {
-    // Load all custom (level-specific assets) fonts
-    unload_custom();
-    EnumHandle handle = {};
-    const char* item;
-    while ((item = FILESYSTEM_enumerateAssets("graphics", &handle)) != NULL)
+    if (custom_fonts_loaded && custom_fonts_generation == FILESYSTEM_getAssetGeneration())
     {
-        load_font_filename(true, item);
+        // Same assets as last time (reloading from the editor), so the fonts haven't changed either
+        set_level_font(name);
+        return;
     }
-    FILESYSTEM_freeEnumerate(&handle);
 
-    fill_map_name_idx(&fonts_custom);
-    set_fallbacks(&fonts_custom);
+    release_custom();
+
+    const Uint64 fingerprint = FILESYSTEM_getAssetFingerprint();
+    if (fingerprint != 0 && fingerprint == parked_fonts_fingerprint)
+    {
+        // Played this level before, and the assets haven't changed since
+        vlog_debug("Reusing the custom fonts from the last time these assets were mounted");
+        fonts_custom = fonts_parked;
+        SDL_zero(fonts_parked);
+        parked_fonts_fingerprint = 0;
+    }
+    else
+    {
+        // Load all custom (level-specific assets) fonts
+        EnumHandle handle = {};
+        const char* item;
+        while ((item = FILESYSTEM_enumerateAssets("graphics", &handle)) != NULL)
+        {
+            load_font_filename(true, item);
+        }
+        FILESYSTEM_freeEnumerate(&handle);
+
+        fill_map_name_idx(&fonts_custom);
+        set_fallbacks(&fonts_custom);
+    }
+
+    custom_fonts_loaded = true;
+    custom_fonts_generation = FILESYSTEM_getAssetGeneration();
+    custom_fonts_fingerprint = fingerprint;
+
+    build_atlas();
 
     set_level_font(name);
 }
 
 void unload_font(Font* f)
 {
+    size_t bytes = f->n_pages * FONT_PAGE_SIZE * sizeof(GlyphInfo);
+    if (f->scan_surface != NULL)
+    {
+        bytes += f->scan_surface->pitch * f->scan_surface->h;
+    }
+    vlog_debug(
+        "Unloading font \"%s\", which used %d glyph pages%s (%d KB)",
+        f->name,
+        f->n_pages,
+        f->scan_surface != NULL ? " and its image for finding glyphs" : "",
+        (int) (bytes / 1024)
+    );
+
     VVV_freefunc(SDL_DestroyTexture, f->image);
 
     for (int i = 0; i < FONT_N_PAGES; i++)
     {
         VVV_free(f->glyph_page[i]);
     }
+    VVV_free(f->ranges);
+    VVV_free(f->specials);
+    VVV_freefunc(SDL_FreeSurface, f->scan_surface);
+}
+
+void clear_text_cache(void)
+{
+    for (int i = 0; i < TEXT_CACHE_SIZE; i++)
+    {
+        VVV_freefunc(SDL_DestroyTexture, text_cache[i].texture);
+        text_cache[i].text.clear();
+    }
+    SDL_zeroa(text_cache_recent);
 }
 
 void unload_font_container(FontContainer* container)
 {
+    // Cached text and layouts may point to these fonts
+    clear_text_cache();
+    clear_layout_cache();
+
     VVV_freefunc(hashmap_free, container->map_name_idx);
 
     for (uint8_t i = 0; i < container->count; i++)
@@ -727,17 +1276,53 @@ void unload_font_container(FontContainer* container)
     container->count = 0;
 }
 
+/* Stops using the custom fonts, returns true if any of them were in the atlas */
+static bool release_custom(void)
+{
+    bool in_atlas = false;
+    for (uint8_t i = 0; i < fonts_custom.count; i++)
+    {
+        in_atlas |= fonts_custom.fonts[i].in_atlas;
+        fonts_custom.fonts[i].in_atlas = false;
+    }
+
+    if (custom_fonts_loaded && custom_fonts_fingerprint != 0)
+    {
+        // Set them aside instead, in case the same level is loaded again
+        unload_font_container(&fonts_parked);
+        clear_text_cache();
+        clear_layout_cache();
+        fonts_parked = fonts_custom;
+        parked_fonts_fingerprint = custom_fonts_fingerprint;
+        SDL_zero(fonts_custom);
+    }
+    else
+    {
+        // Unload all custom fonts
+        unload_font_container(&fonts_custom);
+    }
+    custom_fonts_loaded = false;
+    custom_fonts_fingerprint = 0;
+
+    return in_atlas;
+}
+
 void unload_custom(void)
 {
-    // Unload all custom fonts
-    unload_font_container(&fonts_custom);
+    if (release_custom())
+    {
+        // Pack the main fonts again, without the gaps the custom ones leave
+        build_atlas();
+    }
 }
 
 void destroy(void)
 {
     // Unload all fonts (main and custom) for exiting
-    unload_custom();
+    release_custom();
+    unload_font_container(&fonts_parked);
     unload_font_container(&fonts_main);
+    VVV_freefunc(SDL_DestroyTexture, atlas_image);
 }
 
 static Font* container_get(FontContainer* container, uint8_t idx)
@@ -913,38 +1498,110 @@ static bool next_wrap(
     }
 }
 
-static bool next_wrap_buf(
-    Font* f,
-    char buffer[],
-    const size_t buffer_size,
-    size_t* start,
-    const char* str,
-    const int maxwidth
-) {
-    /* Get each line of wordwrapped text, writing one line at a time to a buffer.
-     * Call as follows:
-     *
-     * char buf[256];
-     * size_t start = 0;
-     * while (next_wrap_buf(font, buf, sizeof(buf), &start, "String to wordwrap", 320))
-     * {
-     *     // buf contains a line of text
-     * }
-     */
-    size_t len = 0;
-    const size_t prev_start = *start;
+/* Line breaks are the same every time the same text is wrapped with the same
+ * font and width, and textboxes and menus wrap the same text every frame,
+ * so the most recently used layouts are kept around. */
+#define LAYOUT_CACHE_SIZE 64
+
+struct WrapLine
+{
+    size_t start;
+    size_t len;
+};
+
+struct WrapLayout
+{
+    uint32_t hash;
+    const Font* font;
+    bool autowordwrap;
+    int maxwidth;
+    std::string text;
+    std::vector<WrapLine> lines;
+    int balanced_width; /* For string_wordwrap_balanced(), -1 if not known yet */
+    Uint32 last_used;
+};
 
-    const bool retval = next_wrap(f, start, &len, &str[*start], maxwidth);
+static WrapLayout layout_cache[LAYOUT_CACHE_SIZE];
+static Uint32 layout_cache_clock = 0;
 
-    if (retval)
+void clear_layout_cache(void)
+{
+    for (int i = 0; i < LAYOUT_CACHE_SIZE; i++)
     {
-        /* Like next_split_s(), don't use SDL_strlcpy() here. */
-        const size_t length = SDL_min(buffer_size - 1, len);
-        SDL_memcpy(buffer, &str[prev_start], length);
-        buffer[length] = '\0';
+        layout_cache[i].hash = 0;
+        layout_cache[i].font = NULL;
+        layout_cache[i].text.clear();
+        layout_cache[i].lines.clear();
+    }
+}
+
+static WrapLayout* get_wrap_layout(Font* f, const char* text, const int maxwidth)
+{
+    const bool autowordwrap = loc::get_langmeta()->autowordwrap;
+
+    uint32_t hash = hash_fnv1a32_str(HASH_FNV1A32_INIT, text);
+    hash = hash_fnv1a32_value(hash, (uint32_t) maxwidth);
+    if (hash == 0)
+    {
+        hash = 1;
+    }
+
+    WrapLayout* oldest = &layout_cache[0];
+    for (int i = 0; i < LAYOUT_CACHE_SIZE; i++)
+    {
+        WrapLayout* layout = &layout_cache[i];
+        if (layout->hash == hash
+        && layout->font == f
+        && layout->autowordwrap == autowordwrap
+        && layout->maxwidth == maxwidth
+        && layout->text == text)
+        {
+            layout->last_used = ++layout_cache_clock;
+            return layout;
+        }
+        if (layout->last_used < oldest->last_used)
+        {
+            oldest = layout;
+        }
     }
 
-    return retval;
+    WrapLayout* layout = oldest;
+    layout->hash = hash;
+    layout->font = f;
+    layout->autowordwrap = autowordwrap;
+    layout->maxwidth = maxwidth;
+    layout->text = text;
+    layout->lines.clear();
+    layout->balanced_width = -1;
+    layout->last_used = ++layout_cache_clock;
+
+    size_t start = 0;
+    while (true)
+    {
+        WrapLine line;
+        line.start = start;
+        if (!next_wrap(f, &start, &line.len, &text[start], maxwidth))
+        {
+            break;
+        }
+        layout->lines.push_back(line);
+    }
+
+    return layout;
+}
+
+static short count_wrap_lines(Font* f, const char* text, const int maxwidth)
+{
+    /* Like string_wordwrap() with lines, but without building the string
+     * (or filling the layout cache with widths we're only trying out) */
+    short lines = 0;
+    size_t start = 0;
+    size_t len;
+    while (next_wrap(f, &start, &len, &text[start], maxwidth))
+    {
+        lines++;
+    }
+    return SDL_max(lines, 1);
 }
 
 std::string string_wordwrap(const uint32_t flags, const std::string& s, int maxwidth, short *lines /*= NULL*/)
@@ -964,28 +1621,12 @@ std::string string_wordwrap(const uint32_t flags, const std::string& s, int maxw
     }
 
     const char* orig = s.c_str();
+    const WrapLayout* layout = get_wrap_layout(pf.font_sel, orig, maxwidth);
 
     std::string result;
-    size_t start = 0;
-    bool first = true;
-
-    while (true)
+    for (size_t i = 0; i < layout->lines.size(); i++)
     {
-        size_t len = 0;
-        const char* part = &orig[start];
-
-        const bool retval = next_wrap(pf.font_sel, &start, &len, part, maxwidth);
-
-        if (!retval)
-        {
-            return result;
-        }
-
-        if (first)
-        {
-            first = false;
-        }
-        else
+        if (i > 0)
         {
             result.push_back('\n');
 
@@ -994,8 +1635,9 @@ std::string string_wordwrap(const uint32_t flags, const std::string& s, int maxw
                 (*lines)++;
             }
         }
-        result.append(part, len);
+        result.append(&orig[layout->lines[i].start], layout->lines[i].len);
     }
+    return result;
 }
 
 std::string string_wordwrap_balanced(const uint32_t flags, const std::string& s, int maxwidth)
@@ -1010,26 +1652,35 @@ std::string string_wordwrap_balanced(const uint32_t flags, const std::string& s,
         return s;
     }
 
-    short lines;
-    string_wordwrap(flags, s, maxwidth, &lines);
+    PrintFlags pf = decode_print_flags(flags);
+    if (pf.font_sel == NULL)
+    {
+        return s;
+    }
 
-    int bestwidth = maxwidth;
-    if (lines > 1)
+    WrapLayout* layout = get_wrap_layout(pf.font_sel, s.c_str(), maxwidth);
+    if (layout->balanced_width == -1)
     {
-        for (int curlimit = maxwidth; curlimit > 1; curlimit -= 8)
-        {
-            short try_lines;
-            string_wordwrap(flags, s, curlimit, &try_lines);
+        const short lines = SDL_max((short) layout->lines.size(), 1);
 
-            if (try_lines > lines)
+        int bestwidth = maxwidth;
+        if (lines > 1)
+        {
+            for (int curlimit = maxwidth; curlimit > 1; curlimit -= 8)
             {
-                bestwidth = curlimit + 8;
-                break;
+                const short try_lines = count_wrap_lines(pf.font_sel, s.c_str(), curlimit);
+
+                if (try_lines > lines)
+                {
+                    bestwidth = curlimit + 8;
+                    break;
+                }
             }
         }
+        layout->balanced_width = bestwidth;
     }
 
-    return string_wordwrap(flags, s, bestwidth);
+    return string_wordwrap(flags, s, layout->balanced_width);
 }
 
 std::string string_unwordwrap(const std::string& s)
@@ -1090,8 +1741,177 @@ std::string string_unwordwrap(const std::string& s)
     return result;
 }
 
-static int print_char(
+/* Glyphs drawn during a print (including the border passes) are collected
+ * and drawn with one SDL_RenderGeometry call for each run of glyphs sharing a
+ * texture, instead of changing the color mod and copying for every glyph.
+ * With the atlas, that's usually one call for the whole print. */
+struct GlyphQuad
+{
+    SDL_Rect src;
+    SDL_Rect dest;
+    SDL_Color color;
+    bool flip;
+};
+
+static int glyph_batch_depth = 0;
+static SDL_Texture* glyph_batch_texture = NULL;
+static std::vector<GlyphQuad> glyph_batch;
+static std::vector<SDL_Vertex> glyph_batch_vertices;
+static std::vector<int> glyph_batch_indices;
+static bool glyph_batch_unsupported = false;
+
+static void flush_glyphs(void)
+{
+    if (glyph_batch.empty())
+    {
+        return;
+    }
+
+    SDL_Texture* texture = glyph_batch_texture;
+    int tex_w;
+    int tex_h;
+    if (graphics.query_texture(texture, NULL, NULL, &tex_w, &tex_h) != 0)
+    {
+        glyph_batch.clear();
+        return;
+    }
+
+    if (!glyph_batch_unsupported)
+    {
+        glyph_batch_vertices.clear();
+        glyph_batch_indices.clear();
+
+        for (size_t i = 0; i < glyph_batch.size(); i++)
+        {
+            const GlyphQuad& quad = glyph_batch[i];
+            const float u1 = quad.src.x / (float) tex_w;
+            const float u2 = (quad.src.x + quad.src.w) / (float) tex_w;
+            float v1 = quad.src.y / (float) tex_h;
+            float v2 = (quad.src.y + quad.src.h) / (float) tex_h;
+            if (quad.flip)
+            {
+                const float v = v1;
+                v1 = v2;
+                v2 = v;
+            }
+
+            const float x1 = quad.dest.x;
+            const float y1 = quad.dest.y;
+            const float x2 = quad.dest.x + quad.dest.w;
+            const float y2 = quad.dest.y + quad.dest.h;
+
+            const int base = (int) glyph_batch_vertices.size();
+            const SDL_Vertex corners[4] = {
+                {{x1, y1}, quad.color, {u1, v1}},
+                {{x2, y1}, quad.color, {u2, v1}},
+                {{x2, y2}, quad.color, {u2, v2}},
+                {{x1, y2}, quad.color, {u1, v2}}
+            };
+            glyph_batch_vertices.insert(glyph_batch_vertices.end(), corners, corners + 4);
+
+            const int indices[6] = {base, base + 1, base + 2, base, base + 2, base + 3};
+            glyph_batch_indices.insert(glyph_batch_indices.end(), indices, indices + 6);
+        }
+
+        if (SDL_RenderGeometry(
+            gameScreen.m_renderer,
+            texture,
+            glyph_batch_vertices.data(),
+            (int) glyph_batch_vertices.size(),
+            glyph_batch_indices.data(),
+            (int) glyph_batch_indices.size()
+        ) == 0)
+        {
+            glyph_batch.clear();
+            return;
+        }
+
+        vlog_warn("Could not draw text with SDL_RenderGeometry, drawing glyphs one by one: %s", SDL_GetError());
+        glyph_batch_unsupported = true;
+    }
+
+    for (size_t i = 0; i < glyph_batch.size(); i++)
+    {
+        const GlyphQuad& quad = glyph_batch[i];
+        graphics.set_texture_color_mod(texture, quad.color.r, quad.color.g, quad.color.b);
+        graphics.copy_texture(
+            texture,
+            &quad.src,
+            &quad.dest,
+            0,
+            NULL,
+            quad.flip ? SDL_FLIP_VERTICAL : SDL_FLIP_NONE
+        );
+    }
+    graphics.set_texture_color_mod(texture, 255, 255, 255);
+    glyph_batch.clear();
+}
+
+static void begin_glyph_batch(void)
+{
+    glyph_batch_depth++;
+}
+
+static void end_glyph_batch(void)
+{
+    glyph_batch_depth--;
+    if (glyph_batch_depth == 0)
+    {
+        flush_glyphs();
+    }
+}
+
+static void queue_glyph(
     const Font* f,
+    const int t,
+    const int x,
+    const int y,
+    const uint8_t r,
+    const uint8_t g,
+    const uint8_t b,
+    const int scale
+)
+{
+    int tex_w;
+    if (graphics.query_texture(f->image, NULL, NULL, &tex_w, NULL) != 0)
+    {
+        return;
+    }
+
+    const int width = f->glyph_w;
+    const int height = f->glyph_h;
+    SDL_Rect src = {(t % (tex_w / width)) * width, (t / (tex_w / width)) * height, width, height};
+
+    SDL_Texture* texture = f->image;
+    if (f->in_atlas && atlas_image != NULL)
+    {
+        texture = atlas_image;
+        src.x += f->atlas_x;
+        src.y += f->atlas_y;
+    }
+
+    if (texture != glyph_batch_texture)
+    {
+        flush_glyphs();
+        glyph_batch_texture = texture;
+    }
+
+    const GlyphQuad quad = {
+        src,
+        {x, y, width * scale, height * scale},
+        {r, g, b, 255},
+        graphics.flipmode
+    };
+    glyph_batch.push_back(quad);
+
+    if (glyph_batch_depth == 0)
+    {
+        flush_glyphs();
+    }
+}
+
+static int print_char(
+    Font* f,
     const uint32_t codepoint,
     int x,
     int y,
@@ -1136,16 +1956,13 @@ static int print_char(
         y += (f->glyph_h - f_glyph->glyph_h) / 2;
     }
 
-    graphics.draw_grid_tile(
-        f_glyph->image,
+    queue_glyph(
+        f_glyph,
         glyph->image_idx,
         x,
         y,
-        f_glyph->glyph_w,
-        f_glyph->glyph_h,
         r, g, b,
-        scale,
-        scale * (graphics.flipmode ? -1 : 1)
+        scale
     );
 
     return get_advance_ff(f, f_glyph, glyph) * scale;
@@ -1232,6 +2049,20 @@ bool glyph_dimensions(uint32_t flags, uint8_t* glyph_w, uint8_t* glyph_h)
     return true;
 }
 
+static int len_pf(const PrintFlags& pf, const char* text)
+{
+    int text_len = 0;
+    uint32_t codepoint;
+    while ((codepoint = UTF8_next(&text)))
+    {
+        if (!is_directional_character(codepoint) && !is_joiner(codepoint))
+        {
+            text_len += get_advance(pf.font_sel, codepoint);
+        }
+    }
+    return text_len * pf.scale;
+}
+
 int len(const uint32_t flags, const char* text)
 {
     PrintFlags pf = decode_print_flags(flags);
@@ -1241,16 +2072,50 @@ int len(const uint32_t flags, const char* text)
         text = bidi_transform(pf.rtl, text);
     }
 
-    int text_len = 0;
-    uint32_t codepoint;
-    while ((codepoint = UTF8_next(&text)))
+    return len_pf(pf, text);
+}
+
+int len_no_bidi(const uint32_t flags, const char* text)
+{
+    return len_pf(decode_print_flags(flags), text);
+}
+
+short count_lines(const uint32_t flags, const char* text, const int maxwidth)
+{
+    PrintFlags pf = decode_print_flags(flags);
+    if (pf.font_sel == NULL)
     {
-        if (!is_directional_character(codepoint) && !is_joiner(codepoint))
+        return 1;
+    }
+
+    return count_wrap_lines(pf.font_sel, text, maxwidth);
+}
+
+void load_all_glyph_pages(const uint32_t flags)
+{
+    /* Fill in every page that hasn't been used yet, of the font and its
+     * fallback, so measuring text with them doesn't change them anymore. */
+    PrintFlags pf = decode_print_flags(flags);
+    if (pf.font_sel == NULL)
+    {
+        return;
+    }
+
+    Font* f[2] = {pf.font_sel, fallback_for(pf.font_sel)};
+    for (size_t i = 0; i < SDL_arraysize(f); i++)
+    {
+        if (f[i] == NULL)
         {
-            text_len += get_advance(pf.font_sel, codepoint);
+            continue;
+        }
+        for (short page = 0; page < FONT_N_PAGES; page++)
+        {
+            if (!f[i]->glyph_page_loaded[page])
+            {
+                load_glyph_page(f[i], page);
+            }
         }
     }
-    return text_len * pf.scale;
 }
 
 int height(const uint32_t flags)
@@ -1270,6 +2135,149 @@ bool is_rtl(const uint32_t flags)
     return pf.rtl;
 }
 
+static uint32_t text_cache_hash(
+    const uint32_t flags,
+    const Font* f,
+    const bool rtl,
+    const uint8_t r,
+    const uint8_t g,
+    const uint8_t b,
+    const char* text
+)
+{
+    /* Hashes everything that makes up a cache entry.
+     * 0 is never returned, since that marks an empty slot. */
+    uint32_t hash = HASH_FNV1A32_INIT;
+    const uint32_t values[] = {
+        flags, (uint32_t) (uintptr_t) f, rtl, graphics.flipmode, r, g, b
+    };
+    for (size_t i = 0; i < SDL_arraysize(values); i++)
+    {
+        hash = hash_fnv1a32_value(hash, values[i]);
+    }
+    hash = hash_fnv1a32_str(hash, text);
+    return hash != 0 ? hash : 1;
+}
+
+static bool print_cached(
+    const uint32_t flags,
+    const PrintFlags& pf,
+    const int x,
+    const int y,
+    const char* text,
+    const uint8_t r,
+    const uint8_t g,
+    const uint8_t b
+)
+{
+    /* Draws bordered text from the text cache, adding it if it was printed
+     * recently. Returns false if the text should be drawn normally. */
+    if (text_cache_baking)
+    {
+        return false;
+    }
+
+    // x is already aligned at this point
+    const uint32_t key_flags = flags & ~PR_CEN & ~PR_RIGHT & ~PR_RTL_XFLIP;
+
+    CachedText* entry = NULL;
+    CachedText* oldest = &text_cache[0];
+    for (int i = 0; i < TEXT_CACHE_SIZE; i++)
+    {
+        CachedText* item = &text_cache[i];
+        if (item->texture != NULL
+        && item->flags == key_flags
+        && item->font == pf.font_sel
+        && item->rtl == pf.rtl
+        && item->flipmode == graphics.flipmode
+        && item->r == r && item->g == g && item->b == b
+        && item->text == text)
+        {
+            entry = item;
+            break;
+        }
+        if (item->texture == NULL
+        || (oldest->texture != NULL && item->last_used < oldest->last_used))
+        {
+            oldest = item;
+        }
+    }
+
+    if (entry == NULL)
+    {
+        const uint32_t hash = text_cache_hash(key_flags, pf.font_sel, pf.rtl, r, g, b, text);
+        bool recent = false;
+        for (int i = 0; i < TEXT_CACHE_RECENT; i++)
+        {
+            if (text_cache_recent[i] == hash)
+            {
+                recent = true;
+                break;
+            }
+        }
+        if (!recent)
+        {
+            text_cache_recent[text_cache_recent_pos] = hash;
+            text_cache_recent_pos = (text_cache_recent_pos + 1) % TEXT_CACHE_RECENT;
+            return false;
+        }
+
+        /* Leave enough room around the text for the border,
+         * fallback glyphs and larger fonts sticking out */
+        const int pad = SDL_max(pf.font_sel->glyph_w, pf.font_sel->glyph_h) * pf.scale;
+        const int w = len(key_flags, text) + pad*2;
+        const int h = pf.font_sel->glyph_h * pf.scale + pad*2;
+
+        flush_glyphs();
+
+        VVV_freefunc(SDL_DestroyTexture, oldest->texture);
+        oldest->texture = SDL_CreateTexture(
+            gameScreen.m_renderer,
+            SDL_PIXELFORMAT_ARGB8888,
+            SDL_TEXTUREACCESS_TARGET,
+            w,
+            h
+        );
+        if (oldest->texture == NULL)
+        {
+            WHINE_ONCE_ARGS(("Could not create text texture: %s", SDL_GetError()));
+            return false;
+        }
+
+        SDL_Texture* target = SDL_GetRenderTarget(gameScreen.m_renderer);
+        graphics.set_render_target(oldest->texture);
+        graphics.set_blendmode(oldest->texture, SDL_BLENDMODE_BLEND);
+        graphics.clear(0, 0, 0, 0);
+        text_cache_baking = true;
+        print(key_flags, pad, pad, text, r, g, b);
+        flush_glyphs();
+        text_cache_baking = false;
+        graphics.set_render_target(target);
+
+        entry = oldest;
+        entry->flags = key_flags;
+        entry->font = pf.font_sel;
+        entry->rtl = pf.rtl;
+        entry->flipmode = graphics.flipmode;
+        entry->r = r;
+        entry->g = g;
+        entry->b = b;
+        entry->text = text;
+        entry->pad = pad;
+        entry->w = w;
+        entry->h = h;
+    }
+
+    entry->last_used = ++text_cache_clock;
+
+    // Anything queued before this text has to be drawn before it
+    flush_glyphs();
+
+    const SDL_Rect dest = {x - entry->pad, y - entry->pad, entry->w, entry->h};
+    graphics.copy_texture(entry->texture, NULL, &dest);
+    return true;
+}
+
 void print(
     const uint32_t flags,
     int x,
@@ -1319,6 +2327,14 @@ void print(
         }
     }
 
+    if (((pf.border && !graphics.notextoutline) || pf.full_border)
+    && print_cached(flags, pf, x, y, text, r, g, b))
+    {
+        return;
+    }
+
+    begin_glyph_batch();
+
     if (pf.border && !graphics.notextoutline)
     {
         static const int offsets[4][2] = {{0,-1}, {-1,0}, {1,0}, {0,1}};
@@ -1388,6 +2404,8 @@ void print(
             pf.brightness
         );
     }
+
+    end_glyph_batch();
 }
 
 void print(
@@ -1433,6 +2451,8 @@ int print_wrap(
         maxwidth = 304;
     }
 
+    begin_glyph_batch();
+
     if (pf.border && !graphics.notextoutline && (r|g|b) != 0)
     {
         print_wrap(flags, x, y, text, 0, 0, 0, linespacing, maxwidth);
@@ -1447,22 +2467,21 @@ int print_wrap(
 
     // This could fit 64 non-BMP characters onscreen, should be plenty
     char buffer[256];
-    size_t start = 0;
+    const WrapLayout* layout = get_wrap_layout(pf.font_sel, text, maxwidth);
 
     if (graphics.flipmode)
     {
         // Correct for the height of the resulting print.
-        size_t len = 0;
-        while (next_wrap(pf.font_sel, &start, &len, &text[start], maxwidth))
-        {
-            y += linespacing;
-        }
-        y -= linespacing;
-        start = 0;
+        y += ((int) layout->lines.size() - 1) * linespacing;
     }
 
-    while (next_wrap_buf(pf.font_sel, buffer, sizeof(buffer), &start, text, maxwidth))
+    for (size_t i = 0; i < layout->lines.size(); i++)
     {
+        /* Like next_split_s(), don't use SDL_strlcpy() here. */
+        const size_t length = SDL_min(sizeof(buffer) - 1, layout->lines[i].len);
+        SDL_memcpy(buffer, &text[layout->lines[i].start], length);
+        buffer[length] = '\0';
+
         print(flags, x, y, buffer, r, g, b);
 
         if (graphics.flipmode)
@@ -1475,6 +2494,8 @@ int print_wrap(
         }
     }
 
+    end_glyph_batch();
+
     return y + linespacing;
 }
 
@@ -82,6 +82,9 @@ void load_main(void);
 void load_custom(const char* name);
 void unload_custom(void);
 void destroy(void);
+void clear_text_cache(void);
+void clear_layout_cache(void);
+void redraw_atlas(void);
 
 std::string string_wordwrap(uint32_t flags, const std::string& s, int maxwidth, short *lines = NULL);
 std::string string_wordwrap_balanced(uint32_t flags, const std::string& s, int maxwidth);
@@ -90,6 +93,13 @@ std::string string_unwordwrap(const std::string& s);
 bool glyph_dimensions(uint32_t flags, uint8_t* glyph_w, uint8_t* glyph_h);
 
 int len(uint32_t flags, const char* text);
+
+/* These can measure text from other threads, as long as load_all_glyph_pages()
+ * was called for the font first. len_no_bidi() expects the text to have
+ * already been through bidi_transform() if it needs it. */
+void load_all_glyph_pages(uint32_t flags);
+int len_no_bidi(uint32_t flags, const char* text);
+short count_lines(uint32_t flags, const char* text, int maxwidth);
 int height(uint32_t flags);
 bool is_rtl(uint32_t flags);
 
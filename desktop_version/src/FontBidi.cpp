@@ -2,8 +2,10 @@
 
 #include <SDL.h>
 #include <SheenBidi/SheenBidi.h>
+#include <string>
 
 #include "Alloc.h"
+#include "Hash.h"
 #include "UTF8.h"
 
 extern "C"
@@ -229,6 +231,22 @@ static ArabicLigature arabic_ligatures[] = {
 static hashmap* arabic_letters_map;
 static hashmap* arabic_ligatures_map;
 
+/* Visible RTL text is transformed again every frame, and the result only
+ * depends on the text and the direction, so keep the most recent results. */
+#define BIDI_CACHE_SIZE 32
+
+struct BidiCacheEntry
+{
+    uint32_t hash;
+    bool rtl;
+    std::string text;
+    std::string result;
+    Uint32 last_used;
+};
+
+static BidiCacheEntry bidi_cache[BIDI_CACHE_SIZE];
+static Uint32 bidi_cache_clock = 0;
+
 void bidi_init(void)
 {
     arabic_letters_map = hashmap_create();
@@ -258,6 +276,13 @@ void bidi_init(void)
 
 void bidi_destroy(void)
 {
+    for (int i = 0; i < BIDI_CACHE_SIZE; i++)
+    {
+        bidi_cache[i].hash = 0;
+        bidi_cache[i].text.clear();
+        bidi_cache[i].result.clear();
+    }
+
     VVV_freefunc(hashmap_free, arabic_ligatures_map);
     VVV_freefunc(hashmap_free, arabic_letters_map);
 }
@@ -318,7 +343,7 @@ bool bidi_should_transform(const bool rtl, const char* text)
     return false;
 }
 
-const char* bidi_transform(const bool rtl, const char* text)
+static const char* bidi_transform_uncached(const bool rtl, const char* text)
 {
     uint32_t utf32_in[1024];
     int n_codepoints = 0;
@@ -549,4 +574,44 @@ const char* bidi_transform(const bool rtl, const char* text)
     return utf8_out;
 }
 
+const char* bidi_transform(const bool rtl, const char* text)
+{
+    /* The result stays valid until the next call, like it always did
+     * with the static buffer. */
+    uint32_t hash = hash_fnv1a32_str(HASH_FNV1A32_INIT, text);
+    if (hash == 0)
+    {
+        hash = 1;
+    }
+
+    BidiCacheEntry* oldest = &bidi_cache[0];
+    for (int i = 0; i < BIDI_CACHE_SIZE; i++)
+    {
+        BidiCacheEntry* entry = &bidi_cache[i];
+        if (entry->hash == hash && entry->rtl == rtl && entry->text == text)
+        {
+            entry->last_used = ++bidi_cache_clock;
+            return entry->result.c_str();
+        }
+        if (entry->last_used < oldest->last_used)
+        {
+            oldest = entry;
+        }
+    }
+
+    const char* result = bidi_transform_uncached(rtl, text);
+    if (result == text)
+    {
+        // Nothing was transformed, so there's nothing worth keeping
+        return text;
+    }
+
+    oldest->hash = hash;
+    oldest->rtl = rtl;
+    oldest->text = text;
+    oldest->result = result;
+    oldest->last_used = ++bidi_cache_clock;
+    return oldest->result.c_str();
+}
+
 } // namespace font
@@ -6,6 +6,7 @@
 #include <string.h>
 #include <tinyxml2.h>
 
+#include "BinarySave.h"
 #include "ButtonGlyphs.h"
 #include "Constants.h"
 #include "CustomLevels.h"
@@ -125,7 +126,7 @@ static struct Game::Summary get_summary(
     struct Game::Summary summary;
     SDL_zero(summary);
 
-    if (!FILESYSTEM_loadTiXml2Document(filename, doc))
+    if (!binsave::load_document(filename, doc))
     {
         vlog_info("%s not found", savename);
         return summary;
@@ -455,6 +456,7 @@ void Game::init(void)
 #else
     checkpoint_saving = false;
 #endif
+    binarysaves = false;
 
     setdefaultcontrollerbuttons();
 }
@@ -580,6 +582,21 @@ void Game::deletecustomlevelstats(void)
 
 #define LOAD_ARRAY(ARRAY_NAME) LOAD_ARRAY_RENAME(ARRAY_NAME, ARRAY_NAME)
 
+// Same as above, but for binary saves, where the numbers are already parsed
+#define LOAD_BINARY_ARRAY_RENAME(ARRAY_NAME, DEST) \
+    if (node->type == binsave::NODE_INTS && SDL_strcmp(node->name, #ARRAY_NAME) == 0) \
+    { \
+        const Uint32 count = SDL_min(node->count, (Uint32) SDL_arraysize(DEST)); \
+        \
+        for (Uint32 i = 0; i < count; i++) \
+        { \
+            DEST[i] = binsave::get_int(*node, i); \
+        } \
+        continue; \
+    }
+
+#define LOAD_BINARY_ARRAY(ARRAY_NAME) LOAD_BINARY_ARRAY_RENAME(ARRAY_NAME, ARRAY_NAME)
+
 // This function was written by my friend Alg0rythm!
 std::string encodeXMLtag(std::string &str) {
     std::stringstream ss;
@@ -4679,6 +4696,31 @@ void Game::gethardestroom(void)
     }
 }
 
+/* unlock.vvv stays parsed in memory after loadstats(), so saving only has to
+ * patch the tags that changed instead of reparsing the whole file. Tags we
+ * don't know about are kept as-is. */
+static tinyxml2::XMLDocument stats_doc;
+static tinyxml2::XMLPrinter stats_printer;
+static std::string stats_last_saved;
+static int stats_save_failures = 0;
+
+/* Formats an array as the comma-separated list that's stored in unlock.vvv.
+ * The result is only valid until the next call. */
+template<typename T>
+static const char* stats_csv(const T* array, const size_t count)
+{
+    static char buffer[256];
+    size_t len = 0;
+
+    buffer[0] = '\0';
+    for (size_t i = 0; i < count && len < sizeof(buffer); i++)
+    {
+        len += SDL_snprintf(&buffer[len], sizeof(buffer) - len, "%i,", (int) array[i]);
+    }
+
+    return buffer;
+}
+
 void Game::deletestats(void)
 {
     if (!FILESYSTEM_delete("saves/unlock.vvv"))
@@ -4687,6 +4729,8 @@ void Game::deletestats(void)
     }
     else
     {
+        stats_doc.Clear();
+        stats_last_saved.clear();
         for (int i = 0; i < numunlock; i++)
         {
             unlock[i] = false;
@@ -4742,15 +4786,18 @@ static bool stats_loaded = false;
 
 void Game::loadstats(struct ScreenSettings* screen_settings)
 {
-    tinyxml2::XMLDocument doc;
+    tinyxml2::XMLDocument& doc = stats_doc;
     tinyxml2::XMLHandle hDoc(&doc);
     tinyxml2::XMLElement* pElem;
     tinyxml2::XMLElement* dataNode;
 
     stats_loaded = true;
+    stats_last_saved.clear();
 
     if (!FILESYSTEM_loadTiXml2Document("saves/unlock.vvv", doc))
     {
+        vlog_info("No unlock.vvv found. Creating new file");
+        doc.Clear();
         // Save unlock.vvv only. Maybe we have a settings.vvv laying around too,
         // and we don't want to overwrite that!
         savestats(screen_settings);
@@ -4760,6 +4807,8 @@ void Game::loadstats(struct ScreenSettings* screen_settings)
     if (doc.Error())
     {
         vlog_error("Error parsing unlock.vvv: %s", doc.ErrorStr());
+        vlog_info("Creating new unlock.vvv");
+        doc.Clear();
         return;
     }
 
@@ -5082,6 +5131,11 @@ void Game::deserializesettings(tinyxml2::XMLElement* dataNode, struct ScreenSett
         {
             checkpoint_saving = help.Int(pText);
         }
+
+        if (SDL_strcmp(pKey, "binarysaves") == 0)
+        {
+            binarysaves = help.Int(pText);
+        }
     }
 
     setdefaultcontrollerbuttons();
@@ -5098,8 +5152,7 @@ bool Game::savestats(bool sync /*= true*/)
 
 bool Game::savestats(const struct ScreenSettings* screen_settings, bool sync /*= true*/)
 {
-    tinyxml2::XMLDocument doc;
-    bool already_exists;
+    tinyxml2::XMLDocument& doc = stats_doc;
 
     if (!stats_loaded)
     {
@@ -5107,73 +5160,30 @@ bool Game::savestats(const struct ScreenSettings* screen_settings, bool sync /*=
         return false;
     }
 
-    already_exists = FILESYSTEM_loadTiXml2Document("saves/unlock.vvv", doc);
-    if (!already_exists)
+    if (doc.FirstChild() == NULL || doc.FirstChild()->ToDeclaration() == NULL)
     {
-        vlog_info("No unlock.vvv found. Creating new file");
-    }
-    else if (doc.Error())
-    {
-        vlog_error("Error parsing existing unlock.vvv: %s", doc.ErrorStr());
-        vlog_info("Creating new unlock.vvv");
+        xml::update_declaration(doc);
     }
 
-    xml::update_declaration(doc);
-
     tinyxml2::XMLElement * root = xml::update_element(doc, "Save");
 
     xml::update_comment(root, " Save file " );
 
     tinyxml2::XMLElement * dataNode = xml::update_element(root, "Data");
 
-    std::string s_unlock;
-    for(size_t i = 0; i < SDL_arraysize(unlock); i++ )
-    {
-        s_unlock += help.String(unlock[i]) + ",";
-    }
-    xml::update_tag(dataNode, "unlock", s_unlock.c_str());
+    xml::update_tag(dataNode, "unlock", stats_csv(unlock, SDL_arraysize(unlock)));
 
-    std::string s_unlocknotify;
-    for(size_t i = 0; i < SDL_arraysize(unlocknotify); i++ )
-    {
-        s_unlocknotify += help.String(unlocknotify[i]) + ",";
-    }
-    xml::update_tag(dataNode, "unlocknotify", s_unlocknotify.c_str());
+    xml::update_tag(dataNode, "unlocknotify", stats_csv(unlocknotify, SDL_arraysize(unlocknotify)));
 
-    std::string s_besttimes;
-    for(size_t i = 0; i < SDL_arraysize(besttimes); i++ )
-    {
-        s_besttimes += help.String(besttimes[i]) + ",";
-    }
-    xml::update_tag(dataNode, "besttimes", s_besttimes.c_str());
+    xml::update_tag(dataNode, "besttimes", stats_csv(besttimes, SDL_arraysize(besttimes)));
 
-    std::string s_bestframes;
-    for (size_t i = 0; i < SDL_arraysize(bestframes); i++)
-    {
-        s_bestframes += help.String(bestframes[i]) + ",";
-    }
-    xml::update_tag(dataNode, "bestframes", s_bestframes.c_str());
+    xml::update_tag(dataNode, "bestframes", stats_csv(bestframes, SDL_arraysize(bestframes)));
 
-    std::string s_besttrinkets;
-    for(size_t i = 0; i < SDL_arraysize(besttrinkets); i++ )
-    {
-        s_besttrinkets += help.String(besttrinkets[i]) + ",";
-    }
-    xml::update_tag(dataNode, "besttrinkets", s_besttrinkets.c_str());
+    xml::update_tag(dataNode, "besttrinkets", stats_csv(besttrinkets, SDL_arraysize(besttrinkets)));
 
-    std::string s_bestlives;
-    for(size_t i = 0; i < SDL_arraysize(bestlives); i++ )
-    {
-        s_bestlives += help.String(bestlives[i]) + ",";
-    }
-    xml::update_tag(dataNode, "bestlives", s_bestlives.c_str());
+    xml::update_tag(dataNode, "bestlives", stats_csv(bestlives, SDL_arraysize(bestlives)));
 
-    std::string s_bestrank;
-    for(size_t i = 0; i < SDL_arraysize(bestrank); i++ )
-    {
-        s_bestrank += help.String(bestrank[i]) + ",";
-    }
-    xml::update_tag(dataNode, "bestrank", s_bestrank.c_str());
+    xml::update_tag(dataNode, "bestrank", stats_csv(bestrank, SDL_arraysize(bestrank)));
 
     xml::update_tag(dataNode, "bestgamedeaths", bestgamedeaths);
 
@@ -5185,16 +5195,50 @@ bool Game::savestats(const struct ScreenSettings* screen_settings, bool sync /*=
 
     xml::update_tag(dataNode, ("swnrecord_" + str).c_str(), swnrecord);
 
-    std::string s_swnpatternunlock;
-    for(size_t i = 0; i < SDL_arraysize(swnpatternunlock); i++ )
+    xml::update_tag(dataNode, ("swn_" + str).c_str(), stats_csv(swnpatternunlock, SDL_arraysize(swnpatternunlock)));
+
+    serializesettings(dataNode, screen_settings);
+
+    /* The printer keeps its buffer around between saves */
+    stats_printer.ClearBuffer();
+    doc.Print(&stats_printer);
+    const size_t len = stats_printer.CStrSize() - 1; // subtract one because CStrSize includes terminating null
+
+    /* A write failed since then, so it might have been this file's */
+    const int failures = FILESYSTEM_asyncSaveFailureCount();
+    if (failures != stats_save_failures)
     {
-        s_swnpatternunlock += help.String(swnpatternunlock[i]) + ",";
+        stats_save_failures = failures;
+        stats_last_saved.clear();
     }
-    xml::update_tag(dataNode, ("swn_" + str).c_str(), s_swnpatternunlock.c_str());
 
-    serializesettings(dataNode, screen_settings);
+    if (len == stats_last_saved.size()
+    && SDL_memcmp(stats_printer.CStr(), stats_last_saved.data(), len) == 0)
+    {
+        /* Nothing changed since the last save */
+        return true;
+    }
 
-    return FILESYSTEM_saveTiXml2Document("saves/unlock.vvv", doc, sync);
+#ifdef __EMSCRIPTEN__
+    const bool saved = FILESYSTEM_saveTiXml2Document("saves/unlock.vvv", doc, sync);
+#else
+    UNUSED(sync);
+    const bool saved = FILESYSTEM_saveFileAsync(
+        "saves/unlock.vvv",
+        (const unsigned char*) stats_printer.CStr(),
+        len
+    );
+#endif
+
+    if (saved)
+    {
+        stats_last_saved.assign(stats_printer.CStr(), len);
+    }
+    else
+    {
+        stats_last_saved.clear();
+    }
+    return saved;
 }
 
 bool Game::savestatsandsettings(void)
@@ -5209,7 +5253,9 @@ bool Game::savestatsandsettings(void)
 void Game::savestatsandsettings_menu(void)
 {
     // Call Game::savestatsandsettings(), but upon failure, go to the save error screen
-    if (!savestatsandsettings() && !silence_settings_error)
+    // (writes happen in the background, so this also catches an earlier write failing)
+    const bool saved = savestatsandsettings();
+    if ((!saved || FILESYSTEM_asyncSaveFailed()) && !silence_settings_error)
     {
         createmenu(Menu::errorsavingsettings);
         map.nexttowercolour();
@@ -5351,6 +5397,8 @@ void Game::serializesettings(tinyxml2::XMLElement* dataNode, const struct Screen
     xml::update_tag(dataNode, "roomname_translator", (int) roomname_translator::enabled);
 
     xml::update_tag(dataNode, "checkpoint_saving", (int) checkpoint_saving);
+
+    xml::update_tag(dataNode, "binarysaves", (int) binarysaves);
 }
 
 static bool settings_loaded = false;
@@ -5425,7 +5473,7 @@ bool Game::savesettings(const struct ScreenSettings* screen_settings)
 
     serializesettings(dataNode, screen_settings);
 
-    return FILESYSTEM_saveTiXml2Document("saves/settings.vvv", doc);
+    return FILESYSTEM_saveTiXml2DocumentAsync("saves/settings.vvv", doc);
 }
 
 void Game::customstart(void)
@@ -5641,10 +5689,51 @@ void Game::starttrial( int t )
 
 void Game::loadquick(void)
 {
-    tinyxml2::XMLDocument doc;
-    if (!FILESYSTEM_loadTiXml2Document("saves/qsave.vvv", doc)) return;
+    loadmaingamesave("qsave.vvv");
+}
+
+void Game::loadmaingamesave(const char* savename)
+{
+    char path[64];
+    unsigned char* mem;
+    size_t len;
+    const Uint64 start = SDL_GetPerformanceCounter();
+    bool binary;
+
+    SDL_snprintf(path, sizeof(path), "saves/%s", savename);
+    FILESYSTEM_loadFileToMemory(path, &mem, &len);
+    if (mem == NULL)
+    {
+        return;
+    }
 
-    readmaingamesave("qsave.vvv", doc);
+    binary = binsave::can_read_nodes(mem, len);
+    if (binary)
+    {
+        std::vector<binsave::Node> nodes;
+        if (!binsave::parse(mem, len, nodes))
+        {
+            vlog_error("Error parsing %s", savename);
+        }
+        else
+        {
+            readmaingamesave(savename, nodes);
+        }
+    }
+    else
+    {
+        tinyxml2::XMLDocument doc;
+        binsave::parse_document(mem, len, doc);
+        readmaingamesave(savename, doc);
+    }
+    VVV_free(mem);
+
+    vlog_debug(
+        "Loaded %s (%s) in %.3f ms",
+        savename,
+        binary ? "binary" : "XML",
+        (SDL_GetPerformanceCounter() - start) * 1000.0 / SDL_GetPerformanceFrequency()
+    );
 }
 
 void Game::readmaingamesave(const char* savename, tinyxml2::XMLDocument& doc)
@@ -5680,134 +5769,177 @@ void Game::readmaingamesave(const char* savename, tinyxml2::XMLDocument& doc)
             pText = "";
         }
 
-        LOAD_ARRAY_RENAME(worldmap, map.explored)
+        readmaingamesavefield(pKey, pText);
+    }
 
-        LOAD_ARRAY_RENAME(flags, obj.flags)
+    readmaingamesavefinish();
+}
 
-        LOAD_ARRAY(crewstats)
+void Game::readmaingamesave(const char* savename, const std::vector<binsave::Node>& nodes)
+{
+    const size_t data = binsave::find_data(nodes);
+    if (data == 0)
+    {
+        vlog_error("Error parsing %s: no Data", savename);
+        return;
+    }
 
-        LOAD_ARRAY_RENAME(collect, obj.collect)
+    // Same as above
+    hardestroom_x = -1;
+    hardestroom_y = -1;
+    hardestroom_specialname = false;
+    hardestroom_finalstretch = false;
 
-        if (SDL_strcmp(pKey, "finalmode") == 0)
-        {
-            map.finalmode = help.Int(pText);
-        }
-        if (SDL_strcmp(pKey, "finalstretch") == 0)
-        {
-            map.finalstretch = help.Int(pText);
-        }
+    for (size_t i = data + 1; i < nodes[data].end; i = nodes[i].end)
+    {
+        const binsave::Node* node = &nodes[i];
+        char buffer[16];
 
-        if (SDL_strcmp(pKey, "savex") == 0)
-        {
-            savex = help.Int(pText);
-        }
-        else if (SDL_strcmp(pKey, "savey") == 0)
-        {
-            savey = help.Int(pText);
-        }
-        else if (SDL_strcmp(pKey, "saverx") == 0)
-        {
-            saverx = help.Int(pText);
-        }
-        else if (SDL_strcmp(pKey, "savery") == 0)
-        {
-            savery = help.Int(pText);
-        }
-        else if (SDL_strcmp(pKey, "savegc") == 0)
-        {
-            savegc = help.Int(pText);
-        }
-        else if (SDL_strcmp(pKey, "savedir") == 0)
-        {
-            savedir= help.Int(pText);
-        }
-        else if (SDL_strcmp(pKey, "savepoint") == 0)
-        {
-            savepoint = help.Int(pText);
-        }
-        else if (SDL_strcmp(pKey, "companion") == 0)
-        {
-            companion = help.Int(pText);
-        }
-        else if (SDL_strcmp(pKey, "lastsaved") == 0)
-        {
-            lastsaved = help.Int(pText);
-        }
-        else if (SDL_strcmp(pKey, "teleportscript") == 0)
-        {
-            teleportscript = pText;
-        }
-        else if (SDL_strcmp(pKey, "supercrewmate") == 0)
-        {
-            supercrewmate = help.Int(pText);
-        }
-        else if (SDL_strcmp(pKey, "scmprogress") == 0)
-        {
-            scmprogress = help.Int(pText);
-        }
-        else if (SDL_strcmp(pKey, "frames") == 0)
-        {
-            frames = help.Int(pText);
-        }
-        else if (SDL_strcmp(pKey, "seconds") == 0)
-        {
-            seconds = help.Int(pText);
-        }
-        else if (SDL_strcmp(pKey, "minutes") == 0)
-        {
-            minutes = help.Int(pText);
-        }
-        else if (SDL_strcmp(pKey, "hours") == 0)
-        {
-            hours = help.Int(pText);
-        }
-        else if (SDL_strcmp(pKey, "deathcounts") == 0)
-        {
-            deathcounts = help.Int(pText);
-        }
-        else if (SDL_strcmp(pKey, "totalflips") == 0)
-        {
-            totalflips = help.Int(pText);
-        }
-        else if (SDL_strcmp(pKey, "hardestroom") == 0)
-        {
-            hardestroom = pText;
-        }
-        else if (SDL_strcmp(pKey, "hardestroomdeaths") == 0)
-        {
-            hardestroomdeaths = help.Int(pText);
-        }
-        else if (SDL_strcmp(pKey, "hardestroom_x") == 0)
-        {
-            hardestroom_x = help.Int(pText);
-        }
-        else if (SDL_strcmp(pKey, "hardestroom_y") == 0)
-        {
-            hardestroom_y = help.Int(pText);
-        }
-        else if (SDL_strcmp(pKey, "hardestroom_specialname") == 0)
-        {
-            hardestroom_specialname = help.Int(pText);
-        }
-        else if (SDL_strcmp(pKey, "hardestroom_finalstretch") == 0)
-        {
-            hardestroom_finalstretch = help.Int(pText);
-        }
-        else if (SDL_strcmp(pKey, "currentsong") == 0)
-        {
-            int song = help.Int(pText);
-            if (song != -1)
-            {
-                music.play(song);
-            }
-        }
-        else if (SDL_strcmp(pKey, "showtargets") == 0)
+        LOAD_BINARY_ARRAY_RENAME(worldmap, map.explored)
+
+        LOAD_BINARY_ARRAY_RENAME(flags, obj.flags)
+
+        LOAD_BINARY_ARRAY(crewstats)
+
+        LOAD_BINARY_ARRAY_RENAME(collect, obj.collect)
+
+        readmaingamesavefield(node->name, binsave::get_text(*node, buffer, sizeof(buffer)));
+    }
+
+    readmaingamesavefinish();
+}
+
+void Game::readmaingamesavefield(const char* pKey, const char* pText)
+{
+    LOAD_ARRAY_RENAME(worldmap, map.explored)
+
+    LOAD_ARRAY_RENAME(flags, obj.flags)
+
+    LOAD_ARRAY(crewstats)
+
+    LOAD_ARRAY_RENAME(collect, obj.collect)
+
+    if (SDL_strcmp(pKey, "finalmode") == 0)
+    {
+        map.finalmode = help.Int(pText);
+    }
+    if (SDL_strcmp(pKey, "finalstretch") == 0)
+    {
+        map.finalstretch = help.Int(pText);
+    }
+
+    if (SDL_strcmp(pKey, "savex") == 0)
+    {
+        savex = help.Int(pText);
+    }
+    else if (SDL_strcmp(pKey, "savey") == 0)
+    {
+        savey = help.Int(pText);
+    }
+    else if (SDL_strcmp(pKey, "saverx") == 0)
+    {
+        saverx = help.Int(pText);
+    }
+    else if (SDL_strcmp(pKey, "savery") == 0)
+    {
+        savery = help.Int(pText);
+    }
+    else if (SDL_strcmp(pKey, "savegc") == 0)
+    {
+        savegc = help.Int(pText);
+    }
+    else if (SDL_strcmp(pKey, "savedir") == 0)
+    {
+        savedir= help.Int(pText);
+    }
+    else if (SDL_strcmp(pKey, "savepoint") == 0)
+    {
+        savepoint = help.Int(pText);
+    }
+    else if (SDL_strcmp(pKey, "companion") == 0)
+    {
+        companion = help.Int(pText);
+    }
+    else if (SDL_strcmp(pKey, "lastsaved") == 0)
+    {
+        lastsaved = help.Int(pText);
+    }
+    else if (SDL_strcmp(pKey, "teleportscript") == 0)
+    {
+        teleportscript = pText;
+    }
+    else if (SDL_strcmp(pKey, "supercrewmate") == 0)
+    {
+        supercrewmate = help.Int(pText);
+    }
+    else if (SDL_strcmp(pKey, "scmprogress") == 0)
+    {
+        scmprogress = help.Int(pText);
+    }
+    else if (SDL_strcmp(pKey, "frames") == 0)
+    {
+        frames = help.Int(pText);
+    }
+    else if (SDL_strcmp(pKey, "seconds") == 0)
+    {
+        seconds = help.Int(pText);
+    }
+    else if (SDL_strcmp(pKey, "minutes") == 0)
+    {
+        minutes = help.Int(pText);
+    }
+    else if (SDL_strcmp(pKey, "hours") == 0)
+    {
+        hours = help.Int(pText);
+    }
+    else if (SDL_strcmp(pKey, "deathcounts") == 0)
+    {
+        deathcounts = help.Int(pText);
+    }
+    else if (SDL_strcmp(pKey, "totalflips") == 0)
+    {
+        totalflips = help.Int(pText);
+    }
+    else if (SDL_strcmp(pKey, "hardestroom") == 0)
+    {
+        hardestroom = pText;
+    }
+    else if (SDL_strcmp(pKey, "hardestroomdeaths") == 0)
+    {
+        hardestroomdeaths = help.Int(pText);
+    }
+    else if (SDL_strcmp(pKey, "hardestroom_x") == 0)
+    {
+        hardestroom_x = help.Int(pText);
+    }
+    else if (SDL_strcmp(pKey, "hardestroom_y") == 0)
+    {
+        hardestroom_y = help.Int(pText);
+    }
+    else if (SDL_strcmp(pKey, "hardestroom_specialname") == 0)
+    {
+        hardestroom_specialname = help.Int(pText);
+    }
+    else if (SDL_strcmp(pKey, "hardestroom_finalstretch") == 0)
+    {
+        hardestroom_finalstretch = help.Int(pText);
+    }
+    else if (SDL_strcmp(pKey, "currentsong") == 0)
+    {
+        int song = help.Int(pText);
+        if (song != -1)
         {
-            map.showtargets = help.Int(pText);
+            music.play(song);
         }
-
     }
+    else if (SDL_strcmp(pKey, "showtargets") == 0)
+    {
+        map.showtargets = help.Int(pText);
+    }
+}
 
+void Game::readmaingamesavefinish(void)
+{
     if (map.finalmode)
     {
         map.final_colormode = false;
@@ -5825,8 +5957,6 @@ void Game::readmaingamesave(const char* savename, tinyxml2::XMLDocument& doc)
     map.showteleporters = true;
     if(obj.flags[12]) map.showtargets = true;
     if (obj.flags[42]) map.showtrinkets = true;
-
-
 }
 
 void Game::customloadquick(const std::string& savfile)
@@ -5835,6 +5965,8 @@ void Game::customloadquick(const std::string& savfile)
     tinyxml2::XMLHandle hDoc(&doc);
     tinyxml2::XMLElement* pElem;
     std::string levelfile;
+    unsigned char* mem;
+    size_t len;
 
     if (cliplaytest)
     {
@@ -5851,12 +5983,31 @@ void Game::customloadquick(const std::string& savfile)
     }
 
     levelfile = savfile.substr(7);
-    if (!FILESYSTEM_loadTiXml2Document(("saves/"+levelfile+".vvv").c_str(), doc))
+    FILESYSTEM_loadFileToMemory(("saves/"+levelfile+".vvv").c_str(), &mem, &len);
+    if (mem == NULL)
     {
         vlog_error("%s.vvv not found", levelfile.c_str());
         return;
     }
 
+    if (binsave::can_read_nodes(mem, len))
+    {
+        std::vector<binsave::Node> nodes;
+        if (!binsave::parse(mem, len, nodes))
+        {
+            vlog_error("Error parsing %s.vvv", levelfile.c_str());
+        }
+        else
+        {
+            readcustomsave(nodes);
+        }
+        VVV_free(mem);
+        return;
+    }
+
+    binsave::parse_document(mem, len, doc);
+    VVV_free(mem);
+
     if (doc.Error())
     {
         vlog_error("Error parsing %s.vvv: %s", levelfile.c_str(), doc.ErrorStr());
@@ -5884,185 +6035,7 @@ void Game::customloadquick(const std::string& savfile)
             pText = "";
         }
 
-        LOAD_ARRAY_RENAME(worldmap, map.explored)
-
-        LOAD_ARRAY_RENAME(flags, obj.flags)
-
-        LOAD_ARRAY_RENAME(moods, obj.customcrewmoods)
-
-        LOAD_ARRAY(crewstats)
-
-        LOAD_ARRAY_RENAME(collect, obj.collect)
-
-        LOAD_ARRAY_RENAME(customcollect, obj.customcollect)
-
-        if (SDL_strcmp(pKey, "finalmode") == 0)
-        {
-            map.finalmode = help.Int(pText);
-        }
-        if (SDL_strcmp(pKey, "finalstretch") == 0)
-        {
-            map.finalstretch = help.Int(pText);
-        }
-
-        if (map.finalmode)
-        {
-            map.final_colormode = false;
-            map.final_mapcol = 0;
-            map.final_colorframe = 0;
-        }
-        if (map.finalstretch)
-        {
-            map.finalstretch = true;
-            map.final_colormode = true;
-            map.final_mapcol = 0;
-            map.final_colorframe = 1;
-        }
-
-
-        if (SDL_strcmp(pKey, "savex") == 0)
-        {
-            savex = help.Int(pText);
-        }
-        else if (SDL_strcmp(pKey, "savey") == 0)
-        {
-            savey = help.Int(pText);
-        }
-        else if (SDL_strcmp(pKey, "saverx") == 0)
-        {
-            saverx = help.Int(pText);
-        }
-        else if (SDL_strcmp(pKey, "savery") == 0)
-        {
-            savery = help.Int(pText);
-        }
-        else if (SDL_strcmp(pKey, "savegc") == 0)
-        {
-            savegc = help.Int(pText);
-        }
-        else if (SDL_strcmp(pKey, "savedir") == 0)
-        {
-            savedir= help.Int(pText);
-        }
-        else if (SDL_strcmp(pKey, "savepoint") == 0)
-        {
-            savepoint = help.Int(pText);
-        }
-        else if (SDL_strcmp(pKey, "savecolour") == 0)
-        {
-            savecolour = help.Int(pText);
-        }
-        else if (SDL_strcmp(pKey, "companion") == 0)
-        {
-            companion = help.Int(pText);
-        }
-        else if (SDL_strcmp(pKey, "lastsaved") == 0)
-        {
-            lastsaved = help.Int(pText);
-        }
-        else if (SDL_strcmp(pKey, "teleportscript") == 0)
-        {
-            teleportscript = pText;
-        }
-        else if (SDL_strcmp(pKey, "supercrewmate") == 0)
-        {
-            supercrewmate = help.Int(pText);
-        }
-        else if (SDL_strcmp(pKey, "scmprogress") == 0)
-        {
-            scmprogress = help.Int(pText);
-        }
-        else if (SDL_strcmp(pKey, "frames") == 0)
-        {
-            frames = help.Int(pText);
-        }
-        else if (SDL_strcmp(pKey, "seconds") == 0)
-        {
-            seconds = help.Int(pText);
-        }
-        else if (SDL_strcmp(pKey, "minutes") == 0)
-        {
-            minutes = help.Int(pText);
-        }
-        else if (SDL_strcmp(pKey, "hours") == 0)
-        {
-            hours = help.Int(pText);
-        }
-        else if (SDL_strcmp(pKey, "deathcounts") == 0)
-        {
-            deathcounts = help.Int(pText);
-        }
-        else if (SDL_strcmp(pKey, "totalflips") == 0)
-        {
-            totalflips = help.Int(pText);
-        }
-        else if (SDL_strcmp(pKey, "hardestroom") == 0)
-        {
-            hardestroom = pText;
-        }
-        else if (SDL_strcmp(pKey, "hardestroomdeaths") == 0)
-        {
-            hardestroomdeaths = help.Int(pText);
-        }
-        else if (SDL_strcmp(pKey, "hardestroom_x") == 0)
-        {
-            hardestroom_x = help.Int(pText);
-        }
-        else if (SDL_strcmp(pKey, "hardestroom_y") == 0)
-        {
-            hardestroom_y = help.Int(pText);
-        }
-        else if (SDL_strcmp(pKey, "hardestroom_specialname") == 0)
-        {
-            hardestroom_specialname = help.Int(pText);
-        }
-        else if (SDL_strcmp(pKey, "hardestroom_finalstretch") == 0)
-        {
-            hardestroom_finalstretch = help.Int(pText);
-        }
-        else if (SDL_strcmp(pKey, "currentsong") == 0)
-        {
-            int song = help.Int(pText);
-            if (song != -1)
-            {
-                music.play(song);
-            }
-        }
-        else if (SDL_strcmp(pKey, "lang_custom") == 0)
-        {
-            loc::lang_custom = pText;
-            if (pText[0] != '\0')
-            {
-                loc::loadtext_custom(NULL);
-            }
-        }
-        else if (SDL_strcmp(pKey, "showminimap") == 0)
-        {
-            map.customshowmm = help.Int(pText);
-        }
-        else if (SDL_strcmp(pKey, "mapreveal") == 0)
-        {
-            map.revealmap = help.Int(pText);
-        }
-        else if (SDL_strcmp(pKey, "disabletemporaryaudiopause") == 0)
-        {
-            disabletemporaryaudiopause = help.Int(pText);
-        }
-        else if (SDL_strcmp(pKey, "showtrinkets") == 0)
-        {
-            map.showtrinkets = help.Int(pText);
-        }
-        else if (SDL_strcmp(pKey, "roomname") == 0)
-        {
-            map.setroomname(pText);
-            map.roomnameset = true;
-            map.roomname_special = true;
-        }
-        else if (SDL_strcmp(pKey, "currentregion") == 0)
-        {
-            map.currentregion = help.Int(pText);
-        }
-        else if (SDL_strcmp(pKey, "regions") == 0)
+        if (SDL_strcmp(pKey, "regions") == 0)
         {
             tinyxml2::XMLElement* pElem2;
             for (pElem2 = pElem->FirstChildElement(); pElem2 != NULL; pElem2 = pElem2->NextSiblingElement())
@@ -6099,8 +6072,274 @@ void Game::customloadquick(const std::string& savfile)
 
                 map.setregion(thisid, thisrx, thisry, thisrx2, thisry2);
             }
+            continue;
+        }
+
+        readcustomsavefield(pKey, pText);
+    }
+}
+
+void Game::readcustomsave(const std::vector<binsave::Node>& nodes)
+{
+    const size_t data = binsave::find_data(nodes);
+    if (data == 0)
+    {
+        vlog_error("Error parsing custom level save: no Data");
+        return;
+    }
+
+    // Same as customloadquick()
+    hardestroom_x = -1;
+    hardestroom_y = -1;
+    hardestroom_specialname = false;
+    hardestroom_finalstretch = false;
+
+    for (size_t i = data + 1; i < nodes[data].end; i = nodes[i].end)
+    {
+        const binsave::Node* node = &nodes[i];
+        char buffer[16];
+
+        LOAD_BINARY_ARRAY_RENAME(worldmap, map.explored)
+
+        LOAD_BINARY_ARRAY_RENAME(flags, obj.flags)
+
+        LOAD_BINARY_ARRAY_RENAME(moods, obj.customcrewmoods)
+
+        LOAD_BINARY_ARRAY(crewstats)
+
+        LOAD_BINARY_ARRAY_RENAME(collect, obj.collect)
+
+        LOAD_BINARY_ARRAY_RENAME(customcollect, obj.customcollect)
+
+        if (node->type == binsave::NODE_ELEMENT && SDL_strcmp(node->name, "regions") == 0)
+        {
+            for (size_t j = i + 1; j < node->end; j = nodes[j].end)
+            {
+                const char* id = binsave::get_attribute(nodes[j], "id");
+                int thisid = 0;
+                int thisrx = 0;
+                int thisry = 0;
+                int thisrx2 = (cl.mapwidth - 1);
+                int thisry2 = (cl.mapheight - 1);
+                if (id != NULL)
+                {
+                    thisid = help.Int(id);
+                }
+
+                for (size_t k = j + 1; k < nodes[j].end; k = nodes[k].end)
+                {
+                    const binsave::Node* coord = &nodes[k];
+                    if (coord->type != binsave::NODE_INT)
+                    {
+                        continue;
+                    }
+                    if (SDL_strcmp(coord->name, "rx") == 0)
+                    {
+                        thisrx = coord->value;
+                    }
+                    if (SDL_strcmp(coord->name, "ry") == 0)
+                    {
+                        thisry = coord->value;
+                    }
+                    if (SDL_strcmp(coord->name, "rx2") == 0)
+                    {
+                        thisrx2 = coord->value;
+                    }
+                    if (SDL_strcmp(coord->name, "ry2") == 0)
+                    {
+                        thisry2 = coord->value;
+                    }
+                }
+
+                map.setregion(thisid, thisrx, thisry, thisrx2, thisry2);
+            }
+            continue;
+        }
+
+        readcustomsavefield(node->name, binsave::get_text(*node, buffer, sizeof(buffer)));
+    }
+}
+
+void Game::readcustomsavefield(const char* pKey, const char* pText)
+{
+    LOAD_ARRAY_RENAME(worldmap, map.explored)
+
+    LOAD_ARRAY_RENAME(flags, obj.flags)
+
+    LOAD_ARRAY_RENAME(moods, obj.customcrewmoods)
+
+    LOAD_ARRAY(crewstats)
+
+    LOAD_ARRAY_RENAME(collect, obj.collect)
+
+    LOAD_ARRAY_RENAME(customcollect, obj.customcollect)
+
+    if (SDL_strcmp(pKey, "finalmode") == 0)
+    {
+        map.finalmode = help.Int(pText);
+    }
+    if (SDL_strcmp(pKey, "finalstretch") == 0)
+    {
+        map.finalstretch = help.Int(pText);
+    }
+
+    if (map.finalmode)
+    {
+        map.final_colormode = false;
+        map.final_mapcol = 0;
+        map.final_colorframe = 0;
+    }
+    if (map.finalstretch)
+    {
+        map.finalstretch = true;
+        map.final_colormode = true;
+        map.final_mapcol = 0;
+        map.final_colorframe = 1;
+    }
+
+
+    if (SDL_strcmp(pKey, "savex") == 0)
+    {
+        savex = help.Int(pText);
+    }
+    else if (SDL_strcmp(pKey, "savey") == 0)
+    {
+        savey = help.Int(pText);
+    }
+    else if (SDL_strcmp(pKey, "saverx") == 0)
+    {
+        saverx = help.Int(pText);
+    }
+    else if (SDL_strcmp(pKey, "savery") == 0)
+    {
+        savery = help.Int(pText);
+    }
+    else if (SDL_strcmp(pKey, "savegc") == 0)
+    {
+        savegc = help.Int(pText);
+    }
+    else if (SDL_strcmp(pKey, "savedir") == 0)
+    {
+        savedir= help.Int(pText);
+    }
+    else if (SDL_strcmp(pKey, "savepoint") == 0)
+    {
+        savepoint = help.Int(pText);
+    }
+    else if (SDL_strcmp(pKey, "savecolour") == 0)
+    {
+        savecolour = help.Int(pText);
+    }
+    else if (SDL_strcmp(pKey, "companion") == 0)
+    {
+        companion = help.Int(pText);
+    }
+    else if (SDL_strcmp(pKey, "lastsaved") == 0)
+    {
+        lastsaved = help.Int(pText);
+    }
+    else if (SDL_strcmp(pKey, "teleportscript") == 0)
+    {
+        teleportscript = pText;
+    }
+    else if (SDL_strcmp(pKey, "supercrewmate") == 0)
+    {
+        supercrewmate = help.Int(pText);
+    }
+    else if (SDL_strcmp(pKey, "scmprogress") == 0)
+    {
+        scmprogress = help.Int(pText);
+    }
+    else if (SDL_strcmp(pKey, "frames") == 0)
+    {
+        frames = help.Int(pText);
+    }
+    else if (SDL_strcmp(pKey, "seconds") == 0)
+    {
+        seconds = help.Int(pText);
+    }
+    else if (SDL_strcmp(pKey, "minutes") == 0)
+    {
+        minutes = help.Int(pText);
+    }
+    else if (SDL_strcmp(pKey, "hours") == 0)
+    {
+        hours = help.Int(pText);
+    }
+    else if (SDL_strcmp(pKey, "deathcounts") == 0)
+    {
+        deathcounts = help.Int(pText);
+    }
+    else if (SDL_strcmp(pKey, "totalflips") == 0)
+    {
+        totalflips = help.Int(pText);
+    }
+    else if (SDL_strcmp(pKey, "hardestroom") == 0)
+    {
+        hardestroom = pText;
+    }
+    else if (SDL_strcmp(pKey, "hardestroomdeaths") == 0)
+    {
+        hardestroomdeaths = help.Int(pText);
+    }
+    else if (SDL_strcmp(pKey, "hardestroom_x") == 0)
+    {
+        hardestroom_x = help.Int(pText);
+    }
+    else if (SDL_strcmp(pKey, "hardestroom_y") == 0)
+    {
+        hardestroom_y = help.Int(pText);
+    }
+    else if (SDL_strcmp(pKey, "hardestroom_specialname") == 0)
+    {
+        hardestroom_specialname = help.Int(pText);
+    }
+    else if (SDL_strcmp(pKey, "hardestroom_finalstretch") == 0)
+    {
+        hardestroom_finalstretch = help.Int(pText);
+    }
+    else if (SDL_strcmp(pKey, "currentsong") == 0)
+    {
+        int song = help.Int(pText);
+        if (song != -1)
+        {
+            music.play(song);
+        }
+    }
+    else if (SDL_strcmp(pKey, "lang_custom") == 0)
+    {
+        loc::lang_custom = pText;
+        if (pText[0] != '\0')
+        {
+            loc::loadtext_custom(NULL);
         }
     }
+    else if (SDL_strcmp(pKey, "showminimap") == 0)
+    {
+        map.customshowmm = help.Int(pText);
+    }
+    else if (SDL_strcmp(pKey, "mapreveal") == 0)
+    {
+        map.revealmap = help.Int(pText);
+    }
+    else if (SDL_strcmp(pKey, "disabletemporaryaudiopause") == 0)
+    {
+        disabletemporaryaudiopause = help.Int(pText);
+    }
+    else if (SDL_strcmp(pKey, "showtrinkets") == 0)
+    {
+        map.showtrinkets = help.Int(pText);
+    }
+    else if (SDL_strcmp(pKey, "roomname") == 0)
+    {
+        map.setroomname(pText);
+        map.roomnameset = true;
+        map.roomname_special = true;
+    }
+    else if (SDL_strcmp(pKey, "currentregion") == 0)
+    {
+        map.currentregion = help.Int(pText);
+    }
 }
 
 static void loadthissummary(
@@ -6171,12 +6410,12 @@ void Game::loadsummary(void)
     SDL_zero(last_telesave);
     SDL_zero(last_quicksave);
 
-    if (FILESYSTEM_loadTiXml2Document("saves/tsave.vvv", doc))
+    if (binsave::load_document("saves/tsave.vvv", doc))
     {
         loadthissummary("tsave.vvv", &last_telesave, doc);
     }
 
-    if (FILESYSTEM_loadTiXml2Document("saves/qsave.vvv", doc))
+    if (binsave::load_document("saves/qsave.vvv", doc))
     {
         loadthissummary("qsave.vvv", &last_quicksave, doc);
     }
@@ -6205,7 +6444,7 @@ bool Game::savetele(void)
     }
 
     tinyxml2::XMLDocument doc;
-    bool already_exists = FILESYSTEM_loadTiXml2Document("saves/tsave.vvv", doc);
+    bool already_exists = binsave::load_document("saves/tsave.vvv", doc);
     if (!already_exists)
     {
         vlog_info("No tsave.vvv found. Creating new file");
@@ -6218,7 +6457,7 @@ bool Game::savetele(void)
 
     last_telesave = writemaingamesave(doc);
 
-    if(!FILESYSTEM_saveTiXml2Document("saves/tsave.vvv", doc))
+    if(!binsave::save_document("saves/tsave.vvv", doc, binarysaves))
     {
         vlog_error("Could Not Save game!");
         vlog_error("Failed: %s%s", saveFilePath, "tsave.vvv");
@@ -6238,7 +6477,7 @@ bool Game::savequick(void)
     }
 
     tinyxml2::XMLDocument doc;
-    bool already_exists = FILESYSTEM_loadTiXml2Document("saves/qsave.vvv", doc);
+    bool already_exists = binsave::load_document("saves/qsave.vvv", doc);
     if (!already_exists)
     {
         vlog_info("No qsave.vvv found. Creating new file");
@@ -6251,7 +6490,7 @@ bool Game::savequick(void)
 
     last_quicksave = writemaingamesave(doc);
 
-    if(!FILESYSTEM_saveTiXml2Document("saves/qsave.vvv", doc))
+    if(!binsave::save_document("saves/qsave.vvv", doc, binarysaves))
     {
         vlog_error("Could Not Save game!");
         vlog_error("Failed: %s%s", saveFilePath, "qsave.vvv");
@@ -6398,7 +6637,7 @@ bool Game::customsavequick(const std::string& savfile)
     const std::string levelfile = savfile.substr(7);
 
     tinyxml2::XMLDocument doc;
-    bool already_exists = FILESYSTEM_loadTiXml2Document(("saves/" + levelfile + ".vvv").c_str(), doc);
+    bool already_exists = binsave::load_document(("saves/" + levelfile + ".vvv").c_str(), doc);
     if (!already_exists)
     {
         vlog_info("No %s.vvv found. Creating new file", levelfile.c_str());
@@ -6583,7 +6822,7 @@ bool Game::customsavequick(const std::string& savfile)
     std::string legacy_summary = customleveltitle + ", " + timestring();
     xml::update_tag(msgs, "summary", legacy_summary.c_str());
 
-    if(!FILESYSTEM_saveTiXml2Document(("saves/"+levelfile+".vvv").c_str(), doc))
+    if(!binsave::save_document(("saves/"+levelfile+".vvv").c_str(), doc, binarysaves))
     {
         vlog_error("Could Not Save game!");
         vlog_error("Failed: %s%s%s", saveFilePath, levelfile.c_str(), ".vvv");
@@ -6596,10 +6835,7 @@ bool Game::customsavequick(const std::string& savfile)
 
 void Game::loadtele(void)
 {
-    tinyxml2::XMLDocument doc;
-    if (!FILESYSTEM_loadTiXml2Document("saves/tsave.vvv", doc)) return;
-
-    readmaingamesave("tsave.vvv", doc);
+    loadmaingamesave("tsave.vvv");
 }
 
 std::string Game::unrescued(void)
@@ -7087,6 +7323,7 @@ void Game::createmenu( enum Menu::MenuName t, bool samemenu/*= false*/ )
         option(loc::gettext("unfocus audio pause"));
         option(loc::gettext("room name background"));
         option(loc::gettext("checkpoint saving"));
+        option(loc::gettext("binary saves"));
         option(loc::gettext("return"));
         menuyoff = 0;
         maxspacing = 15;
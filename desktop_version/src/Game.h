@@ -23,6 +23,11 @@ namespace tinyxml2
     class XMLElement;
 }
 
+namespace binsave
+{
+    struct Node;
+}
+
 /* 40 chars (160 bytes) covers the entire screen, + 1 more for null terminator */
 #define MENU_TEXT_BYTES 161
 
@@ -286,6 +291,8 @@ public:
     void deathsequence(void);
 
     void customloadquick(const std::string& savfile);
+    void readcustomsave(const std::vector<binsave::Node>& nodes);
+    void readcustomsavefield(const char* pKey, const char* pText);
     void loadquick(void);
 
     void customdeletequick(const std::string& file);
@@ -309,7 +316,11 @@ public:
     struct Summary last_telesave, last_quicksave;
     bool save_exists(void);
 
+    void loadmaingamesave(const char* savename);
     void readmaingamesave(const char* savename, tinyxml2::XMLDocument& doc);
+    void readmaingamesave(const char* savename, const std::vector<binsave::Node>& nodes);
+    void readmaingamesavefield(const char* pKey, const char* pText);
+    void readmaingamesavefinish(void);
     struct Summary writemaingamesave(tinyxml2::XMLDocument& doc);
 
     void initteleportermode(void);
@@ -366,6 +377,7 @@ public:
     bool startscript;
     std::string newscript;
     bool checkpoint_saving;
+    bool binarysaves;
 
     bool menustart;
 
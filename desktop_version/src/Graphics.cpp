@@ -3745,8 +3745,7 @@ static void make_array(
 
 bool Graphics::reloadresources(void)
 {
-    grphx.destroy();
-    grphx.init();
+    grphx.reload(FILESYSTEM_getAssetFingerprint());
 
     MAYBE_FAIL(checktexturesize("tiles.png", grphx.im_tiles, 8, 8));
     MAYBE_FAIL(checktexturesize("tiles2.png", grphx.im_tiles2, 8, 8));
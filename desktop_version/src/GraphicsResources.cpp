@@ -109,13 +109,8 @@ SDL_Surface* LoadImageSurface(const char* filename)
     return optimizedImage;
 }
 
-static SDL_Texture* LoadTextureFromRaw(const char* filename, SDL_Surface* loadedImage, const TextureLoadType loadtype)
+static void ApplyLoadType(SDL_Surface* loadedImage, const TextureLoadType loadtype)
 {
-    if (loadedImage == NULL)
-    {
-        return NULL;
-    }
-
     // Modify the surface with the load type.
     // This could be done in LoadImageRaw, however currently, surfaces are only used for
     // pixel perfect collision (which will be changed later) and the window icon.
@@ -164,6 +159,16 @@ static SDL_Texture* LoadTextureFromRaw(const char* filename, SDL_Surface* loaded
     default:
         break;
     }
+}
+
+static SDL_Texture* LoadTextureFromRaw(const char* filename, SDL_Surface* loadedImage, const TextureLoadType loadtype)
+{
+    if (loadedImage == NULL)
+    {
+        return NULL;
+    }
+
+    ApplyLoadType(loadedImage, loadtype);
 
     //Create texture from surface pixels
     SDL_Texture* texture = SDL_CreateTextureFromSurface(gameScreen.m_renderer, loadedImage);
@@ -276,20 +281,20 @@ static void LoadSprites(const char* filename, SDL_Texture** texture, SDL_Surface
     VVV_free(data);
 }
 
-static void LoadSpritesTranslation(
+static SDL_Surface* LoadSpritesTranslation(
     const char* filename,
     tinyxml2::XMLDocument* mask,
-    SDL_Surface* surface_english,
-    SDL_Texture** texture
+    SDL_Surface* surface_english
 ) {
-    /* Create a sprites texture for display in another language.
+    /* Create a sprites surface for display in another language.
      * surface_english is used as a base. Parts of the translation (filename)
-     * will replace parts of the base, as instructed in the mask XML. */
+     * will replace parts of the base, as instructed in the mask XML.
+     * Doesn't touch the renderer, so this can run on another thread. */
 
     if (surface_english == NULL)
     {
         vlog_error("LoadSpritesTranslation: English surface is NULL!");
-        return;
+        return NULL;
     }
 
     // Make a copy of the English sprites, for working with
@@ -299,7 +304,7 @@ static void LoadSpritesTranslation(
     );
     if (working == NULL)
     {
-        return;
+        return NULL;
     }
 
     SDL_Surface* translated;
@@ -342,31 +347,30 @@ static void LoadSpritesTranslation(
         SDL_BlitSurface(translated, &src, working, &dst);
     }
 
-    *texture = LoadTextureFromRaw(filename, working, TEX_WHITE);
+    ApplyLoadType(working, TEX_WHITE);
 
     VVV_freefunc(SDL_FreeSurface, translated);
-    VVV_freefunc(SDL_FreeSurface, working);
-}
-
-void GraphicsResources::init_translations(void)
-{
-    VVV_freefunc(SDL_DestroyTexture, im_sprites_translated);
-    VVV_freefunc(SDL_DestroyTexture, im_flipsprites_translated);
 
-    if (loc::english_sprites)
-    {
-        return;
-    }
+    return working;
+}
 
-    const char* langcode = loc::lang.c_str();
+static void LoadTranslations(
+    const std::string& langcode,
+    SDL_Surface* sprites_english,
+    SDL_Surface* flipsprites_english,
+    SDL_Surface** sprites,
+    SDL_Surface** flipsprites
+) {
+    *sprites = NULL;
+    *flipsprites = NULL;
 
     const char* path_template = "lang/%s/graphics/%s";
     char path_xml[256];
     char path_sprites[256];
     char path_flipsprites[256];
-    SDL_snprintf(path_xml, sizeof(path_xml), path_template, langcode, "spritesmask.xml");
-    SDL_snprintf(path_sprites, sizeof(path_sprites), path_template, langcode, "sprites.png");
-    SDL_snprintf(path_flipsprites, sizeof(path_flipsprites), path_template, langcode, "flipsprites.png");
+    SDL_snprintf(path_xml, sizeof(path_xml), path_template, langcode.c_str(), "spritesmask.xml");
+    SDL_snprintf(path_sprites, sizeof(path_sprites), path_template, langcode.c_str(), "sprites.png");
+    SDL_snprintf(path_flipsprites, sizeof(path_flipsprites), path_template, langcode.c_str(), "flipsprites.png");
 
     /* We don't want to apply main-game translations to level-specific (custom) sprites.
      * Either sprites and translations are BOTH main-game, or BOTH level-specific.
@@ -386,22 +390,151 @@ void GraphicsResources::init_translations(void)
 
     if (FILESYSTEM_areAssetsInSameRealDir(path_xml, path_sprites))
     {
-        LoadSpritesTranslation(
-            path_sprites,
-            &doc_mask,
-            im_sprites_surf,
-            &im_sprites_translated
-        );
+        *sprites = LoadSpritesTranslation(path_sprites, &doc_mask, sprites_english);
     }
     if (FILESYSTEM_areAssetsInSameRealDir(path_xml, path_flipsprites))
     {
-        LoadSpritesTranslation(
-            path_flipsprites,
-            &doc_mask,
-            im_flipsprites_surf,
-            &im_flipsprites_translated
-        );
+        *flipsprites = LoadSpritesTranslation(path_flipsprites, &doc_mask, flipsprites_english);
+    }
+}
+
+/* Translated sprites being made in the background, for init_translations()
+ * to pick up. Only the surfaces are made here; textures have to be created
+ * on the main thread. */
+struct TranslationLoadJob
+{
+    bool active;
+    std::string langcode;
+    SDL_Surface* sprites_english;
+    SDL_Surface* flipsprites_english;
+    SDL_Surface* sprites;
+    SDL_Surface* flipsprites;
+    SDL_Thread* thread;
+    SDL_atomic_t done;
+    bool stale; /* A reread was asked for after this started */
+};
+
+static TranslationLoadJob translation_load_job;
+
+static int SDLCALL translation_load_thread(void* userdata)
+{
+    TranslationLoadJob* job = (TranslationLoadJob*) userdata;
+
+    LoadTranslations(
+        job->langcode,
+        job->sprites_english,
+        job->flipsprites_english,
+        &job->sprites,
+        &job->flipsprites
+    );
+
+    SDL_AtomicSet(&job->done, 1);
+    return 0;
+}
+
+static void wait_translation_load_job(void)
+{
+    if (translation_load_job.thread != NULL)
+    {
+        SDL_WaitThread(translation_load_job.thread, NULL);
+        translation_load_job.thread = NULL;
+    }
+}
+
+static void discard_translation_load_job(void)
+{
+    wait_translation_load_job();
+    translation_load_job.active = false;
+    translation_load_job.langcode.clear();
+    VVV_freefunc(SDL_FreeSurface, translation_load_job.sprites);
+    VVV_freefunc(SDL_FreeSurface, translation_load_job.flipsprites);
+}
+
+bool GraphicsResources::prefetch_translations(const std::string& langcode, const bool reread)
+{
+    if (reread && translation_load_job.active && translation_load_job.langcode == langcode)
+    {
+        /* Even if it's still being made, it has to be made again once it's done */
+        translation_load_job.stale = true;
+    }
+    if (translation_load_job.active && translation_load_job.langcode == langcode && !translation_load_job.stale)
+    {
+        return true;
+    }
+    if (translation_load_job.active && !SDL_AtomicGet(&translation_load_job.done))
+    {
+        /* Busy; try again next frame */
+        return false;
+    }
+
+    discard_translation_load_job();
+
+    translation_load_job.active = true;
+    translation_load_job.langcode = langcode;
+    translation_load_job.stale = false;
+    translation_load_job.sprites_english = im_sprites_surf;
+    translation_load_job.flipsprites_english = im_flipsprites_surf;
+    SDL_AtomicSet(&translation_load_job.done, 0);
+
+    translation_load_job.thread = SDL_CreateThread(
+        translation_load_thread,
+        "translation_load",
+        &translation_load_job
+    );
+    if (translation_load_job.thread == NULL)
+    {
+        vlog_warn("Could not create translation loading thread, loading synchronously: %s", SDL_GetError());
+        translation_load_thread(&translation_load_job);
+    }
+    return true;
+}
+
+bool GraphicsResources::translations_prefetched(const std::string& langcode)
+{
+    return translation_load_job.active
+    && translation_load_job.langcode == langcode
+    && !translation_load_job.stale
+    && SDL_AtomicGet(&translation_load_job.done);
+}
+
+void GraphicsResources::drop_prefetched_translations(void)
+{
+    discard_translation_load_job();
+}
+
+void GraphicsResources::init_translations(void)
+{
+    VVV_freefunc(SDL_DestroyTexture, im_sprites_translated);
+    VVV_freefunc(SDL_DestroyTexture, im_flipsprites_translated);
+
+    if (loc::english_sprites)
+    {
+        return;
+    }
+
+    SDL_Surface* sprites;
+    SDL_Surface* flipsprites;
+    if (translation_load_job.active && translation_load_job.langcode == loc::lang && !translation_load_job.stale)
+    {
+        /* Made in the background already */
+        wait_translation_load_job();
+        sprites = translation_load_job.sprites;
+        flipsprites = translation_load_job.flipsprites;
+        translation_load_job.sprites = NULL;
+        translation_load_job.flipsprites = NULL;
+        discard_translation_load_job();
+    }
+    else
+    {
+        LoadTranslations(loc::lang, im_sprites_surf, im_flipsprites_surf, &sprites, &flipsprites);
     }
+
+    /* Already made white */
+    im_sprites_translated = LoadTextureFromRaw("translated sprites", sprites, TEX_COLOR);
+    im_flipsprites_translated = LoadTextureFromRaw("translated flipsprites", flipsprites, TEX_COLOR);
+
+    VVV_freefunc(SDL_FreeSurface, sprites);
+    VVV_freefunc(SDL_FreeSurface, flipsprites);
 }
 
 void GraphicsResources::init(void)
@@ -473,6 +606,19 @@ void GraphicsResources::init(void)
 
 
 void GraphicsResources::destroy(void)
+{
+    /* It's reading the English sprite surfaces */
+    discard_translation_load_job();
+
+    destroy_images();
+
+    for (size_t i = 0; i < SDL_arraysize(graphics.customminimaps); i++)
+    {
+        VVV_freefunc(SDL_DestroyTexture, graphics.customminimaps[i]);
+    }
+}
+
+void GraphicsResources::destroy_images(void)
 {
 #define CLEAR(img) VVV_freefunc(SDL_DestroyTexture, img)
     CLEAR(im_tiles);
@@ -503,17 +649,70 @@ void GraphicsResources::destroy(void)
 
     CLEAR(im_sprites_translated);
     CLEAR(im_flipsprites_translated);
-
-    for (size_t i = 0; i < SDL_arraysize(graphics.customminimaps); i++)
-    {
-        CLEAR(graphics.customminimaps[i]);
-    }
 #undef CLEAR
 
     VVV_freefunc(SDL_FreeSurface, im_sprites_surf);
     VVV_freefunc(SDL_FreeSurface, im_flipsprites_surf);
 }
 
+/* The textures of the last level whose assets were unmounted, so that going
+ * back to the menu and playing it again doesn't load them all over again */
+static GraphicsResources parked;
+static SDL_Texture* parked_minimaps[SDL_arraysize(graphics.customminimaps)];
+static std::string parked_lang;
+
+void GraphicsResources::destroy_parked(void)
+{
+    parked.destroy_images();
+    parked.fingerprint = 0;
+
+    for (size_t i = 0; i < SDL_arraysize(parked_minimaps); i++)
+    {
+        VVV_freefunc(SDL_DestroyTexture, parked_minimaps[i]);
+    }
+}
+
+void GraphicsResources::reload(const Uint64 assets)
+{
+    if (fingerprint != 0 && fingerprint != assets)
+    {
+        /* It's reading the English sprite surfaces */
+        discard_translation_load_job();
+
+        destroy_parked();
+        parked = *this;
+        parked_lang = loc::lang;
+        SDL_memcpy(parked_minimaps, graphics.customminimaps, sizeof(parked_minimaps));
+
+        SDL_zerop(this);
+        SDL_zeroa(graphics.customminimaps);
+    }
+    else
+    {
+        destroy();
+    }
+
+    if (assets != 0 && parked.fingerprint == assets)
+    {
+        vlog_info("Assets are unchanged since they were unmounted, reusing their textures");
+
+        *this = parked;
+        SDL_memcpy(graphics.customminimaps, parked_minimaps, sizeof(parked_minimaps));
+
+        SDL_zero(parked);
+        SDL_zeroa(parked_minimaps);
+
+        if (parked_lang != loc::lang)
+        {
+            init_translations();
+        }
+        return;
+    }
+
+    init();
+    fingerprint = assets;
+}
+
 bool SaveImage(const SDL_Surface* surface, const char* filename)
 {
     unsigned char* out;
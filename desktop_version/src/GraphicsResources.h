@@ -2,6 +2,7 @@
 #define GRAPHICSRESOURCES_H
 
 #include <SDL.h>
+#include <string>
 
 enum TextureLoadType
 {
@@ -16,7 +17,19 @@ public:
     void init(void);
     void destroy(void);
 
+    /* Loads the textures for the assets that are mounted now. A level's
+     * textures are set aside instead of destroyed, and used again if the
+     * same assets (by FILESYSTEM_getAssetFingerprint()) come back. */
+    void reload(Uint64 assets);
+    static void destroy_parked(void);
+
     void init_translations(void);
+    /* Starts making the translated sprites for a language in the background,
+     * so init_translations() doesn't have to wait for them later. Returns
+     * false if it's busy with another language, try again later then. */
+    bool prefetch_translations(const std::string& langcode, bool reread);
+    bool translations_prefetched(const std::string& langcode);
+    void drop_prefetched_translations(void);
 
     SDL_Surface* im_sprites_surf;
     SDL_Surface* im_flipsprites_surf;
@@ -48,6 +61,12 @@ public:
 
     SDL_Texture* im_sprites_translated;
     SDL_Texture* im_flipsprites_translated;
+
+    /* The assets these were loaded from, 0 for the defaults */
+    Uint64 fingerprint;
+
+private:
+    void destroy_images(void);
 };
 
 SDL_Surface* LoadImageSurface(const char* filename);
@@ -0,0 +1,52 @@
+#include "Hash.h"
+
+#define FNV1A32_PRIME 16777619u
+#define FNV1A64_PRIME 1099511628211ull
+
+uint32_t hash_fnv1a32(uint32_t hash, const void* data, const size_t size)
+{
+    const unsigned char* bytes = (const unsigned char*) data;
+    for (size_t i = 0; i < size; i++)
+    {
+        hash = (hash ^ bytes[i]) * FNV1A32_PRIME;
+    }
+    return hash;
+}
+
+uint32_t hash_fnv1a32_str(uint32_t hash, const char* str)
+{
+    for (const unsigned char* c = (const unsigned char*) str; *c != '\0'; c++)
+    {
+        hash = (hash ^ *c) * FNV1A32_PRIME;
+    }
+    return hash;
+}
+
+uint32_t hash_fnv1a32_value(const uint32_t hash, const uint32_t value)
+{
+    return (hash ^ value) * FNV1A32_PRIME;
+}
+
+uint64_t hash_fnv1a64(uint64_t hash, const void* data, const size_t size)
+{
+    const unsigned char* bytes = (const unsigned char*) data;
+    for (size_t i = 0; i < size; i++)
+    {
+        hash = (hash ^ bytes[i]) * FNV1A64_PRIME;
+    }
+    return hash;
+}
+
+uint64_t hash_fnv1a64_str(uint64_t hash, const char* str)
+{
+    for (const unsigned char* c = (const unsigned char*) str; *c != '\0'; c++)
+    {
+        hash = (hash ^ *c) * FNV1A64_PRIME;
+    }
+    return hash;
+}
+
+uint64_t hash_fnv1a64_value(const uint64_t hash, const uint32_t value)
+{
+    return (hash ^ value) * FNV1A64_PRIME;
+}
@@ -0,0 +1,32 @@
+#ifndef HASH_H
+#define HASH_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* FNV-1a, for the caches and fingerprints that need a quick hash.
+ * Start with the _INIT value (or a seeded variant of it) and keep feeding
+ * the result back in, so several parts can go into one hash. */
+#define HASH_FNV1A32_INIT 2166136261u
+/* Spelled out in halves, C++98 doesn't have long long literals */
+#define HASH_FNV1A64_INIT ((((uint64_t) 0xCBF29CE4u) << 32) | 0x84222325u)
+
+uint32_t hash_fnv1a32(uint32_t hash, const void* data, size_t size);
+uint32_t hash_fnv1a32_str(uint32_t hash, const char* str);
+/* Mixes in a whole number at once, rather than byte by byte */
+uint32_t hash_fnv1a32_value(uint32_t hash, uint32_t value);
+
+uint64_t hash_fnv1a64(uint64_t hash, const void* data, size_t size);
+uint64_t hash_fnv1a64_str(uint64_t hash, const char* str);
+uint64_t hash_fnv1a64_value(uint64_t hash, uint32_t value);
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+#endif /* HASH_H */
@@ -367,7 +367,7 @@ static void handlefadetomode(void)
     else
     {
         fadetomode = false;
-        script.startgamemode(gotomode);
+        script.loadgamemode(gotomode);
     }
 }
 
@@ -775,6 +775,12 @@ static void menuactionpress(void)
             game.savestatsandsettings_menu();
             music.playef(Sound_VIRIDIAN);
             break;
+        case 4:
+            // toggle binary saves
+            game.binarysaves = !game.binarysaves;
+            game.savestatsandsettings_menu();
+            music.playef(Sound_VIRIDIAN);
+            break;
         default:
             //back
             music.playef(Sound_VIRIDIAN);
@@ -1121,6 +1127,7 @@ static void menuactionpress(void)
             // language statistics
             music.playef(Sound_VIRIDIAN);
             game.createmenu(Menu::translator_options_stats);
+            loc::log_text_pool_stats();
             map.nexttowercolour();
             break;
         case 1:
@@ -2171,6 +2178,25 @@ void titleinput(void)
     if (!game.press_action && !game.press_left && !game.press_right && !key.isDown(27) && !key.isDown(game.controllerButton_esc)) game.jumpheld = false;
     if (!game.press_map) game.mapheld = false;
 
+    /* The highlighted language that's being read in the background, -1 if none */
+    static int prefetched_option = -1;
+    if (game.currentmenuname == Menu::language && (unsigned) game.currentmenuoption < loc::languagelist.size())
+    {
+        /* Read the highlighted language in the background, so picking it is quick.
+         * If another one is still being read, this is tried again next frame. */
+        if (game.currentmenuoption != prefetched_option
+        && loc::prefetch_lang(loc::languagelist[game.currentmenuoption].code))
+        {
+            prefetched_option = game.currentmenuoption;
+        }
+    }
+    else if (prefetched_option != -1)
+    {
+        /* Left the menu, so whatever wasn't picked won't be needed */
+        loc::drop_prefetched_lang();
+        prefetched_option = -1;
+    }
+
     if (!game.jumpheld && graphics.fademode == FADE_NONE)
     {
         if (game.press_action || game.press_left || game.press_right || game.press_map || key.isDown(27) || key.isDown(game.controllerButton_esc))
@@ -153,7 +153,13 @@ static int changemousestate(
 /* Also used in Input.cpp. */
 void recomputetextboxes(void);
 
-bool cycle_language(bool should_recompute_textboxes)
+/* The language that cycle_language() or reloading switches to once it's
+ * been read in the background, so the game doesn't freeze in the meantime.
+ * pending_lang_index is -1 when reloading the current language. */
+static std::string pending_lang;
+static int pending_lang_index = -1;
+
+static void cycle_language(void)
 {
     extern KeyPoll key;
 
@@ -164,7 +170,7 @@ bool cycle_language(bool should_recompute_textboxes)
          * are actually language-specific, and the order could be totally
          * different between languages too. So we can't cycle in this menu. */
         music.playef(Sound_CRY);
-        return should_recompute_textboxes;
+        return;
     }
     if (game.translator_cutscene_test)
     {
@@ -172,10 +178,15 @@ bool cycle_language(bool should_recompute_textboxes)
          * working. The text boxes are based off of the language XML and
          * could be completely different between languages. */
         music.playef(Sound_CRY);
-        return should_recompute_textboxes;
+        return;
+    }
+    if (loc::languagelist.empty())
+    {
+        return;
     }
 
-    int i = loc::languagelist_curlang;
+    /* Keep going from a language that hasn't been switched to yet */
+    int i = pending_lang.empty() || pending_lang_index == -1 ? loc::languagelist_curlang : pending_lang_index;
     if (key.keymap[SDLK_LSHIFT])
     {
         /* Backwards */
@@ -186,18 +197,52 @@ bool cycle_language(bool should_recompute_textboxes)
         /* Forwards */
         i++;
     }
-    if (!loc::languagelist.empty())
+    i = POS_MOD(i, (int) loc::languagelist.size());
+
+    pending_lang = loc::languagelist[i].code;
+    pending_lang_index = i;
+    loc::prefetch_lang(pending_lang);
+}
+
+static void reload_language(void)
+{
+    pending_lang = loc::lang;
+    pending_lang_index = -1;
+    loc::prefetch_lang(pending_lang, true);
+}
+
+static bool switch_pending_language(bool should_recompute_textboxes)
+{
+    /* Called at the start of every frame */
+    if (pending_lang.empty())
+    {
+        return should_recompute_textboxes;
+    }
+
+    loc::prefetch_lang(pending_lang);
+    if (!loc::is_lang_prefetched(pending_lang))
     {
-        i = POS_MOD(i, (int) loc::languagelist.size());
+        return should_recompute_textboxes;
+    }
+
+    const int i = pending_lang_index;
+    loc::lang = pending_lang;
+    pending_lang.clear();
 
-        loc::languagelist_curlang = i;
-        loc::lang = loc::languagelist[i].code;
+    if (i == -1)
+    {
         loc::loadtext(false);
         graphics.grphx.init_translations();
-
-        should_recompute_textboxes = true;
+        music.playef(Sound_COIN);
+        return should_recompute_textboxes;
     }
 
+    loc::languagelist_curlang = i;
+    loc::loadtext(false);
+    graphics.grphx.init_translations();
+
+    should_recompute_textboxes = true;
+
     if (game.gamestate == TITLEMODE
     || (game.gamestate == EDITORMODE && ed.state == EditorState_MENU))
     {
@@ -233,6 +278,9 @@ void KeyPoll::Poll(void)
     bool should_recompute_textboxes = false;
     bool active_input_device_changed = false;
     bool keyboard_was_active = BUTTONGLYPHS_keyboard_is_active();
+
+    should_recompute_textboxes = switch_pending_language(should_recompute_textboxes);
+
     while (SDL_PollEvent(&evt))
     {
         switch (evt.type)
@@ -265,14 +313,12 @@ void KeyPoll::Poll(void)
                 if (keymap[SDLK_LCTRL])
                 {
                     /* Debug keybind to cycle language. */
-                    should_recompute_textboxes = cycle_language(should_recompute_textboxes);
+                    cycle_language();
                 }
                 else
                 {
                     /* Reload language files */
-                    loc::loadtext(false);
-                    graphics.grphx.init_translations();
-                    music.playef(Sound_COIN);
+                    reload_language();
                 }
             }
 
@@ -1,6 +1,7 @@
 #define LOCALIZATION_CPP
 #include "Localization.h"
 #include "LocalizationStorage.h"
+#include "LocalizationCompiled.h"
 
 #include "Alloc.h"
 #include "Game.h"
@@ -51,6 +52,10 @@ const char* gettext(const char* eng)
     {
         return eng;
     }
+    if (compiled_text_loaded())
+    {
+        return compiled_gettext(COMPILED_STRINGS, eng, eng);
+    }
 
     return map_lookup_text(map_translation, eng, eng);
 }
@@ -72,7 +77,15 @@ const char* gettext_case(const char* eng, char textcase)
         return eng;
     }
 
-    const char* tra = map_lookup_text(map_translation, eng_prefixed, eng);
+    const char* tra;
+    if (compiled_text_loaded())
+    {
+        tra = compiled_gettext(COMPILED_STRINGS, eng_prefixed, eng);
+    }
+    else
+    {
+        tra = map_lookup_text(map_translation, eng_prefixed, eng);
+    }
     VVV_free(eng_prefixed);
     return tra;
 }
@@ -95,7 +108,15 @@ const char* gettext_plural(const char* eng_plural, const char* eng_singular, int
         char* key = add_disambiguator(form+1, eng_plural, NULL);
         if (key != NULL)
         {
-            const char* tra = map_lookup_text(map_translation_plural, key, NULL);
+            const char* tra;
+            if (compiled_text_loaded())
+            {
+                tra = compiled_gettext(COMPILED_STRINGS_PLURAL, key, NULL);
+            }
+            else
+            {
+                tra = map_lookup_text(map_translation_plural, key, NULL);
+            }
 
             VVV_free(key);
 
@@ -169,6 +190,10 @@ const TextboxFormat* gettext_cutscene(const std::string& script_id, const std::s
         {
             return NULL;
         }
+        if (compiled_text_loaded())
+        {
+            return compiled_gettext_cutscene(script_id.c_str(), eng.c_str(), textcase);
+        }
 
         map = map_translation_cutscene;
         map_script_key = script_id.c_str();
@@ -183,18 +208,34 @@ const TextboxFormat* gettext_cutscene(const std::string& script_id, const std::s
         return NULL;
     }
 
-    size_t alloc_len;
-    char* key = add_disambiguator(textcase, eng.c_str(), &alloc_len);
-    if (key == NULL)
+    /* The key is the English text prefixed with the case. Build it on the
+     * stack, this happens for every textbox; only huge texts are allocated. */
+    char key_buf[512];
+    char* key;
+    size_t key_len = 1+eng.size();
+    if (key_len < sizeof(key_buf))
     {
-        return NULL;
+        key = key_buf;
+        key[0] = textcase;
+        SDL_memcpy(&key[1], eng.c_str(), eng.size()+1);
+    }
+    else
+    {
+        key = add_disambiguator(textcase, eng.c_str(), NULL);
+        if (key == NULL)
+        {
+            return NULL;
+        }
     }
 
     uintptr_t ptr_format;
-    found = hashmap_get(cutscene_map, key, alloc_len-1, &ptr_format);
+    found = hashmap_get(cutscene_map, key, key_len, &ptr_format);
     const TextboxFormat* format = (TextboxFormat*) ptr_format;
 
-    VVV_free(key);
+    if (key != key_buf)
+    {
+        VVV_free(key);
+    }
 
     if (!found)
     {
@@ -215,11 +256,11 @@ const char* get_roomname_explanation(bool custom_level, int roomx, int roomy)
     const char* explanation;
     if (custom_level)
     {
-        explanation = explanation_roomnames_custom[roomy][roomx];
+        explanation = stringpool_get(&text_pool_main, explanation_roomnames_custom[roomy][roomx]);
     }
     else
     {
-        explanation = explanation_roomnames[roomy][roomx];
+        explanation = stringpool_get(&text_pool_main, explanation_roomnames[roomy][roomx]);
     }
     if (explanation == NULL)
     {
@@ -242,11 +283,11 @@ const char* get_roomname_translation(bool custom_level, int roomx, int roomy)
     const char* tra;
     if (custom_level)
     {
-        tra = translation_roomnames_custom[roomy][roomx];
+        tra = stringpool_get(&text_pool_main, translation_roomnames_custom[roomy][roomx]);
     }
     else
     {
-        tra = translation_roomnames[roomy][roomx];
+        tra = stringpool_get(&text_pool_main, translation_roomnames[roomy][roomx]);
     }
 
     if (tra == NULL)
@@ -282,6 +323,10 @@ const char* gettext_roomname_special(const char* eng)
     {
         return eng;
     }
+    if (compiled_text_loaded())
+    {
+        return compiled_gettext(COMPILED_ROOMNAMES_SPECIAL, eng, eng);
+    }
 
     return map_lookup_text(map_translation_roomnames_special, eng, eng);
 }
@@ -301,6 +346,10 @@ bool is_cutscene_translated(const std::string& script_id)
         {
             return false;
         }
+        if (compiled_text_loaded())
+        {
+            return compiled_has_cutscene(script_id.c_str());
+        }
 
         map = map_translation_cutscene;
         map_script_key = script_id.c_str();
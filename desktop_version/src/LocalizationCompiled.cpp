@@ -0,0 +1,707 @@
+#define LOCALIZATIONCOMPILED_CPP
+#include "LocalizationCompiled.h"
+#include "LocalizationStorage.h"
+
+#include <SDL.h>
+#include <vector>
+
+#include "Alloc.h"
+#include "FileSystemUtils.h"
+#include "Hash.h"
+#include "Vlogging.h"
+
+namespace loc
+{
+
+/* File layout, everything little-endian:
+ *
+ *   char   magic[4] = "VVVL"
+ *   Uint32 version
+ *   Uint32 fingerprint of the XML files, low half
+ *   Uint32 fingerprint of the XML files, high half
+ *   Uint32 offset of each table, COMPILED_NUM_TABLES of them
+ *   Uint32 offset of numbers
+ *   Uint32 offset of room names, Uint32 number of room names
+ *   Uint32 offset of textbox formats, Uint32 number of textbox formats
+ *   Uint32 offset of the string pool, Uint32 size of the string pool
+ *
+ * A table is a minimal perfect hash (hash and displace):
+ *
+ *   Uint32 number of buckets, Uint32 number of slots (= number of keys)
+ *   Uint32 seed for each bucket
+ *   for each slot: Uint32 key offset, Uint32 key size, Uint32 value
+ *
+ * A key goes in bucket hash(key, 0) % buckets, and then in slot
+ * hash(key, seed of the bucket) % slots. Every key gets its own slot, so a
+ * lookup is two hashes and one comparison. For text tables the value is a
+ * string offset, for COMPILED_DIALOGUE it's the index of a textbox format.
+ *
+ * Numbers are 101 Uint32 string offsets for number, 101 for number2, and
+ * then the 200 bytes of number_plural_form.
+ *
+ * A room name is Uint16 x, Uint16 y, Uint32 string offset.
+ *
+ * A textbox format is Uint32 string offset, Uint16 wraplimit,
+ * Uint16 wraplimit_raw, Uint16 padtowidth, Uint8 tt, Uint8 centertext,
+ * Uint8 pad_left, Uint8 pad_right.
+ *
+ * String offsets point into the string pool, and strings are null-terminated.
+ * Offset 0 is always the empty string. */
+
+static const char magic[4] = {'V', 'V', 'V', 'L'};
+static const Uint32 version = 1;
+static const size_t header_size = 4 + 4 + 8 + 4*COMPILED_NUM_TABLES + 4 + 8 + 8 + 8;
+static const size_t roomname_size = 8;
+static const size_t format_size = 14;
+
+/* XML files that end up in compiled.vvvl; meta.xml is always loaded */
+static const char* const source_files[] = {
+    "strings",
+    "strings_plural",
+    "cutscenes",
+    "numbers",
+    "roomnames",
+    "roomnames_special"
+};
+
+static const unsigned char* compiled_data = NULL;
+static size_t compiled_size = 0;
+static bool compiled_mapped = false;
+static Uint32 table_offsets[COMPILED_NUM_TABLES];
+static const char* pool = NULL;
+static Uint32 pool_size = 0;
+static TextboxFormat* formats = NULL;
+static Uint32 num_formats = 0;
+
+static Uint16 read16(const unsigned char* p)
+{
+    return p[0] | (p[1] << 8);
+}
+
+static Uint32 read32(const unsigned char* p)
+{
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((Uint32) p[3] << 24);
+}
+
+static void write16(std::vector<unsigned char>& out, const Uint16 value)
+{
+    out.push_back(value & 0xFF);
+    out.push_back(value >> 8);
+}
+
+static void write32(std::vector<unsigned char>& out, const Uint32 value)
+{
+    out.push_back(value & 0xFF);
+    out.push_back((value >> 8) & 0xFF);
+    out.push_back((value >> 16) & 0xFF);
+    out.push_back(value >> 24);
+}
+
+static void patch32(std::vector<unsigned char>& out, const size_t pos, const Uint32 value)
+{
+    out[pos] = value & 0xFF;
+    out[pos + 1] = (value >> 8) & 0xFF;
+    out[pos + 2] = (value >> 16) & 0xFF;
+    out[pos + 3] = value >> 24;
+}
+
+static Uint32 hash_key(
+    const char* a,
+    const size_t a_len,
+    const char* b,
+    const size_t b_len,
+    const Uint32 seed
+) {
+    /* FNV-1a over a and then b, so keys made of two parts
+     * don't have to be put together before looking them up */
+    Uint32 hash = HASH_FNV1A32_INIT ^ (seed * 0x9E3779B9U);
+    hash = hash_fnv1a32(hash, a, a_len);
+    hash = hash_fnv1a32(hash, b, b_len);
+
+    /* Finalizer, so neighbouring seeds give unrelated slots */
+    hash ^= hash >> 16;
+    hash *= 0x85EBCA6BU;
+    hash ^= hash >> 13;
+    hash *= 0xC2B2AE35U;
+    hash ^= hash >> 16;
+    return hash;
+}
+
+static Uint64 fingerprint_sources(const std::string& langcode)
+{
+    Uint64 fingerprint = 0;
+    for (size_t i = 0; i < SDL_arraysize(source_files); i++)
+    {
+        const std::string path = "lang/" + langcode + "/" + source_files[i] + ".xml";
+        fingerprint += FILESYSTEM_fingerprintFile(path.c_str());
+    }
+    return fingerprint;
+}
+
+/* Writing */
+
+struct CompiledKey
+{
+    std::string key;
+    Uint32 value;
+};
+
+struct Compiler
+{
+    std::vector<unsigned char> pool;
+    std::vector<CompiledKey> tables[COMPILED_NUM_TABLES];
+    std::vector<unsigned char> formats;
+    Uint32 num_formats;
+
+    /* While going through the dialogue of one cutscene */
+    const char* script_id;
+    size_t script_id_len;
+    CompiledTable table;
+};
+
+static Uint32 pool_add(Compiler* compiler, const char* text, const size_t len)
+{
+    const Uint32 offset = compiler->pool.size();
+    compiler->pool.insert(compiler->pool.end(), text, text + len);
+    compiler->pool.push_back('\0');
+    return offset;
+}
+
+static void collect_text(void* key, size_t ksize, uintptr_t value, void* usr)
+{
+    Compiler* compiler = (Compiler*) usr;
+    const char* tra = (const char*) value;
+
+    /* An empty translation is the same as none at all */
+    if (tra == NULL || tra[0] == '\0')
+    {
+        return;
+    }
+
+    CompiledKey entry;
+    entry.key.assign((const char*) key, ksize);
+    entry.value = pool_add(compiler, tra, SDL_strlen(tra));
+    compiler->tables[compiler->table].push_back(entry);
+}
+
+static void collect_dialogue(void* key, size_t ksize, uintptr_t value, void* usr)
+{
+    Compiler* compiler = (Compiler*) usr;
+    const TextboxFormat* format = (const TextboxFormat*) value;
+
+    if (format == NULL)
+    {
+        return;
+    }
+
+    const char* text = format->text != NULL ? format->text : "";
+    write32(compiler->formats, pool_add(compiler, text, SDL_strlen(text)));
+    write16(compiler->formats, format->wraplimit);
+    write16(compiler->formats, format->wraplimit_raw);
+    write16(compiler->formats, format->padtowidth);
+    compiler->formats.push_back(format->tt);
+    compiler->formats.push_back(format->centertext);
+    compiler->formats.push_back(format->pad_left);
+    compiler->formats.push_back(format->pad_right);
+
+    CompiledKey entry;
+    entry.key.assign(compiler->script_id, compiler->script_id_len);
+    entry.key.push_back('\0');
+    entry.key.append((const char*) key, ksize);
+    entry.value = compiler->num_formats++;
+    compiler->tables[COMPILED_DIALOGUE].push_back(entry);
+}
+
+static void collect_cutscene(void* key, size_t ksize, uintptr_t value, void* usr)
+{
+    Compiler* compiler = (Compiler*) usr;
+
+    CompiledKey entry;
+    entry.key.assign((const char*) key, ksize);
+    entry.value = 0;
+    compiler->tables[COMPILED_CUTSCENES].push_back(entry);
+
+    if (value != 0)
+    {
+        compiler->script_id = (const char*) key;
+        compiler->script_id_len = ksize;
+        hashmap_iterate((hashmap*) value, collect_dialogue, usr);
+    }
+}
+
+static bool try_seed(
+    const std::vector<CompiledKey>& keys,
+    const std::vector<Uint32>& bucket,
+    const std::vector<Sint32>& slot_keys,
+    const Uint32 seed,
+    std::vector<Uint32>& slots
+) {
+    const Uint32 num_slots = slot_keys.size();
+
+    slots.clear();
+    for (size_t i = 0; i < bucket.size(); i++)
+    {
+        const std::string& key = keys[bucket[i]].key;
+        const Uint32 slot = hash_key(key.data(), key.size(), NULL, 0, seed) % num_slots;
+        if (slot_keys[slot] != -1)
+        {
+            return false;
+        }
+        for (size_t j = 0; j < slots.size(); j++)
+        {
+            if (slots[j] == slot)
+            {
+                return false;
+            }
+        }
+        slots.push_back(slot);
+    }
+    return true;
+}
+
+static bool write_table(Compiler* compiler, std::vector<unsigned char>& out, const std::vector<CompiledKey>& keys)
+{
+    const Uint32 num_keys = keys.size();
+    const Uint32 num_buckets = num_keys == 0 ? 0 : num_keys / 4 + 1;
+
+    write32(out, num_buckets);
+    write32(out, num_keys);
+    if (num_keys == 0)
+    {
+        return true;
+    }
+
+    std::vector<std::vector<Uint32> > buckets(num_buckets);
+    size_t biggest_bucket = 0;
+    for (Uint32 i = 0; i < num_keys; i++)
+    {
+        const std::string& key = keys[i].key;
+        std::vector<Uint32>& bucket = buckets[hash_key(key.data(), key.size(), NULL, 0, 0) % num_buckets];
+        bucket.push_back(i);
+        biggest_bucket = SDL_max(biggest_bucket, bucket.size());
+    }
+
+    std::vector<Uint32> seeds(num_buckets, 0);
+    std::vector<Sint32> slot_keys(num_keys, -1);
+    std::vector<Uint32> slots;
+
+    /* Place the biggest buckets first, while there are still lots of free slots */
+    for (size_t size = biggest_bucket; size > 0; size--)
+    {
+        for (Uint32 b = 0; b < num_buckets; b++)
+        {
+            if (buckets[b].size() != size)
+            {
+                continue;
+            }
+
+            Uint32 seed = 1;
+            while (!try_seed(keys, buckets[b], slot_keys, seed, slots))
+            {
+                seed++;
+                if (seed == 0x1000000)
+                {
+                    vlog_error("Could not find a perfect hash for %u keys", num_keys);
+                    return false;
+                }
+            }
+
+            seeds[b] = seed;
+            for (size_t i = 0; i < slots.size(); i++)
+            {
+                slot_keys[slots[i]] = buckets[b][i];
+            }
+        }
+    }
+
+    for (Uint32 b = 0; b < num_buckets; b++)
+    {
+        write32(out, seeds[b]);
+    }
+    for (Uint32 s = 0; s < num_keys; s++)
+    {
+        const CompiledKey& entry = keys[slot_keys[s]];
+        write32(out, pool_add(compiler, entry.key.data(), entry.key.size()));
+        write32(out, entry.key.size());
+        write32(out, entry.value);
+    }
+    return true;
+}
+
+bool compile_text(const std::string& langcode)
+{
+    Compiler compiler;
+    compiler.num_formats = 0;
+    compiler.script_id = NULL;
+    compiler.script_id_len = 0;
+
+    /* Offset 0 is the empty string */
+    compiler.pool.push_back('\0');
+
+    compiler.table = COMPILED_STRINGS;
+    hashmap_iterate(map_translation, collect_text, &compiler);
+    compiler.table = COMPILED_STRINGS_PLURAL;
+    hashmap_iterate(map_translation_plural, collect_text, &compiler);
+    compiler.table = COMPILED_ROOMNAMES_SPECIAL;
+    hashmap_iterate(map_translation_roomnames_special, collect_text, &compiler);
+    hashmap_iterate(map_translation_cutscene, collect_cutscene, &compiler);
+
+    std::vector<unsigned char> out;
+    out.insert(out.end(), magic, magic + sizeof(magic));
+    write32(out, version);
+    const Uint64 fingerprint = fingerprint_sources(langcode);
+    write32(out, fingerprint & 0xFFFFFFFF);
+    write32(out, fingerprint >> 32);
+    out.resize(header_size, 0);
+
+    size_t header_pos = 16;
+    for (int i = 0; i < COMPILED_NUM_TABLES; i++)
+    {
+        patch32(out, header_pos, out.size());
+        header_pos += 4;
+        if (!write_table(&compiler, out, compiler.tables[i]))
+        {
+            return false;
+        }
+    }
+
+    patch32(out, header_pos, out.size());
+    header_pos += 4;
+    for (size_t i = 0; i <= 100; i++)
+    {
+        write32(out, number[i].empty() ? 0 : pool_add(&compiler, number[i].c_str(), number[i].size()));
+    }
+    for (size_t i = 0; i <= 100; i++)
+    {
+        write32(out, number2[i].empty() ? 0 : pool_add(&compiler, number2[i].c_str(), number2[i].size()));
+    }
+    out.insert(out.end(), number_plural_form, number_plural_form + sizeof(number_plural_form));
+
+    patch32(out, header_pos, out.size());
+    header_pos += 4;
+    Uint32 num_roomnames = 0;
+    for (int y = 0; y <= MAP_MAX_Y; y++)
+    {
+        for (int x = 0; x <= MAP_MAX_X; x++)
+        {
+            const char* tra = stringpool_get(&text_pool_main, translation_roomnames[y][x]);
+            if (tra == NULL || tra[0] == '\0')
+            {
+                continue;
+            }
+            write16(out, x);
+            write16(out, y);
+            write32(out, pool_add(&compiler, tra, SDL_strlen(tra)));
+            num_roomnames++;
+        }
+    }
+    patch32(out, header_pos, num_roomnames);
+    header_pos += 4;
+
+    patch32(out, header_pos, out.size());
+    header_pos += 4;
+    out.insert(out.end(), compiler.formats.begin(), compiler.formats.end());
+    patch32(out, header_pos, compiler.num_formats);
+    header_pos += 4;
+
+    patch32(out, header_pos, out.size());
+    header_pos += 4;
+    out.insert(out.end(), compiler.pool.begin(), compiler.pool.end());
+    patch32(out, header_pos, compiler.pool.size());
+
+    const std::string path = langcode + "/compiled.vvvl";
+    if (!FILESYSTEM_saveFile(path.c_str(), &out[0], out.size()))
+    {
+        return false;
+    }
+
+    vlog_info(
+        "Compiled %s: %u strings, %u plural strings, %u cutscenes, %u dialogues, %u bytes",
+        langcode.c_str(),
+        (unsigned) compiler.tables[COMPILED_STRINGS].size(),
+        (unsigned) compiler.tables[COMPILED_STRINGS_PLURAL].size(),
+        (unsigned) compiler.tables[COMPILED_CUTSCENES].size(),
+        (unsigned) compiler.tables[COMPILED_DIALOGUE].size(),
+        (unsigned) out.size()
+    );
+    return true;
+}
+
+/* Reading */
+
+static const char* pool_string(const Uint32 offset)
+{
+    if (offset >= pool_size)
+    {
+        return "";
+    }
+    return &pool[offset];
+}
+
+static bool lookup(
+    const CompiledTable table,
+    const char* a,
+    const size_t a_len,
+    const char* b,
+    const size_t b_len,
+    Uint32* value
+) {
+    if (compiled_data == NULL)
+    {
+        return false;
+    }
+
+    const unsigned char* data = &compiled_data[table_offsets[table]];
+    const Uint32 num_buckets = read32(data);
+    const Uint32 num_slots = read32(&data[4]);
+    if (num_buckets == 0)
+    {
+        return false;
+    }
+
+    const Uint32 bucket = hash_key(a, a_len, b, b_len, 0) % num_buckets;
+    const Uint32 seed = read32(&data[8 + 4*bucket]);
+    const Uint32 slot = hash_key(a, a_len, b, b_len, seed) % num_slots;
+    const unsigned char* entry = &data[8 + 4*num_buckets + 12*slot];
+
+    const Uint32 key_offset = read32(entry);
+    const Uint32 key_len = read32(&entry[4]);
+    if (key_len != a_len + b_len || key_len > pool_size || key_offset > pool_size - key_len)
+    {
+        return false;
+    }
+    if (SDL_memcmp(&pool[key_offset], a, a_len) != 0
+    || (b_len > 0 && SDL_memcmp(&pool[key_offset + a_len], b, b_len) != 0))
+    {
+        return false;
+    }
+
+    *value = read32(&entry[8]);
+    return true;
+}
+
+static bool in_bounds(const Uint64 offset, const Uint64 size)
+{
+    return offset <= compiled_size && size <= compiled_size - offset;
+}
+
+static bool check_layout(void)
+{
+    /* Everything that lookups rely on later, so they don't have to check */
+    for (int i = 0; i < COMPILED_NUM_TABLES; i++)
+    {
+        table_offsets[i] = read32(&compiled_data[16 + 4*i]);
+        if (!in_bounds(table_offsets[i], 8))
+        {
+            return false;
+        }
+        const Uint32 num_buckets = read32(&compiled_data[table_offsets[i]]);
+        const Uint32 num_slots = read32(&compiled_data[table_offsets[i] + 4]);
+        if ((num_buckets == 0) != (num_slots == 0)
+        || !in_bounds(table_offsets[i], 8 + 4*(Uint64) num_buckets + 12*(Uint64) num_slots))
+        {
+            return false;
+        }
+    }
+
+    const unsigned char* header = &compiled_data[16 + 4*COMPILED_NUM_TABLES];
+    const Uint32 numbers_offset = read32(header);
+    const Uint32 roomnames_offset = read32(&header[4]);
+    const Uint32 num_roomnames = read32(&header[8]);
+    const Uint32 formats_offset = read32(&header[12]);
+    num_formats = read32(&header[16]);
+    const Uint32 pool_offset = read32(&header[20]);
+    pool_size = read32(&header[24]);
+
+    if (!in_bounds(numbers_offset, 4*202 + sizeof(number_plural_form))
+    || !in_bounds(roomnames_offset, roomname_size*(Uint64) num_roomnames)
+    || !in_bounds(formats_offset, format_size*(Uint64) num_formats)
+    || !in_bounds(pool_offset, pool_size)
+    || pool_size == 0
+    || compiled_data[pool_offset + pool_size - 1] != '\0')
+    {
+        return false;
+    }
+    pool = (const char*) &compiled_data[pool_offset];
+
+    if (num_formats > 0)
+    {
+        formats = (TextboxFormat*) SDL_malloc(num_formats * sizeof(TextboxFormat));
+        if (formats == NULL)
+        {
+            return false;
+        }
+    }
+
+    /* Now fill in everything that isn't looked up by English text */
+    const unsigned char* numbers = &compiled_data[numbers_offset];
+    for (size_t i = 0; i <= 100; i++)
+    {
+        number[i] = pool_string(read32(&numbers[4*i]));
+        number2[i] = pool_string(read32(&numbers[4*(101 + i)]));
+    }
+    SDL_memcpy(number_plural_form, &numbers[4*202], sizeof(number_plural_form));
+
+    const unsigned char* roomnames = &compiled_data[roomnames_offset];
+    for (Uint32 i = 0; i < num_roomnames; i++)
+    {
+        const unsigned char* roomname = &roomnames[roomname_size*i];
+        const Uint16 x = read16(roomname);
+        const Uint16 y = read16(&roomname[2]);
+        if (x <= MAP_MAX_X && y <= MAP_MAX_Y)
+        {
+            translation_roomnames[y][x] = stringpool_intern(&text_pool_main, pool_string(read32(&roomname[4])));
+        }
+    }
+
+    for (Uint32 i = 0; i < num_formats; i++)
+    {
+        const unsigned char* record = &compiled_data[formats_offset + format_size*i];
+        formats[i].text = pool_string(read32(record));
+        formats[i].wraplimit = read16(&record[4]);
+        formats[i].wraplimit_raw = read16(&record[6]);
+        formats[i].padtowidth = read16(&record[8]);
+        formats[i].tt = record[10];
+        formats[i].centertext = record[11];
+        formats[i].pad_left = record[12];
+        formats[i].pad_right = record[13];
+    }
+
+    return true;
+}
+
+bool load_compiled_text(const std::string& langcode)
+{
+    unload_compiled_text();
+
+    const std::string path = "lang/" + langcode + "/compiled.vvvl";
+    if (FILESYSTEM_fingerprintFile(path.c_str()) == 0)
+    {
+        return false;
+    }
+
+    const Uint64 start = SDL_GetPerformanceCounter();
+
+    compiled_mapped = FILESYSTEM_mapFile(path.c_str(), &compiled_data, &compiled_size);
+    if (!compiled_mapped)
+    {
+        unsigned char* mem = NULL;
+        FILESYSTEM_loadFileToMemory(path.c_str(), &mem, &compiled_size);
+        compiled_data = mem;
+    }
+    if (compiled_data == NULL)
+    {
+        return false;
+    }
+
+    if (compiled_size < header_size
+    || SDL_memcmp(compiled_data, magic, sizeof(magic)) != 0
+    || read32(&compiled_data[4]) != version)
+    {
+        vlog_warn("%s is not a compiled language file this version understands, loading XML instead", path.c_str());
+        unload_compiled_text();
+        return false;
+    }
+
+    const Uint64 fingerprint = read32(&compiled_data[8]) | ((Uint64) read32(&compiled_data[12]) << 32);
+    if (fingerprint != fingerprint_sources(langcode))
+    {
+        vlog_info("%s is older than the XML files, loading XML instead", path.c_str());
+        unload_compiled_text();
+        return false;
+    }
+
+    if (!check_layout())
+    {
+        vlog_error("%s is corrupt, loading XML instead", path.c_str());
+        unload_compiled_text();
+        return false;
+    }
+
+    vlog_debug(
+        "Loaded %s in %.2f ms",
+        path.c_str(),
+        (SDL_GetPerformanceCounter() - start) * 1000.0 / SDL_GetPerformanceFrequency()
+    );
+    return true;
+}
+
+void unload_compiled_text(void)
+{
+    if (compiled_data != NULL)
+    {
+        if (compiled_mapped)
+        {
+            FILESYSTEM_unmapFile(compiled_data, compiled_size);
+        }
+        else
+        {
+            VVV_free((void*) compiled_data);
+        }
+    }
+    compiled_data = NULL;
+    compiled_size = 0;
+    compiled_mapped = false;
+    pool = NULL;
+    pool_size = 0;
+
+    VVV_free(formats);
+    formats = NULL;
+    num_formats = 0;
+}
+
+bool compiled_text_loaded(void)
+{
+    return compiled_data != NULL;
+}
+
+const char* compiled_gettext(const CompiledTable table, const char* eng, const char* fallback)
+{
+    Uint32 offset;
+    if (!lookup(table, eng, SDL_strlen(eng), NULL, 0, &offset))
+    {
+        return fallback;
+    }
+
+    const char* tra = pool_string(offset);
+    if (tra[0] == '\0')
+    {
+        return fallback;
+    }
+    return tra;
+}
+
+const TextboxFormat* compiled_gettext_cutscene(const char* script_id, const char* eng, const char textcase)
+{
+    size_t alloc_len;
+    char* key = add_disambiguator(textcase, eng, &alloc_len);
+    if (key == NULL)
+    {
+        return NULL;
+    }
+
+    /* The script id's null terminator separates it from the English text */
+    Uint32 index;
+    const bool found = lookup(
+        COMPILED_DIALOGUE,
+        script_id, SDL_strlen(script_id) + 1,
+        key, alloc_len - 1,
+        &index
+    );
+
+    VVV_free(key);
+
+    if (!found || index >= num_formats)
+    {
+        return NULL;
+    }
+    return &formats[index];
+}
+
+bool compiled_has_cutscene(const char* script_id)
+{
+    Uint32 unused;
+    return lookup(COMPILED_CUTSCENES, script_id, SDL_strlen(script_id), NULL, 0, &unused);
+}
+
+} /* namespace loc */
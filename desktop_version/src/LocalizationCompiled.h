@@ -0,0 +1,45 @@
+#ifndef LOCALIZATIONCOMPILED_H
+#define LOCALIZATIONCOMPILED_H
+
+#include <stddef.h>
+#include <string>
+
+#include "Localization.h"
+
+/* Compiled languages: everything in a language folder that the game needs
+ * (not the translator tools) turned into one binary file, lang/XX/compiled.vvvl.
+ * The English strings are looked up with minimal perfect hashes, and all
+ * the text is used straight from the file, so switching to a compiled
+ * language doesn't parse any XML except meta.xml. */
+namespace loc
+{
+
+enum CompiledTable
+{
+    COMPILED_STRINGS,
+    COMPILED_STRINGS_PLURAL,
+    COMPILED_ROOMNAMES_SPECIAL,
+    COMPILED_CUTSCENES,
+    COMPILED_DIALOGUE, /* Keyed by script id, null terminator, then disambiguated English */
+
+    COMPILED_NUM_TABLES
+};
+
+/* Writes compiled.vvvl for the currently loaded (from XML) language.
+ * The write dir must be the language dir. */
+bool compile_text(const std::string& langcode);
+
+/* Loads compiled.vvvl if it exists and is up to date with the XML files,
+ * and fills in the numbers and room names. Returns false if the XML files
+ * have to be loaded instead. */
+bool load_compiled_text(const std::string& langcode);
+void unload_compiled_text(void);
+bool compiled_text_loaded(void);
+
+const char* compiled_gettext(CompiledTable table, const char* eng, const char* fallback);
+const TextboxFormat* compiled_gettext_cutscene(const char* script_id, const char* eng, char textcase);
+bool compiled_has_cutscene(const char* script_id);
+
+} /* namespace loc */
+
+#endif /* LOCALIZATIONCOMPILED_H */
@@ -1,6 +1,7 @@
 #define LOCALIZATIONMAINT_CPP
 #include "Localization.h"
 #include "LocalizationStorage.h"
+#include "LocalizationCompiled.h"
 
 #include <tinyxml2.h>
 
@@ -392,6 +393,41 @@ bool sync_lang_files(void)
     return true;
 }
 
+bool compile_lang_files(void)
+{
+    /* Writes compiled.vvvl for every language, from the XML files.
+     * Returns false if anything couldn't be compiled or saved. */
+    std::string oldlang = lang;
+    if (!FILESYSTEM_setLangWriteDir())
+    {
+        vlog_error("Cannot set write dir to lang dir, not compiling language files");
+        return false;
+    }
+
+    bool success = true;
+    for (size_t i = 0; i < languagelist.size(); i++)
+    {
+        if (languagelist[i].code == "en")
+        {
+            continue;
+        }
+
+        lang = languagelist[i].code;
+        loadtext(false, false);
+        if (!compile_text(lang))
+        {
+            vlog_error("Could not compile language files for %s", lang.c_str());
+            success = false;
+        }
+    }
+
+    FILESYSTEM_restoreWriteDir();
+    lang = oldlang;
+    loadtext(false);
+
+    return success;
+}
+
 bool save_roomname_to_file(const std::string& langcode, bool custom_level, int roomx, int roomy, const char* tra, const char* explanation)
 {
     if (custom_level)
@@ -485,8 +521,8 @@ void global_limits_check(void)
 
     std::string oldlang = lang;
 
-    textbook_clear(&textbook_main);
-    textbook_set_protected(&textbook_main, true);
+    stringpool_clear(&text_pool_main);
+    stringpool_set_protected(&text_pool_main, true);
 
     for (size_t i = 0; i < languagelist.size(); i++)
     {
@@ -500,11 +536,40 @@ void global_limits_check(void)
     lang = oldlang;
     loadtext(false);
 
-    textbook_set_protected(&textbook_main, false);
+    stringpool_set_protected(&text_pool_main, false);
 
     limitscheck_current_overflow = 0;
 }
 
+static void log_pool_stats(const char* name, const StringPool* pool)
+{
+    StringPoolStats stats;
+    stringpool_get_stats(pool, &stats);
+
+    if (stats.num_requests == 0)
+    {
+        vlog_info("Text pool %s: empty", name);
+        return;
+    }
+
+    vlog_info(
+        "Text pool %s: %u unique strings out of %u stored, %lu of %lu bytes used (saved %ld), %lu bytes allocated",
+        name,
+        stats.num_strings,
+        stats.num_requests,
+        (unsigned long) stats.bytes_stored,
+        (unsigned long) stats.bytes_requested,
+        (long) stats.bytes_requested - (long) stats.bytes_stored,
+        (unsigned long) stats.bytes_allocated
+    );
+}
+
+void log_text_pool_stats(void)
+{
+    log_pool_stats("main", &text_pool_main);
+    log_pool_stats("custom", &text_pool_custom);
+}
+
 void populate_testable_script_ids(void)
 {
     testable_script_ids.clear();
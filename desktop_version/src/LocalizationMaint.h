@@ -5,6 +5,7 @@ namespace loc
 {
 
 bool sync_lang_files(void);
+bool compile_lang_files(void);
 
 bool save_roomname_to_file(const std::string& langcode, bool custom_level, int roomx, int roomy, const char* tra, const char* explanation);
 bool save_roomname_explanation_to_files(bool custom_level, int roomx, int roomy, const char* explanation);
@@ -12,6 +13,9 @@ bool save_roomname_explanation_to_files(bool custom_level, int roomx, int roomy,
 void local_limits_check(void);
 void global_limits_check(void);
 
+/* How much memory the stored text takes, and how much deduplication saved */
+void log_text_pool_stats(void);
+
 void populate_testable_script_ids(void);
 bool populate_cutscene_test(const char* script_id);
 
@@ -1,13 +1,18 @@
 #define LOCALIZATIONSTORAGE_CPP
 #include "Localization.h"
 #include "LocalizationStorage.h"
+#include "LocalizationCompiled.h"
+
+#include <map>
 
 #include "Alloc.h"
 #include "Constants.h"
 #include "CustomLevels.h"
 #include "FileSystemUtils.h"
 #include "Font.h"
+#include "FontBidi.h"
 #include "Graphics.h"
+#include "Hash.h"
 #include "Unused.h"
 #include "UtilityClass.h"
 #include "VFormat.h"
@@ -55,6 +60,154 @@ bool load_lang_doc(
     return true;
 }
 
+enum LangDoc
+{
+    LANGDOC_NUMBERS,
+    LANGDOC_STRINGS,
+    LANGDOC_STRINGS_PLURAL,
+    LANGDOC_CUTSCENES,
+    LANGDOC_ROOMNAMES,
+    LANGDOC_ROOMNAMES_SPECIAL,
+
+    NUM_LANGDOCS
+};
+
+static const char* const langdoc_names[NUM_LANGDOCS] = {
+    "numbers",
+    "strings",
+    "strings_plural",
+    "cutscenes",
+    "roomnames",
+    "roomnames_special"
+};
+
+/* A language being read and parsed in the background, for loadtext() to
+ * pick up. Only the XML is handled here; storing the strings touches
+ * everything that gettext() reads, so that stays on the main thread. */
+struct LangLoadJob
+{
+    bool active;
+    std::string langcode;
+    bool parse_xml; /* false if compiled.vvvl will be used instead */
+    tinyxml2::XMLDocument docs[NUM_LANGDOCS];
+    bool found[NUM_LANGDOCS];
+    SDL_Thread* thread;
+    SDL_atomic_t done;
+    bool stale; /* A reread was asked for after this started, so it might have old files */
+};
+
+static LangLoadJob lang_load_job;
+
+static int SDLCALL lang_load_thread(void* userdata)
+{
+    LangLoadJob* job = (LangLoadJob*) userdata;
+
+    for (int i = 0; i < NUM_LANGDOCS; i++)
+    {
+        job->found[i] = job->parse_xml && load_lang_doc(langdoc_names[i], job->docs[i], job->langcode);
+    }
+
+    SDL_AtomicSet(&job->done, 1);
+    return 0;
+}
+
+static void wait_lang_load_job(void)
+{
+    if (lang_load_job.thread != NULL)
+    {
+        SDL_WaitThread(lang_load_job.thread, NULL);
+        lang_load_job.thread = NULL;
+    }
+}
+
+static void discard_lang_load_job(void)
+{
+    wait_lang_load_job();
+    lang_load_job.active = false;
+    lang_load_job.langcode.clear();
+    for (int i = 0; i < NUM_LANGDOCS; i++)
+    {
+        lang_load_job.docs[i].Clear();
+    }
+}
+
+static bool start_lang_load_job(const std::string& langcode, const bool reread)
+{
+    if (reread && lang_load_job.active && lang_load_job.langcode == langcode)
+    {
+        /* Even if it's still being read, it has to be read again once it's done */
+        lang_load_job.stale = true;
+    }
+    if (lang_load_job.active && lang_load_job.langcode == langcode && !lang_load_job.stale)
+    {
+        return true;
+    }
+    if (lang_load_job.active && !SDL_AtomicGet(&lang_load_job.done))
+    {
+        /* Busy; try again next frame */
+        return false;
+    }
+
+    discard_lang_load_job();
+
+    lang_load_job.active = true;
+    lang_load_job.langcode = langcode;
+    lang_load_job.stale = false;
+    lang_load_job.parse_xml = langcode != "en"
+        && (show_translator_menu || FILESYSTEM_fingerprintFile(("lang/" + langcode + "/compiled.vvvl").c_str()) == 0);
+    SDL_AtomicSet(&lang_load_job.done, 0);
+
+    lang_load_job.thread = SDL_CreateThread(
+        lang_load_thread,
+        "lang_load",
+        &lang_load_job
+    );
+    if (lang_load_job.thread == NULL)
+    {
+        vlog_warn("Could not create language loading thread, loading synchronously: %s", SDL_GetError());
+        lang_load_thread(&lang_load_job);
+    }
+    return true;
+}
+
+static bool load_main_lang_doc(const LangDoc which, tinyxml2::XMLDocument& local_doc, tinyxml2::XMLDocument** doc)
+{
+    /* Like load_lang_doc() for the current language, but takes
+     * the document from the background job if it has it. */
+    if (lang_load_job.active && lang_load_job.langcode == lang && lang_load_job.parse_xml && !lang_load_job.stale)
+    {
+        wait_lang_load_job();
+        *doc = &lang_load_job.docs[which];
+        return lang_load_job.found[which];
+    }
+
+    *doc = &local_doc;
+    return load_lang_doc(langdoc_names[which], local_doc);
+}
+
+bool prefetch_lang(const std::string& langcode, const bool reread /*= false*/)
+{
+    /* Both have to be tried, even if the first one is busy */
+    const bool started_text = start_lang_load_job(langcode, reread);
+    const bool started_sprites = graphics.grphx.prefetch_translations(langcode, reread);
+    return started_text && started_sprites;
+}
+
+bool is_lang_prefetched(const std::string& langcode)
+{
+    return lang_load_job.active
+    && lang_load_job.langcode == langcode
+    && !lang_load_job.stale
+    && SDL_AtomicGet(&lang_load_job.done)
+    && graphics.grphx.translations_prefetched(langcode);
+}
+
+void drop_prefetched_lang(void)
+{
+    discard_lang_load_job();
+    graphics.grphx.drop_prefetched_translations();
+}
+
 static void loadmeta(LangMeta& meta, const std::string& langcode = lang)
 {
     meta.active = true;
@@ -119,9 +272,9 @@ static void loadmeta(LangMeta& meta, const std::string& langcode = lang)
     }
 }
 
-static void map_store_translation(Textbook* textbook, hashmap* map, const char* eng, const char* tra)
+static void map_store_translation(StringPool* pool, hashmap* map, const char* eng, const char* tra)
 {
-    /* Add the texts to the given textbook and set the translation in the given hashmap. */
+    /* Add the texts to the given string pool and set the translation in the given hashmap. */
     if (eng == NULL)
     {
         return;
@@ -130,8 +283,8 @@ static void map_store_translation(Textbook* textbook, hashmap* map, const char*
     {
         tra = "";
     }
-    const char* tb_eng = textbook_store(textbook, eng);
-    const char* tb_tra = textbook_store(textbook, tra);
+    const char* tb_eng = stringpool_store(pool, eng);
+    const char* tb_tra = stringpool_store(pool, tra);
 
     if (tb_eng == NULL || tb_tra == NULL)
     {
@@ -180,13 +333,13 @@ static void resettext_custom(bool final_shutdown)
         hashmap_iterate(map_translation_cutscene_custom, callback_free_map_value, NULL);
         hashmap_free(map_translation_cutscene_custom);
 
-        textbook_clear(&textbook_custom);
+        stringpool_clear(&text_pool_custom);
     }
     else if (!final_shutdown)
     {
         inited_custom = true;
 
-        textbook_init(&textbook_custom);
+        stringpool_init(&text_pool_custom);
     }
 
     if (!final_shutdown)
@@ -217,6 +370,13 @@ void resettext(bool final_shutdown)
      * If final_shutdown, this just does a last cleanup of any allocations,
      * otherwise it makes storage ready for first use (or reuse by a new language). */
 
+    unload_compiled_text();
+
+    if (final_shutdown)
+    {
+        discard_lang_load_job();
+    }
+
     if (inited)
     {
         hashmap_free(map_translation);
@@ -225,13 +385,13 @@ void resettext(bool final_shutdown)
         hashmap_free(map_translation_plural);
         hashmap_free(map_translation_roomnames_special);
 
-        textbook_clear(&textbook_main);
+        stringpool_clear(&text_pool_main);
     }
     else if (!final_shutdown)
     {
         inited = true;
 
-        textbook_init(&textbook_main);
+        stringpool_init(&text_pool_main);
     }
 
     if (!final_shutdown)
@@ -295,13 +455,52 @@ bool parse_max(const char* max, unsigned short* max_w, unsigned short* max_h)
     return *max_w != 0 && *max_h != 0;
 }
 
-static bool max_check_string(const char* str, const char* max)
+/* Limits checks are only collected while loading, and measured all at once
+ * afterwards by run_max_checks(), spread over as many threads as there are
+ * CPUs. The results of the last run are kept by hash, so checking the same
+ * language again only measures what changed. */
+struct MaxCheck
+{
+    std::string text;
+    std::string text_bidi; /* For single lines that need it, empty otherwise */
+    std::string max;
+    uint32_t print_flags;
+    uint8_t font_w, font_h;
+    unsigned short max_w_px, max_h_px;
+    bool multiline;
+    int group; /* Only the first overflow in a group is reported, 0 for none */
+    uint64_t hash;
+    bool does_overflow;
+};
+
+static std::vector<MaxCheck> max_checks;
+static std::map<uint64_t, bool> max_check_results;
+static int max_check_groups = 0;
+
+static uint64_t max_check_hash(const MaxCheck& check)
+{
+    /* Hashes everything the outcome depends on */
+    uint64_t hash = hash_fnv1a64_str(HASH_FNV1A64_INIT, check.text.c_str());
+    const uint32_t params[4] = {
+        check.print_flags,
+        check.max_w_px,
+        check.max_h_px,
+        (uint32_t) get_langmeta()->autowordwrap
+    };
+    for (size_t i = 0; i < SDL_arraysize(params); i++)
+    {
+        hash = hash_fnv1a64_value(hash, params[i]);
+    }
+    return hash;
+}
+
+static void max_check_string(const char* str, const char* max, int group = 0)
 {
-    /* Stores a detected overflow in the overflows vector, returns true if this happened */
+    /* Queues a check, an overflow will end up in the overflows vector after run_max_checks() */
     unsigned short max_w, max_h;
     if (str == NULL || !parse_max(max, &max_w, &max_h))
     {
-        return false;
+        return;
     }
 
     /* Special case that must ALWAYS be 2 lines even when the font is bigger */
@@ -311,58 +510,190 @@ static bool max_check_string(const char* str, const char* max)
     }
 
     uint8_t font_idx = get_langmeta()->font_idx;
-    uint32_t print_flags = PR_FONT_IDX(font_idx, get_langmeta()->rtl) | PR_CJK_LOW;
-    uint8_t font_w = 8;
-    uint8_t font_h = 8;
-    font::glyph_dimensions(print_flags, &font_w, &font_h);
+    bool rtl = get_langmeta()->rtl;
 
-    unsigned short max_w_px = max_w * 8;
-    unsigned short max_h_px = max_h * 10;
+    MaxCheck check;
+    check.text = str;
+    check.max = max;
+    check.print_flags = PR_FONT_IDX(font_idx, rtl) | PR_CJK_LOW;
+    check.font_w = 8;
+    check.font_h = 8;
+    font::glyph_dimensions(check.print_flags, &check.font_w, &check.font_h);
 
-    bool does_overflow = false;
+    check.max_w_px = max_w * 8;
+    check.max_h_px = max_h * 10;
+    check.multiline = max_h > 1;
+    if (!check.multiline)
+    {
+        check.max_h_px = check.font_h;
 
-    if (max_h == 1)
+        /* The bidi transform isn't safe to do on other threads */
+        if (font::bidi_should_transform(rtl, str))
+        {
+            check.text_bidi = font::bidi_transform(rtl, str);
+        }
+    }
+    check.group = group;
+    check.hash = max_check_hash(check);
+    check.does_overflow = false;
+
+    max_checks.push_back(check);
+}
+
+static bool measure_max_check(const MaxCheck& check)
+{
+    if (!check.multiline)
     {
-        max_h_px = font_h;
-        does_overflow = font::len(print_flags, str) > (int) max_w_px;
+        const char* text = check.text_bidi.empty() ? check.text.c_str() : check.text_bidi.c_str();
+        return font::len_no_bidi(check.print_flags, text) > (int) check.max_w_px;
     }
-    else
+
+    short lines = font::count_lines(check.print_flags, check.text.c_str(), check.max_w_px);
+    return lines*SDL_max(10, check.font_h) > (short) check.max_h_px;
+}
+
+struct MaxCheckPass
+{
+    std::vector<MaxCheck*> todo;
+    SDL_atomic_t next_check;
+};
+
+static int max_check_thread(void* userdata)
+{
+    MaxCheckPass* pass = (MaxCheckPass*) userdata;
+
+    while (true)
     {
-        short lines;
-        font::string_wordwrap(print_flags, str, max_w_px, &lines);
-        does_overflow = lines*SDL_max(10, font_h) > (short) max_h_px;
+        const int i = SDL_AtomicAdd(&pass->next_check, 1);
+        if (i >= (int) pass->todo.size())
+        {
+            break;
+        }
+
+        pass->todo[i]->does_overflow = measure_max_check(*pass->todo[i]);
     }
 
+    return 0;
+}
+
+static void report_max_check(const MaxCheck& check)
+{
     // Convert max_w and max_h from 8x8 into local
-    max_w = max_w_px / font_w;
-    max_h = max_h_px / SDL_max(10, font_h);
+    unsigned short max_w = check.max_w_px / check.font_w;
+    unsigned short max_h = check.max_h_px / SDL_max(10, check.font_h);
 
-    if (does_overflow)
+    if (check.does_overflow)
     {
         TextOverflow overflow;
         overflow.lang = lang;
-        overflow.text = textbook_store(&textbook_main, str);
+        overflow.text = stringpool_store(&text_pool_main, check.text.c_str());
         overflow.max_w = max_w;
         overflow.max_h = max_h;
-        overflow.max_w_px = max_w_px;
-        overflow.max_h_px = max_h_px;
+        overflow.max_w_px = check.max_w_px;
+        overflow.max_h_px = check.max_h_px;
         overflow.multiline = max_h > 1;
-        overflow.flags = print_flags;
+        overflow.flags = check.print_flags;
 
         text_overflows.push_back(overflow);
 
         vlog_warn("\"%s\" DOESN'T FIT into %s which is %dx%d or %dx%dpx",
-            str, max, max_w, max_h, max_w_px, max_h_px
+            check.text.c_str(), check.max.c_str(), max_w, max_h, check.max_w_px, check.max_h_px
         );
     }
     else
     {
         vlog_debug("\"%s\" fits into %s which is %dx%d or %dx%dpx",
-            str, max, max_w, max_h, max_w_px, max_h_px
+            check.text.c_str(), check.max.c_str(), max_w, max_h, check.max_w_px, check.max_h_px
         );
     }
+}
+
+static void run_max_checks(void)
+{
+    /* Measures all queued checks that don't have a known result yet, then
+     * reports all of them in the order they were queued. Each check only
+     * writes to itself, so no locking is needed while measuring. */
+    MaxCheckPass pass;
+    SDL_Thread* threads[16];
+    int num_threads = SDL_clamp(SDL_GetCPUCount(), 1, (int) SDL_arraysize(threads));
+    const Uint64 start = SDL_GetPerformanceCounter();
+
+    uint32_t loaded_flags = 0;
+    for (size_t i = 0; i < max_checks.size(); i++)
+    {
+        std::map<uint64_t, bool>::const_iterator result = max_check_results.find(max_checks[i].hash);
+        if (result != max_check_results.end())
+        {
+            max_checks[i].does_overflow = result->second;
+            continue;
+        }
+
+        if (pass.todo.empty() || max_checks[i].print_flags != loaded_flags)
+        {
+            /* The threads may only read the font */
+            loaded_flags = max_checks[i].print_flags;
+            font::load_all_glyph_pages(loaded_flags);
+        }
+        pass.todo.push_back(&max_checks[i]);
+    }
+
+    if (!pass.todo.empty())
+    {
+        /* Not worth spinning up threads for a handful of strings */
+        num_threads = SDL_min(num_threads, (int) (pass.todo.size() + 63) / 64);
+
+        SDL_AtomicSet(&pass.next_check, 0);
+        for (int i = 1; i < num_threads; i++)
+        {
+            threads[i] = SDL_CreateThread(max_check_thread, "max_check", &pass);
+        }
+        /* The main thread helps out too */
+        max_check_thread(&pass);
+        for (int i = 1; i < num_threads; i++)
+        {
+            if (threads[i] != NULL)
+            {
+                SDL_WaitThread(threads[i], NULL);
+            }
+        }
+    }
+
+    /* Only remember the results of this run, so the cache stays the size of
+     * one language instead of growing with every language and every edit */
+    std::map<uint64_t, bool> results;
+    for (size_t i = 0; i < max_checks.size(); i++)
+    {
+        results[max_checks[i].hash] = max_checks[i].does_overflow;
+    }
+    max_check_results.swap(results);
+
+    int overflowed_group = 0;
+    for (size_t i = 0; i < max_checks.size(); i++)
+    {
+        const MaxCheck& check = max_checks[i];
+        if (check.group != 0 && check.group == overflowed_group)
+        {
+            /* One is enough */
+            continue;
+        }
+
+        report_max_check(check);
 
-    return does_overflow;
+        if (check.does_overflow)
+        {
+            overflowed_group = check.group;
+        }
+    }
+
+    vlog_debug(
+        "Checked %i strings (%i measured) on %i threads in %.2f ms",
+        (int) max_checks.size(),
+        (int) pass.todo.size(),
+        pass.todo.empty() ? 0 : num_threads,
+        (SDL_GetPerformanceCounter() - start) * 1000.0 / SDL_GetPerformanceFrequency()
+    );
+
+    max_checks.clear();
 }
 
 static void max_check_string_plural(unsigned char form, const char* str, const char* max, const char* var, unsigned int expect)
@@ -391,18 +722,16 @@ static void max_check_string_plural(unsigned char form, const char* str, const c
     }
     else
     {
-        /* Test all numbers from 0 to `expect`, since if we have wordy numbers, they have differing lengths */
+        /* Test all numbers from 0 to `expect`, since if we have wordy numbers, they have differing lengths.
+         * Only the first one that doesn't fit gets reported. */
+        const int group = ++max_check_groups;
         for (unsigned int test = 0; test <= expect; test++)
         {
             if (form_for_count(test) == form)
             {
                 vformat_buf(buf, sizeof(buf), str, args_index, test, 0);
 
-                if (max_check_string(buf, max))
-                {
-                    /* One is enough */
-                    break;
-                }
+                max_check_string(buf, max, group);
             }
         }
     }
@@ -424,14 +753,15 @@ static void tally_untranslated(const char* tra, int* counter)
 
 static void loadtext_strings(bool check_max)
 {
-    tinyxml2::XMLDocument doc;
-    tinyxml2::XMLHandle hDoc(&doc);
+    tinyxml2::XMLDocument local_doc;
+    tinyxml2::XMLDocument* doc;
     tinyxml2::XMLElement* pElem;
 
-    if (!load_lang_doc("strings", doc))
+    if (!load_main_lang_doc(LANGDOC_STRINGS, local_doc, &doc))
     {
         return;
     }
+    tinyxml2::XMLHandle hDoc(doc);
 
     FOR_EACH_XML_ELEMENT(hDoc, pElem)
     {
@@ -445,7 +775,7 @@ static void loadtext_strings(bool check_max)
         if (textcase == 0)
         {
             map_store_translation(
-                &textbook_main,
+                &text_pool_main,
                 map_translation,
                 eng,
                 tra
@@ -460,7 +790,7 @@ static void loadtext_strings(bool check_max)
                 continue;
             }
             map_store_translation(
-                &textbook_main,
+                &text_pool_main,
                 map_translation,
                 eng_prefixed,
                 tra
@@ -486,14 +816,15 @@ static void loadtext_strings(bool check_max)
 
 static void loadtext_strings_plural(bool check_max)
 {
-    tinyxml2::XMLDocument doc;
-    tinyxml2::XMLHandle hDoc(&doc);
+    tinyxml2::XMLDocument local_doc;
+    tinyxml2::XMLDocument* doc;
     tinyxml2::XMLElement* pElem;
 
-    if (!load_lang_doc("strings_plural", doc))
+    if (!load_main_lang_doc(LANGDOC_STRINGS_PLURAL, local_doc, &doc))
     {
         return;
     }
+    tinyxml2::XMLHandle hDoc(doc);
 
     FOR_EACH_XML_ELEMENT(hDoc, pElem)
     {
@@ -518,7 +849,7 @@ static void loadtext_strings_plural(bool check_max)
             }
 
             map_store_translation(
-                &textbook_main,
+                &text_pool_main,
                 map_translation_plural,
                 key,
                 subElem->Attribute("translation")
@@ -610,32 +941,36 @@ static std::string& get_level_lang_code(bool custom_level)
 
 static void loadtext_cutscenes(bool custom_level)
 {
-    tinyxml2::XMLDocument doc;
-    tinyxml2::XMLHandle hDoc(&doc);
+    tinyxml2::XMLDocument local_doc;
+    tinyxml2::XMLDocument* doc = &local_doc;
     tinyxml2::XMLElement* pElem;
 
     std::string doc_path;
     std::string doc_path_asset;
     bool valid_custom_level = get_level_lang_path(custom_level, "cutscenes", doc_path, doc_path_asset);
-    if (custom_level && !valid_custom_level)
+    if (custom_level)
     {
-        return;
+        if (!valid_custom_level || !load_lang_doc(doc_path, local_doc, get_level_lang_code(custom_level), doc_path_asset))
+        {
+            return;
+        }
     }
-    if (!load_lang_doc(doc_path, doc, get_level_lang_code(custom_level), doc_path_asset))
+    else if (!load_main_lang_doc(LANGDOC_CUTSCENES, local_doc, &doc))
     {
         return;
     }
+    tinyxml2::XMLHandle hDoc(doc);
 
-    Textbook* textbook;
+    StringPool* pool;
     hashmap* map;
     if (custom_level)
     {
-        textbook = &textbook_custom;
+        pool = &text_pool_custom;
         map = map_translation_cutscene_custom;
     }
     else
     {
-        textbook = &textbook_main;
+        pool = &text_pool_main;
         map = map_translation_cutscene;
     }
 
@@ -645,7 +980,7 @@ static void loadtext_cutscenes(bool custom_level)
     {
         EXPECT_ELEM(pElem, "cutscene");
 
-        const char* script_id = textbook_store(textbook, pElem->Attribute("id"));
+        const char* script_id = stringpool_store(pool, pElem->Attribute("id"));
         if (script_id == NULL)
         {
             continue;
@@ -682,8 +1017,8 @@ static void loadtext_cutscenes(bool custom_level)
             {
                 continue;
             }
-            const char* tb_eng = textbook_store(textbook, eng_prefixed);
-            const char* tb_tra = textbook_store(textbook, tra);
+            const char* tb_eng = stringpool_store(pool, eng_prefixed);
+            const char* tb_tra = stringpool_store(pool, tra);
             VVV_free(eng_prefixed);
             if (tb_eng == NULL || tb_tra == NULL)
             {
@@ -706,8 +1041,8 @@ static void loadtext_cutscenes(bool custom_level)
             }
             format.padtowidth = subElem->UnsignedAttribute("padtowidth", 0);
 
-            const TextboxFormat* tb_format = (TextboxFormat*) textbook_store_raw(
-                textbook,
+            const TextboxFormat* tb_format = (TextboxFormat*) stringpool_store_raw(
+                pool,
                 &format,
                 sizeof(TextboxFormat)
             );
@@ -722,14 +1057,15 @@ static void loadtext_cutscenes(bool custom_level)
 
 static void loadtext_numbers(void)
 {
-    tinyxml2::XMLDocument doc;
-    tinyxml2::XMLHandle hDoc(&doc);
+    tinyxml2::XMLDocument local_doc;
+    tinyxml2::XMLDocument* doc;
     tinyxml2::XMLElement* pElem;
 
-    if (!load_lang_doc("numbers", doc))
+    if (!load_main_lang_doc(LANGDOC_NUMBERS, local_doc, &doc))
     {
         return;
     }
+    tinyxml2::XMLHandle hDoc(doc);
 
     FOR_EACH_XML_ELEMENT(hDoc, pElem)
     {
@@ -893,9 +1229,9 @@ bool store_roomname_translation(bool custom_level, int roomx, int roomy, const c
         return false;
     }
 
-    /* We have some arrays filled with pointers, and we need to change those pointers */
-    const char** ptr_translation;
-    const char** ptr_explanation;
+    /* We have some arrays filled with handles, and we need to change those handles */
+    StringHandle* ptr_translation;
+    StringHandle* ptr_explanation;
     int* ptr_n_untranslated;
     int* ptr_n_untranslated_area = NULL;
     int* ptr_n_unexplained;
@@ -917,13 +1253,23 @@ bool store_roomname_translation(bool custom_level, int roomx, int roomy, const c
 
     if (tra != NULL)
     {
-        update_left_counter(*ptr_translation, tra, ptr_n_untranslated, ptr_n_untranslated_area);
-        *ptr_translation = textbook_store(&textbook_main, tra);
+        update_left_counter(
+            stringpool_get(&text_pool_main, *ptr_translation),
+            tra,
+            ptr_n_untranslated,
+            ptr_n_untranslated_area
+        );
+        *ptr_translation = stringpool_intern(&text_pool_main, tra);
     }
     if (explanation != NULL)
     {
-        update_left_counter(*ptr_explanation, explanation, ptr_n_unexplained, NULL);
-        *ptr_explanation = textbook_store(&textbook_main, explanation);
+        update_left_counter(
+            stringpool_get(&text_pool_main, *ptr_explanation),
+            explanation,
+            ptr_n_unexplained,
+            NULL
+        );
+        *ptr_explanation = stringpool_intern(&text_pool_main, explanation);
     }
 
     return true;
@@ -931,21 +1277,25 @@ bool store_roomname_translation(bool custom_level, int roomx, int roomy, const c
 
 static void loadtext_roomnames(bool custom_level, bool check_max)
 {
-    tinyxml2::XMLDocument doc;
-    tinyxml2::XMLHandle hDoc(&doc);
+    tinyxml2::XMLDocument local_doc;
+    tinyxml2::XMLDocument* doc = &local_doc;
     tinyxml2::XMLElement* pElem;
 
     std::string doc_path;
     std::string doc_path_asset;
     bool valid_custom_level = get_level_lang_path(custom_level, "roomnames", doc_path, doc_path_asset);
-    if (custom_level && !valid_custom_level)
+    if (custom_level)
     {
-        return;
+        if (!valid_custom_level || !load_lang_doc(doc_path, local_doc, get_level_lang_code(custom_level), doc_path_asset))
+        {
+            return;
+        }
     }
-    if (!load_lang_doc(doc_path, doc, get_level_lang_code(custom_level), doc_path_asset))
+    else if (!load_main_lang_doc(LANGDOC_ROOMNAMES, local_doc, &doc))
     {
         return;
     }
+    tinyxml2::XMLHandle hDoc(doc);
 
     const char* original = get_level_original_lang(hDoc);
 
@@ -998,21 +1348,22 @@ static void loadtext_roomnames(bool custom_level, bool check_max)
 
 static void loadtext_roomnames_special(bool check_max)
 {
-    tinyxml2::XMLDocument doc;
-    tinyxml2::XMLHandle hDoc(&doc);
+    tinyxml2::XMLDocument local_doc;
+    tinyxml2::XMLDocument* doc;
     tinyxml2::XMLElement* pElem;
 
-    if (!load_lang_doc("roomnames_special", doc))
+    if (!load_main_lang_doc(LANGDOC_ROOMNAMES_SPECIAL, local_doc, &doc))
     {
         return;
     }
+    tinyxml2::XMLHandle hDoc(doc);
 
     FOR_EACH_XML_ELEMENT(hDoc, pElem)
     {
         EXPECT_ELEM(pElem, "roomname");
 
         map_store_translation(
-            &textbook_main,
+            &text_pool_main,
             map_translation_roomnames_special,
             pElem->Attribute("english"),
             pElem->Attribute("translation")
@@ -1038,11 +1389,14 @@ void loadtext_custom(const char* custom_path)
     loadtext_roomnames(true, false);
 }
 
-void loadtext(bool check_max)
+void loadtext(bool check_max, bool allow_compiled /*= true*/)
 {
     resettext(false);
     loadmeta(langmeta);
 
+    // Text may wrap differently in the new language
+    font::clear_layout_cache();
+
     if (lang == "en")
     {
         if (show_translator_menu)
@@ -1053,6 +1407,11 @@ void loadtext(bool check_max)
             SDL_zeroa(n_untranslated_roomnames_area);
         }
     }
+    else if (allow_compiled && !check_max && !show_translator_menu && load_compiled_text(lang))
+    {
+        /* Translators need the XML (explanations, untranslated counts, limits
+         * checks), everyone else gets everything from compiled.vvvl */
+    }
     else
     {
         loadtext_numbers();
@@ -1061,6 +1420,17 @@ void loadtext(bool check_max)
         loadtext_cutscenes(false);
         loadtext_roomnames(false, check_max);
         loadtext_roomnames_special(check_max);
+
+        if (check_max)
+        {
+            run_max_checks();
+        }
+    }
+
+    if (lang_load_job.active && lang_load_job.langcode == lang)
+    {
+        /* Used up */
+        discard_lang_load_job();
     }
 
     if (custom_level_path != NULL)
@@ -3,7 +3,7 @@
 
 #include <tinyxml2.h>
 
-#include "Textbook.h"
+#include "StringPool.h"
 #include "XMLUtils.h"
 
 extern "C"
@@ -20,9 +20,9 @@ extern "C"
 namespace loc
 {
 
-#if defined(LOCALIZATION_CPP) || defined(LOCALIZATIONSTORAGE_CPP) || defined(LOCALIZATIONMAINT_CPP)
-    LS_INTERN Textbook textbook_main;
-    LS_INTERN Textbook textbook_custom;
+#if defined(LOCALIZATION_CPP) || defined(LOCALIZATIONSTORAGE_CPP) || defined(LOCALIZATIONMAINT_CPP) || defined(LOCALIZATIONCOMPILED_CPP)
+    LS_INTERN StringPool text_pool_main;
+    LS_INTERN StringPool text_pool_custom;
 
     LS_INTERN hashmap* map_translation;
     LS_INTERN hashmap* map_translation_plural;
@@ -37,10 +37,11 @@ namespace loc
     #define MAP_MAX_Y 56
     #define CUSTOM_MAP_MAX_X 19
     #define CUSTOM_MAP_MAX_Y 19
-    LS_INTERN const char* translation_roomnames[MAP_MAX_Y+1][MAP_MAX_X+1];
-    LS_INTERN const char* explanation_roomnames[MAP_MAX_Y+1][MAP_MAX_X+1];
-    LS_INTERN const char* translation_roomnames_custom[CUSTOM_MAP_MAX_Y+1][CUSTOM_MAP_MAX_X+1];
-    LS_INTERN const char* explanation_roomnames_custom[CUSTOM_MAP_MAX_Y+1][CUSTOM_MAP_MAX_X+1];
+    /* Handles into text_pool_main, 0 if there's no text for that room */
+    LS_INTERN StringHandle translation_roomnames[MAP_MAX_Y+1][MAP_MAX_X+1];
+    LS_INTERN StringHandle explanation_roomnames[MAP_MAX_Y+1][MAP_MAX_X+1];
+    LS_INTERN StringHandle translation_roomnames_custom[CUSTOM_MAP_MAX_Y+1][CUSTOM_MAP_MAX_X+1];
+    LS_INTERN StringHandle explanation_roomnames_custom[CUSTOM_MAP_MAX_Y+1][CUSTOM_MAP_MAX_X+1];
 #endif
 
 
@@ -77,7 +78,18 @@ bool store_roomname_translation(bool custom_level, int roomx, int roomy, const c
 
 bool fix_room_coords(bool custom_level, int* roomx, int* roomy);
 
-void loadtext(bool check_max);
+void loadtext(bool check_max, bool allow_compiled = true);
+
+/* Starts reading a language's files (and translated sprites) in the
+ * background, so loadtext() and init_translations() for it are quick.
+ * Returns false if another language is still being read, in which case
+ * nothing was started and it should be tried again later.
+ * reread throws away what was read before, for if the files changed;
+ * if it's still being read, it's read again once that's done. */
+bool prefetch_lang(const std::string& langcode, bool reread = false);
+bool is_lang_prefetched(const std::string& langcode);
+/* Throws away whatever prefetch_lang() read, once it won't be needed */
+void drop_prefetched_lang(void);
 void loadtext_custom(const char* custom_path);
 void loadlanguagelist(void);
 
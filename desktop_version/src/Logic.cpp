@@ -1,4 +1,5 @@
 #include "Credits.h"
+#include "CustomLevels.h"
 #include "Entity.h"
 #include "Enums.h"
 #include "FileSystemUtils.h"
@@ -1434,3 +1435,11 @@ void gamelogic(void)
 
     level_debugger::logic();
 }
+
+void loadinglogic(void)
+{
+    if (cl.loadingprogress() >= 100)
+    {
+        script.startgamemode(script.loadingmode);
+    }
+}
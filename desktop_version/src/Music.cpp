@@ -7,6 +7,7 @@
 
 #include "Alloc.h"
 #include "BinaryBlob.h"
+#include "Exit.h"
 #include "FileSystemUtils.h"
 #include "Game.h"
 #include "Graphics.h"
@@ -82,6 +83,14 @@
 #define VVV_MAX_VOLUME 128
 #define VVV_MAX_CHANNELS 8
 
+/* How much PCM the decoder thread keeps ahead, in milliseconds. The voice
+ * plays silence if the ring runs dry, so this is sized to ride out the
+ * decoder being held up (by a track being set up, or Play() holding
+ * decoder_lock), not just to cover the next buffer or two. Rounding up to a
+ * power of two makes it between this and twice this much: 256 KB per
+ * playing track for 44.1 kHz stereo. */
+#define VVV_MUSIC_RING_MS 500
+
 class SoundTrack;
 class MusicTrack;
 static std::vector<SoundTrack> soundTracks;
@@ -90,6 +99,77 @@ static std::vector<MusicTrack> musicTracks;
 static FAudio* faudioctx = NULL;
 static FAudioMasteringVoice* masteringvoice = NULL;
 
+/* Music decoding happens on its own thread, so the FAudio callbacks only ever
+ * have to copy PCM out of a ring buffer. decoder_lock is held by whoever is
+ * touching a track's Vorbis state (the decoder thread, or the game thread
+ * when (re)starting a track). The FAudio callbacks never take it. */
+static SDL_Thread* decoder_thread = NULL;
+static SDL_mutex* decoder_lock = NULL;
+static SDL_sem* decoder_wake = NULL;
+static SDL_atomic_t decoder_quit;
+static float decoder_scratch[4096];
+
+/* Bytes of decoder state loaded music tracks may use, 0 for no limit */
+static size_t memory_budget = 0;
+static void enforce_memory_budget(const MusicTrack* keep);
+
+/* Offline rendering: instead of going through FAudio, music and sound
+ * effects are mixed on the game thread every fixed step and written to
+ * a WAV file. See musicclass::renderpath. */
+#define VVV_RENDER_RATE 44100
+#define VVV_RENDER_CHUNK 1024
+
+struct RenderVoice
+{
+    SoundTrack* track;
+    Uint32 cursor; /* In source frames */
+    Uint32 phase;
+    Uint32 started;
+};
+
+static bool rendering = false;
+static bool render_sounds_paused = false;
+static struct RenderVoice render_voices[VVV_MAX_CHANNELS];
+static SDL_RWops* render_out = NULL;
+static Uint32 render_data_bytes = 0;
+static Uint32 render_remainder = 0;
+static Uint64 render_start = 0;
+
+/* Sound effects play on voices from pools created up front, one pool per
+ * distinct format, so playing an effect never creates a voice. When a pool
+ * is full, the lowest priority (then oldest) effect gets cut off, as long as
+ * it's not more important than the new one. */
+struct PooledVoice
+{
+    FAudioSourceVoice* voice;
+    FAudioWaveFormatEx format;
+    bool streaming; /* Ogg effects need the buffer callbacks */
+    SoundTrack* track;
+    int priority;
+    Uint32 started;
+};
+
+static int sound_priority(const int sound)
+{
+    switch (sound)
+    {
+    case Sound_NEWRECORD:
+    case Sound_TROPHY:
+    case Sound_GAMESAVED:
+    case Sound_RESCUE:
+    case Sound_TRINKET:
+    case Sound_COUNTDOWN:
+    case Sound_GO:
+        return 2;
+    case Sound_FLIP:
+    case Sound_UNFLIP:
+    case Sound_GRAVITYLINE:
+    case Sound_TERMINALTEXT:
+        return 0;
+    }
+    return 1;
+}
+
 class SoundTrack
 {
 public:
@@ -108,11 +188,10 @@ public:
         }
 
         SDL_zerop(this);
+        voice_index = -1;
         if (length >= 4 && SDL_memcmp(mem, "OggS", 4) == 0)
         {
             LoadOGG(fileName, mem, length);
-            callbacks.OnBufferStart = &SoundTrack::refillReserve;
-            callbacks.OnBufferEnd = &SoundTrack::swapBuffers;
         }
         else
         {
@@ -180,6 +259,7 @@ end:
         VVV_free(decoded_buf_reserve);
         VVV_freefunc(stb_vorbis_close, vorbis);
         VVV_free(ogg_file);
+        VVV_free(render_pcm);
     }
 
     void Play(void)
@@ -189,105 +269,264 @@ end:
             return;
         }
 
-        for (int i = 0; i < VVV_MAX_CHANNELS; i++)
+        if (rendering)
+        {
+            PlayRendered();
+            return;
+        }
+
+        PooledVoice* pooled = NULL;
+        PooledVoice* victim = NULL;
+        for (int i = 0; i < num_voices; i++)
         {
+            PooledVoice* candidate = &voices[i];
+            if (candidate->voice == NULL
+            || candidate->streaming != (vorbis != NULL)
+            || SDL_memcmp(&candidate->format, &format, sizeof(format)) != 0)
+            {
+                continue;
+            }
+
             FAudioVoiceState voicestate;
-            FAudioSourceVoice_GetState(voices[i], &voicestate, 0);
+            FAudioSourceVoice_GetState(candidate->voice, &voicestate, 0);
             if (voicestate.BuffersQueued == 0)
             {
-                if (SDL_memcmp(&voice_formats[i], &format, sizeof(format)) != 0)
+                pooled = candidate;
+                break;
+            }
+
+            if (candidate->priority <= priority
+            && (victim == NULL
+            || candidate->priority < victim->priority
+            || (candidate->priority == victim->priority && candidate->started < victim->started)))
+            {
+                victim = candidate;
+            }
+        }
+
+        if (pooled == NULL)
+        {
+            if (victim == NULL)
+            {
+                /* Everything playing is more important than us */
+                return;
+            }
+
+            pooled = victim;
+            FAudioSourceVoice_Stop(pooled->voice, 0, FAUDIO_COMMIT_NOW);
+            FAudioSourceVoice_FlushSourceBuffers(pooled->voice);
+            if (pooled->track != NULL && pooled->track->voice_index == pooled - voices)
+            {
+                pooled->track->voice_index = -1;
+            }
+        }
+
+        pooled->track = this;
+        pooled->priority = priority;
+        pooled->started = ++play_counter;
+        voice_index = pooled - voices;
+
+        FAudioBuffer faudio_buffer = {
+            FAUDIO_END_OF_STREAM, /* Flags */
+            wav_length * 8, /* AudioBytes */
+            wav_buffer, /* AudioData */
+            0, /* playbegin */
+            0, /* playlength */
+            0, /* LoopBegin */
+            0, /* LoopLength */
+            0, /* LoopCount */
+            NULL
+        };
+        if (vorbis != NULL)
+        {
+            stb_vorbis_seek_start(vorbis);
+            faudio_buffer.PlayLength = stb_vorbis_get_samples_float_interleaved(
+                vorbis,
+                channels,
+                (float*) decoded_buf_playing,
+                size / sizeof(float)
+            );
+            faudio_buffer.AudioBytes = size;
+            faudio_buffer.pAudioData = decoded_buf_playing;
+            faudio_buffer.pContext = this;
+        }
+        if (FAudioSourceVoice_SubmitSourceBuffer(pooled->voice, &faudio_buffer, NULL))
+        {
+            vlog_error("Unable to queue sound buffer");
+            voice_index = -1;
+            return;
+        }
+        FAudioVoice_SetVolume(pooled->voice, volume, FAUDIO_COMMIT_NOW);
+        if (FAudioSourceVoice_Start(pooled->voice, 0, FAUDIO_COMMIT_NOW))
+        {
+            vlog_error("Unable to start voice processing");
+            voice_index = -1;
+        }
+    }
+
+    void PlayRendered(void)
+    {
+        if (vorbis != NULL && render_pcm == NULL)
+        {
+            /* Effects are short, just decode the whole thing up front */
+            Uint32 capacity = 0;
+            stb_vorbis_seek_start(vorbis);
+            while (true)
+            {
+                if ((render_pcm_frames + 4096) * channels > capacity)
                 {
-                    VVV_freefunc(FAudioVoice_DestroyVoice, voices[i]);
-                    if (vorbis != NULL)
-                    {
-                        FAudio_CreateSourceVoice(faudioctx, &voices[i], &format, 0, 2.0f, &callbacks, NULL, NULL);
-                    }
-                    else
+                    capacity = (render_pcm_frames + 4096) * channels * 2;
+                    float* pcm = (float*) SDL_realloc(render_pcm, capacity * sizeof(float));
+                    if (pcm == NULL)
                     {
-                        FAudio_CreateSourceVoice(faudioctx, &voices[i], &format, 0, 2.0f, NULL, NULL, NULL);
+                        VVV_exit(1);
                     }
-                    voice_formats[i] = format;
-                }
-                FAudioBuffer faudio_buffer = {
-                    FAUDIO_END_OF_STREAM, /* Flags */
-                    wav_length * 8, /* AudioBytes */
-                    wav_buffer, /* AudioData */
-                    0, /* playbegin */
-                    0, /* playlength */
-                    0, /* LoopBegin */
-                    0, /* LoopLength */
-                    0, /* LoopCount */
-                    NULL
-                };
-                if (vorbis != NULL)
-                {
-                    stb_vorbis_seek_start(vorbis);
-                    faudio_buffer.PlayLength = stb_vorbis_get_samples_float_interleaved(
-                        vorbis,
-                        channels,
-                        (float*) decoded_buf_playing,
-                        size / sizeof(float)
-                    );
-                    faudio_buffer.AudioBytes = size;
-                    faudio_buffer.pAudioData = decoded_buf_playing;
-                    faudio_buffer.pContext = this;
-                }
-                if (FAudioSourceVoice_SubmitSourceBuffer(voices[i], &faudio_buffer, NULL))
-                {
-                    vlog_error("Unable to queue sound buffer");
-                    voice_index = -1;
-                    return;
+                    render_pcm = pcm;
                 }
-                FAudioVoice_SetVolume(voices[i], volume, FAUDIO_COMMIT_NOW);
-                if (FAudioSourceVoice_Start(voices[i], 0, FAUDIO_COMMIT_NOW))
+                const int frames = stb_vorbis_get_samples_float_interleaved(
+                    vorbis,
+                    channels,
+                    &render_pcm[render_pcm_frames * channels],
+                    4096 * channels
+                );
+                if (frames <= 0)
                 {
-                    vlog_error("Unable to start voice processing");
-                    voice_index = -1;
+                    break;
                 }
-                voice_index = i;
-                return;
+                render_pcm_frames += frames;
             }
         }
+
+        /* Same voice stealing rules as the FAudio pools */
+        struct RenderVoice* victim = NULL;
+        for (int i = 0; i < VVV_MAX_CHANNELS; i++)
+        {
+            struct RenderVoice* candidate = &render_voices[i];
+            if (candidate->track == NULL)
+            {
+                victim = candidate;
+                break;
+            }
+            if (candidate->track->priority <= priority
+            && (victim == NULL
+            || candidate->track->priority < victim->track->priority
+            || (candidate->track->priority == victim->track->priority && candidate->started < victim->started)))
+            {
+                victim = candidate;
+            }
+        }
+
+        if (victim != NULL)
+        {
+            victim->track = this;
+            victim->cursor = 0;
+            victim->phase = 0;
+            victim->started = ++play_counter;
+        }
     }
 
-    static void Init(int audio_rate)
+    static void Init(const std::vector<SoundTrack>& tracks)
     {
+        if (rendering || voices != NULL)
+        {
+            return;
+        }
+
+        std::vector<PooledVoice> pools;
+        for (size_t i = 0; i < tracks.size(); i++)
+        {
+            const SoundTrack* track = &tracks[i];
+            bool found = false;
+            if (!track->valid)
+            {
+                continue;
+            }
+            for (size_t j = 0; j < pools.size() && !found; j++)
+            {
+                found = pools[j].streaming == (track->vorbis != NULL)
+                && SDL_memcmp(&pools[j].format, &track->format, sizeof(track->format)) == 0;
+            }
+            if (!found)
+            {
+                PooledVoice pool;
+                SDL_zero(pool);
+                pool.format = track->format;
+                pool.streaming = track->vorbis != NULL;
+                pools.push_back(pool);
+            }
+        }
+
+        SDL_zero(stream_callbacks);
+        stream_callbacks.OnBufferStart = &SoundTrack::refillReserve;
+        stream_callbacks.OnBufferEnd = &SoundTrack::swapBuffers;
+
+        num_voices = pools.size() * VVV_MAX_CHANNELS;
+        if (num_voices == 0)
+        {
+            return;
+        }
+        voices = (PooledVoice*) SDL_calloc(num_voices, sizeof(PooledVoice));
         if (voices == NULL)
         {
-            voices = (FAudioSourceVoice**) SDL_malloc(sizeof(FAudioSourceVoice*) * VVV_MAX_CHANNELS);
-            for (int i = 0; i < VVV_MAX_CHANNELS; i++)
+            VVV_exit(1);
+        }
+
+        for (int i = 0; i < num_voices; i++)
+        {
+            PooledVoice* pooled = &voices[i];
+            *pooled = pools[i / VVV_MAX_CHANNELS];
+            if (FAudio_CreateSourceVoice(
+                faudioctx,
+                &pooled->voice,
+                &pooled->format,
+                0,
+                2.0f,
+                pooled->streaming ? &stream_callbacks : NULL,
+                NULL,
+                NULL
+            ))
             {
-                FAudioWaveFormatEx format;
-                format.nChannels = 1; /* Assume 1 for SoundTracks. Will be recreated if mismatched during play */
-                format.nSamplesPerSec = audio_rate;
-                format.wFormatTag = FAUDIO_FORMAT_PCM;
-                format.wBitsPerSample = 16;
-                format.nBlockAlign = format.nChannels * format.wBitsPerSample;
-                format.nAvgBytesPerSec = format.nSamplesPerSec * format.nBlockAlign;
-                format.cbSize = 0;
-                voice_formats[i] = format;
-                if (FAudio_CreateSourceVoice(faudioctx, &voices[i], &format, 0, 2.0f, NULL, NULL, NULL))
-                {
-                    vlog_error("Unable to create source voice no. %i", i);
-                    return;
-                }
+                vlog_error("Unable to create source voice no. %i", i);
+                pooled->voice = NULL;
             }
         }
+
+        vlog_debug(
+            "Created %i sound effect voices in %i pools",
+            num_voices,
+            (int) pools.size()
+        );
     }
 
     static void Pause(void)
     {
-        for (size_t i = 0; i < VVV_MAX_CHANNELS; i++)
+        render_sounds_paused = true;
+        if (voices == NULL)
         {
-            FAudioSourceVoice_Stop(voices[i], 0, FAUDIO_COMMIT_NOW);
+            return;
+        }
+        for (int i = 0; i < num_voices; i++)
+        {
+            if (voices[i].voice != NULL)
+            {
+                FAudioSourceVoice_Stop(voices[i].voice, 0, FAUDIO_COMMIT_NOW);
+            }
         }
     }
 
     static void Resume(void)
     {
-        for (size_t i = 0; i < VVV_MAX_CHANNELS; i++)
+        render_sounds_paused = false;
+        if (voices == NULL)
         {
-            FAudioSourceVoice_Start(voices[i], 0, FAUDIO_COMMIT_NOW);
+            return;
+        }
+        for (int i = 0; i < num_voices; i++)
+        {
+            if (voices[i].voice != NULL)
+            {
+                FAudioSourceVoice_Start(voices[i].voice, 0, FAUDIO_COMMIT_NOW);
+            }
         }
     }
 
@@ -295,20 +534,28 @@ end:
     {
         if (voices != NULL)
         {
-            for (int i = 0; i < VVV_MAX_CHANNELS; i++)
+            for (int i = 0; i < num_voices; i++)
             {
-                VVV_freefunc(FAudioVoice_DestroyVoice, voices[i]);
+                VVV_freefunc(FAudioVoice_DestroyVoice, voices[i].voice);
             }
             VVV_free(voices);
         }
+        num_voices = 0;
     }
 
     static void SetVolume(int soundVolume)
     {
         volume = (float) soundVolume / VVV_MAX_VOLUME;
-        for (size_t i = 0; i < VVV_MAX_CHANNELS; i++)
+        if (voices == NULL)
         {
-            FAudioVoice_SetVolume(voices[i], volume, FAUDIO_COMMIT_NOW);
+            return;
+        }
+        for (int i = 0; i < num_voices; i++)
+        {
+            if (voices[i].voice != NULL)
+            {
+                FAudioVoice_SetVolume(voices[i].voice, volume, FAUDIO_COMMIT_NOW);
+            }
         }
     }
 
@@ -328,13 +575,13 @@ end:
             return;
         }
 
-        inbounds = t->voice_index >= 0 && t->voice_index < VVV_MAX_CHANNELS;
+        inbounds = t->voice_index >= 0 && t->voice_index < num_voices;
         if (!inbounds)
         {
             return;
         }
 
-        FAudioSourceVoice_SubmitSourceBuffer(voices[t->voice_index], &faudio_buffer, NULL);
+        FAudioSourceVoice_SubmitSourceBuffer(voices[t->voice_index].voice, &faudio_buffer, NULL);
     }
 
     static void swapBuffers(FAudioVoiceCallback* callback, void* ctx)
@@ -357,35 +604,200 @@ end:
     Uint32 size;
     Uint8* decoded_buf_playing;
     Uint8* decoded_buf_reserve;
-    FAudioVoiceCallback callbacks;
 
     bool valid;
+    int priority;
+
+    /* Fully decoded Ogg effect, only used when rendering */
+    float* render_pcm;
+    Uint32 render_pcm_frames;
 
-    static FAudioSourceVoice** voices;
-    static FAudioWaveFormatEx voice_formats[VVV_MAX_CHANNELS];
+    static PooledVoice* voices;
+    static int num_voices;
+    static Uint32 play_counter;
+    static FAudioVoiceCallback stream_callbacks;
     static float volume;
 };
-FAudioSourceVoice** SoundTrack::voices = NULL;
-FAudioWaveFormatEx SoundTrack::voice_formats[VVV_MAX_CHANNELS];
+PooledVoice* SoundTrack::voices = NULL;
+int SoundTrack::num_voices = 0;
+Uint32 SoundTrack::play_counter = 0;
+FAudioVoiceCallback SoundTrack::stream_callbacks;
 float SoundTrack::volume = 0.0f;
 
 class MusicTrack
 {
 public:
-    MusicTrack(SDL_RWops *rw)
+    /* Tracks start out as just a description of where their data is,
+     * the Vorbis decoder and buffers are only created by EnsureLoaded(). */
+    MusicTrack(const char* path)
     {
         SDL_zerop(this);
-        read_buf = (Uint8*) SDL_malloc(rw->size(rw));
-        SDL_RWread(rw, read_buf, rw->size(rw), 1);
+        SDL_strlcpy(name, path, sizeof(name));
+    }
+
+    /* The memory must outlive the track, e.g. a music blob */
+    MusicTrack(const char* blob_name, const Uint8* mem, const int length)
+    {
+        SDL_zerop(this);
+        SDL_strlcpy(name, blob_name, sizeof(name));
+        source_mem = mem;
+        source_length = length;
+    }
+
+    /* Reads a loose music file into memory. Doesn't touch any of the track's
+     * state, so it can (and should) be done without holding decoder_lock. */
+    Uint8* ReadLooseFile(int* length)
+    {
+        SDL_RWops* rw = PHYSFSRWOPS_openRead(name);
+        if (rw == NULL)
+        {
+            vlog_error("Unable to read loose music file: %s", SDL_GetError());
+            return NULL;
+        }
+        *length = rw->size(rw);
+        Uint8* file = (Uint8*) SDL_malloc(*length);
+        if (file == NULL)
+        {
+            VVV_exit(1);
+        }
+        SDL_RWread(rw, file, *length, 1);
+        SDL_RWclose(rw);
+        return file;
+    }
+
+    /* Loads the track, taking decoder_lock itself. A loose file is read before
+     * taking the lock, so the disk never holds up the decoder thread. */
+    bool LoadUnlocked(void)
+    {
+        SDL_LockMutex(decoder_lock);
+        if (loaded || source_mem != NULL)
+        {
+            const bool ready = EnsureLoaded(NULL, 0);
+            SDL_UnlockMutex(decoder_lock);
+            return ready;
+        }
+        SDL_UnlockMutex(decoder_lock);
+
+        int length = 0;
+        Uint8* file = ReadLooseFile(&length);
+
+        SDL_LockMutex(decoder_lock);
+        bool ready;
+        if (file == NULL && !loaded)
+        {
+            /* Don't retry a broken track every time it's played */
+            loaded = true;
+            ready = false;
+        }
+        else
+        {
+            ready = EnsureLoaded(file, length);
+        }
+        SDL_UnlockMutex(decoder_lock);
+        return ready;
+    }
+
+    /* Must hold decoder_lock (or the decoder thread must not be running).
+     * file is a loose file already read by ReadLooseFile(), which this takes
+     * over, or NULL to read it here if needed. */
+    bool EnsureLoaded(Uint8* file, int length)
+    {
+        Touch();
+
+        if (loaded)
+        {
+            VVV_free(file);
+            return valid;
+        }
+        /* Don't retry a broken track every time it's played */
+        loaded = true;
+
+        const Uint64 start = SDL_GetPerformanceCounter();
+        if (source_mem != NULL)
+        {
+            Load(source_mem, source_length);
+        }
+        else
+        {
+            if (file == NULL)
+            {
+                file = ReadLooseFile(&length);
+            }
+            if (file == NULL)
+            {
+                return false;
+            }
+            source_length = length;
+            read_buf = file;
+            if (!Load(read_buf, source_length))
+            {
+                VVV_free(read_buf);
+            }
+        }
+        const Uint64 end = SDL_GetPerformanceCounter();
+
+        if (valid)
+        {
+            vlog_info(
+                "Loaded music track %s in %.2f ms",
+                name,
+                (end - start) * 1000.0 / SDL_GetPerformanceFrequency()
+            );
+        }
+        return valid;
+    }
+
+    /* Must hold decoder_lock (or the decoder thread must not be running). */
+    void Unload(void)
+    {
+        VVV_freefunc(stb_vorbis_close, vorbis);
+        VVV_free(read_buf);
+        VVV_free(decoded_buf_playing);
+        VVV_free(decoded_buf_reserve);
+        VVV_free(ring);
+        ring_capacity = 0;
+        decoding = false;
+        valid = false;
+        loaded = false;
+        if (predecoded == this)
+        {
+            predecoded = NULL;
+        }
+    }
+
+    size_t MemoryUsage(void)
+    {
+        if (!valid)
+        {
+            return 0;
+        }
+
+        const stb_vorbis_info info = stb_vorbis_get_info(vorbis);
+        size_t usage = info.setup_memory_required + info.temp_memory_required;
+        usage += 2 * size;
+        usage += ring_capacity * sizeof(float);
+        if (read_buf != NULL)
+        {
+            usage += source_length;
+        }
+        return usage;
+    }
+
+    void Touch(void)
+    {
+        last_used = ++lru_clock;
+    }
+
+    bool Load(const Uint8* mem, const int length)
+    {
         int err;
         stb_vorbis_info vorbis_info;
         stb_vorbis_comment vorbis_comment;
-        vorbis = stb_vorbis_open_memory(read_buf, rw->size(rw), &err, NULL);
+        vorbis = stb_vorbis_open_memory(mem, length, &err, NULL);
         if (vorbis == NULL)
         {
             vlog_error("Unable to create Vorbis handle, error %d", err);
-            VVV_free(read_buf);
-            goto end;
+            return false;
         }
         vorbis_info = stb_vorbis_get_info(vorbis);
         format.wFormatTag = FAUDIO_FORMAT_IEEE_FLOAT;
@@ -407,35 +819,60 @@ public:
         vorbis_comment = stb_vorbis_get_comment(vorbis);
         parseComments(this, vorbis_comment.comment_list, vorbis_comment.comment_list_length);
         valid = true;
-
-end:
-        SDL_RWclose(rw);
+        return true;
     }
 
     void Dispose(void)
     {
-        VVV_freefunc(stb_vorbis_close, vorbis);
-        VVV_free(read_buf);
-        VVV_free(decoded_buf_playing);
-        VVV_free(decoded_buf_reserve);
-        if (!IsHalted())
-        {
-            VVV_freefunc(FAudioVoice_DestroyVoice, musicVoice);
-        }
+        Unload();
     }
 
     bool Play(bool loop)
     {
-        if (!valid)
+        /* Keep playing the current track if this one can't be played */
+        if (!LoadUnlocked())
         {
             return false;
         }
 
+        Halt();
+
+        SDL_LockMutex(decoder_lock);
+        /* The decoder thread may have evicted it in the meantime */
+        while (!loaded)
+        {
+            SDL_UnlockMutex(decoder_lock);
+            if (!LoadUnlocked())
+            {
+                return false;
+            }
+            SDL_LockMutex(decoder_lock);
+        }
+        if (!EnsureLoaded(NULL, 0))
+        {
+            SDL_UnlockMutex(decoder_lock);
+            return false;
+        }
+        active = this;
+        DropPredecode();
+        enforce_memory_budget(this);
         shouldloop = loop;
-        sample_pos = 0;
-        stb_vorbis_seek_start(vorbis);
+        if (!decoding || SDL_AtomicGet(&ended))
+        {
+            Rewind();
+        }
+        /* Make sure there's at least one buffer ready, the thread does the rest */
+        Decode(size / sizeof(float));
+        SDL_UnlockMutex(decoder_lock);
 
-        Halt();
+        if (rendering)
+        {
+            render_cursor = 0;
+            render_frames = 0;
+            render_phase = 0;
+            Resume();
+            return true;
+        }
 
         SDL_zero(callbacks);
         callbacks.OnBufferStart = &MusicTrack::refillReserve;
@@ -444,40 +881,99 @@ end:
 
         FAudioBuffer faudio_buffer;
         SDL_zero(faudio_buffer);
-        if (looplength == 0)
-        {
-            faudio_buffer.PlayLength = stb_vorbis_get_samples_float_interleaved(vorbis, channels, (float*) decoded_buf_playing, size / sizeof(float));
-        }
-        else
-        {
-            int samples_read = stb_vorbis_get_samples_float_interleaved(vorbis, channels, (float*) decoded_buf_playing, size / sizeof(float));
-            faudio_buffer.PlayLength = SDL_min(samples_read, (loopbegin + looplength) - sample_pos);
-        }
+        faudio_buffer.PlayLength = ReadRing(decoded_buf_playing);
         faudio_buffer.AudioBytes = size;
         faudio_buffer.pAudioData = decoded_buf_playing;
         faudio_buffer.pContext = this;
-        sample_pos += faudio_buffer.PlayLength;
         if (FAudioSourceVoice_SubmitSourceBuffer(musicVoice, &faudio_buffer, NULL))
         {
             vlog_error("Unable to queue sound buffer");
+            /* Destroys the voice and clears active (with decoder_lock held),
+             * so the decoder thread doesn't keep decoding for nothing */
+            Halt();
             return false;
         }
+        SDL_SemPost(decoder_wake);
         Resume();
         return true;
     }
 
+    /* Start decoding from the beginning of the track without playing it yet,
+     * so a later Play() has data ready immediately. Only one track is
+     * predecoded at a time; asking for another one drops the last one. */
+    void Predecode(void)
+    {
+        if (active == this && !IsHalted())
+        {
+            return;
+        }
+
+        if (!LoadUnlocked())
+        {
+            return;
+        }
+
+        SDL_LockMutex(decoder_lock);
+        /* Already decoding from the start, or evicted since it was loaded */
+        if ((predecoded == this && decoding) || !loaded)
+        {
+            SDL_UnlockMutex(decoder_lock);
+            return;
+        }
+        DropPredecode();
+        predecoded = this;
+        enforce_memory_budget(this);
+        Rewind();
+        SDL_UnlockMutex(decoder_lock);
+
+        SDL_SemPost(decoder_wake);
+    }
+
+    /* Stop decoding ahead for a track that isn't going to be played after
+     * all, so it doesn't keep its ring filled forever. Must hold decoder_lock. */
+    static void DropPredecode(void)
+    {
+        if (predecoded != NULL && predecoded != active)
+        {
+            predecoded->decoding = false;
+        }
+        predecoded = NULL;
+    }
+
+    static void CancelPredecode(void)
+    {
+        SDL_LockMutex(decoder_lock);
+        DropPredecode();
+        SDL_UnlockMutex(decoder_lock);
+    }
+
     static void Halt(void)
     {
         if (!IsHalted())
         {
-            FAudioSourceVoice_FlushSourceBuffers(musicVoice);
-            VVV_freefunc(FAudioVoice_DestroyVoice, musicVoice);
+            if (musicVoice != NULL)
+            {
+                FAudioSourceVoice_FlushSourceBuffers(musicVoice);
+                VVV_freefunc(FAudioVoice_DestroyVoice, musicVoice);
+            }
             paused = true;
         }
+        if (active != NULL)
+        {
+            /* The voice is gone, so nothing consumes this ring anymore */
+            SDL_LockMutex(decoder_lock);
+            active->decoding = false;
+            active = NULL;
+            SDL_UnlockMutex(decoder_lock);
+        }
     }
 
     static bool IsHalted(void)
     {
+        if (rendering)
+        {
+            return active == NULL;
+        }
         return musicVoice == NULL;
     }
 
@@ -485,7 +981,10 @@ end:
     {
         if (!IsHalted())
         {
-            FAudioSourceVoice_Stop(musicVoice, 0, FAUDIO_COMMIT_NOW);
+            if (musicVoice != NULL)
+            {
+                FAudioSourceVoice_Stop(musicVoice, 0, FAUDIO_COMMIT_NOW);
+            }
             paused = true;
         }
     }
@@ -499,7 +998,10 @@ end:
     {
         if (!IsHalted())
         {
-            FAudioSourceVoice_Start(musicVoice, 0, FAUDIO_COMMIT_NOW);
+            if (musicVoice != NULL)
+            {
+                FAudioSourceVoice_Start(musicVoice, 0, FAUDIO_COMMIT_NOW);
+            }
             paused = false;
         }
     }
@@ -507,12 +1009,135 @@ end:
     static void SetVolume(int controlVolume)
     {
         float adj_vol = (float)controlVolume / VVV_MAX_VOLUME;
-        if (!IsHalted())
+        volume = adj_vol;
+        if (musicVoice != NULL)
         {
             FAudioVoice_SetVolume(musicVoice, adj_vol, FAUDIO_COMMIT_NOW);
         }
     }
 
+    /* Seek back to the start and empty the ring. Must hold decoder_lock. */
+    void Rewind(void)
+    {
+        if (ring == NULL)
+        {
+            const Uint32 ahead_floats = (Uint32) (
+                (Uint64) format.nAvgBytesPerSec * VVV_MUSIC_RING_MS / 1000 / sizeof(float)
+            );
+            /* At least two buffers, whatever the sample rate */
+            const Uint32 min_floats = SDL_max(ahead_floats, 2 * (size / sizeof(float)));
+            ring_capacity = 1;
+            while (ring_capacity < min_floats)
+            {
+                ring_capacity <<= 1;
+            }
+            ring = (float*) SDL_malloc(ring_capacity * sizeof(float));
+            if (ring == NULL)
+            {
+                VVV_exit(1);
+            }
+        }
+
+        stb_vorbis_seek_start(vorbis);
+        sample_pos = 0;
+        SDL_AtomicSet(&ring_read, 0);
+        SDL_AtomicSet(&ring_write, 0);
+        SDL_AtomicSet(&ended, 0);
+        decoding = true;
+    }
+
+    /* Decode until the ring holds at least target samples (or is full).
+     * Must hold decoder_lock. Only the decoder lock holder writes ring_write. */
+    void Decode(const Uint32 target)
+    {
+        while (!SDL_AtomicGet(&ended))
+        {
+            const Uint32 write = (Uint32) SDL_AtomicGet(&ring_write);
+            const Uint32 used = write - (Uint32) SDL_AtomicGet(&ring_read);
+            if (used >= target || used >= ring_capacity)
+            {
+                break;
+            }
+
+            Uint32 max_floats = SDL_min(ring_capacity - used, SDL_arraysize(decoder_scratch));
+            max_floats -= max_floats % channels;
+            if (max_floats == 0)
+            {
+                break;
+            }
+
+            const int frames = DecodeFrames(decoder_scratch, max_floats);
+            if (frames <= 0)
+            {
+                SDL_AtomicSet(&ended, 1);
+                break;
+            }
+
+            const Uint32 count = frames * channels;
+            const Uint32 offset = write & (ring_capacity - 1);
+            const Uint32 first = SDL_min(count, ring_capacity - offset);
+            SDL_memcpy(&ring[offset], decoder_scratch, first * sizeof(float));
+            SDL_memcpy(ring, &decoder_scratch[first], (count - first) * sizeof(float));
+            SDL_AtomicSet(&ring_write, write + count);
+        }
+    }
+
+    int DecodeFrames(float* buffer, const int num_floats)
+    {
+        /* Second attempt is for when we've hit the end and need to loop */
+        for (int attempt = 0; attempt < 2; attempt++)
+        {
+            int frames = stb_vorbis_get_samples_float_interleaved(vorbis, channels, buffer, num_floats);
+            if (looplength != 0)
+            {
+                frames = SDL_min(frames, (loopbegin + looplength) - sample_pos);
+            }
+            if (frames > 0)
+            {
+                sample_pos += frames;
+                return frames;
+            }
+            if (!shouldloop)
+            {
+                break;
+            }
+            stb_vorbis_seek(vorbis, loopbegin);
+            sample_pos = loopbegin;
+        }
+        return 0;
+    }
+
+    /* Consumer side of the ring, called from the FAudio callbacks.
+     * Returns the number of frames copied into dst. */
+    Uint32 ReadRing(Uint8* dst)
+    {
+        /* Check ended first, so we don't miss samples written just before it */
+        const bool at_end = SDL_AtomicGet(&ended);
+        const Uint32 read = (Uint32) SDL_AtomicGet(&ring_read);
+        const Uint32 available = (Uint32) SDL_AtomicGet(&ring_write) - read;
+
+        Uint32 count = SDL_min(available, size / sizeof(float));
+        count -= count % channels;
+        if (count == 0)
+        {
+            if (at_end)
+            {
+                return 0;
+            }
+
+            /* Decoder fell behind, play silence rather than starving the voice */
+            SDL_memset(dst, 0, size);
+            return size / sizeof(float) / channels;
+        }
+
+        const Uint32 offset = read & (ring_capacity - 1);
+        const Uint32 first = SDL_min(count, ring_capacity - offset);
+        SDL_memcpy(dst, &ring[offset], first * sizeof(float));
+        SDL_memcpy(dst + first * sizeof(float), ring, (count - first) * sizeof(float));
+        SDL_AtomicSet(&ring_read, read + count);
+        return count / channels;
+    }
+
     stb_vorbis* vorbis;
     int channels;
     Uint32 size;
@@ -529,8 +1154,33 @@ end:
     bool shouldloop;
     bool valid;
 
+    char name[64];
+    const Uint8* source_mem; /* NULL if loaded from name instead */
+    int source_length;
+    bool loaded; /* Protected by decoder_lock */
+    bool prefetch; /* Protected by decoder_lock */
+    Uint32 last_used; /* Protected by decoder_lock */
+
+    /* Single-producer/single-consumer ring of decoded samples. The read and
+     * write positions only ever increase and are masked into the buffer. */
+    float* ring;
+    Uint32 ring_capacity; /* In samples, always a power of two */
+    SDL_atomic_t ring_read;
+    SDL_atomic_t ring_write;
+    SDL_atomic_t ended;
+    bool decoding; /* Protected by decoder_lock */
+
+    /* Position in decoded_buf_playing, only used when rendering */
+    Uint32 render_cursor;
+    Uint32 render_frames;
+    Uint32 render_phase;
+
     static bool paused;
     static FAudioSourceVoice* musicVoice;
+    static MusicTrack* active; /* Written with decoder_lock held */
+    static MusicTrack* predecoded; /* Protected by decoder_lock */
+    static Uint32 lru_clock;
+    static float volume;
 
     static void refillReserve(FAudioVoiceCallback* callback, void* ctx)
     {
@@ -538,44 +1188,15 @@ end:
         FAudioBuffer faudio_buffer;
         SDL_zero(faudio_buffer);
         UNUSED(callback);
-        if (t->looplength == 0)
-        {
-            faudio_buffer.PlayLength = stb_vorbis_get_samples_float_interleaved(t->vorbis, t->channels, (float*) t->decoded_buf_reserve, t->size / sizeof(float));
-        }
-        else
-        {
-            int samples_read = stb_vorbis_get_samples_float_interleaved(t->vorbis, t->channels, (float*) t->decoded_buf_reserve, t->size / sizeof(float));
-            faudio_buffer.PlayLength = SDL_min(samples_read, (t->loopbegin + t->looplength) - t->sample_pos);
-        }
+        faudio_buffer.PlayLength = t->ReadRing(t->decoded_buf_reserve);
         faudio_buffer.AudioBytes = t->size;
         faudio_buffer.pAudioData = t->decoded_buf_reserve;
         faudio_buffer.pContext = t;
+        SDL_SemPost(decoder_wake);
         if (faudio_buffer.PlayLength == 0)
         {
-            if (t->shouldloop)
-            {
-                stb_vorbis_seek(t->vorbis, t->loopbegin);
-                t->sample_pos = t->loopbegin;
-                if (t->looplength != 0)
-                {
-                    int samples_read = stb_vorbis_get_samples_float_interleaved(t->vorbis, t->channels, (float*) t->decoded_buf_reserve, t->size / sizeof(float));
-                    faudio_buffer.PlayLength = SDL_min(samples_read, (t->loopbegin + t->looplength) - t->sample_pos);
-                }
-                else
-                {
-                    faudio_buffer.PlayLength = stb_vorbis_get_samples_float_interleaved(t->vorbis, t->channels, (float*) t->decoded_buf_reserve, t->size / sizeof(float));
-                }
-                if (faudio_buffer.PlayLength == 0)
-                {
-                    return;
-                }
-            }
-            else
-            {
-                return;
-            }
+            return;
         }
-        t->sample_pos += faudio_buffer.PlayLength;
         FAudioSourceVoice_SubmitSourceBuffer(musicVoice, &faudio_buffer, NULL);
     }
 
@@ -709,6 +1330,344 @@ end:
 };
 bool MusicTrack::paused = false;
 FAudioSourceVoice* MusicTrack::musicVoice = NULL;
+MusicTrack* MusicTrack::active = NULL;
+MusicTrack* MusicTrack::predecoded = NULL;
+Uint32 MusicTrack::lru_clock = 0;
+float MusicTrack::volume = 1.0f;
+
+/* Unload least recently used tracks until we're under budget again.
+ * Must hold decoder_lock (or the decoder thread must not be running). */
+static void enforce_memory_budget(const MusicTrack* keep)
+{
+    if (memory_budget == 0)
+    {
+        return;
+    }
+
+    while (true)
+    {
+        size_t total = 0;
+        MusicTrack* oldest = NULL;
+
+        for (size_t i = 0; i < musicTracks.size(); i++)
+        {
+            MusicTrack* track = &musicTracks[i];
+            total += track->MemoryUsage();
+
+            if (!track->loaded || track == keep || track == MusicTrack::active)
+            {
+                continue;
+            }
+            if (oldest == NULL || track->last_used < oldest->last_used)
+            {
+                oldest = track;
+            }
+        }
+
+        if (total <= memory_budget || oldest == NULL)
+        {
+            break;
+        }
+
+        vlog_debug("Unloading music track %s to stay within budget", oldest->name);
+        oldest->Unload();
+    }
+}
+
+static int SDLCALL decoder_thread_func(void* unused)
+{
+    UNUSED(unused);
+
+    while (!SDL_AtomicGet(&decoder_quit))
+    {
+        /* Woken up whenever a buffer is consumed, with a timeout as a fallback */
+        SDL_SemWaitTimeout(decoder_wake, 50);
+
+        for (size_t i = 0; i < musicTracks.size(); i++)
+        {
+            MusicTrack* track = &musicTracks[i];
+
+            SDL_LockMutex(decoder_lock);
+            const bool fetch = track->prefetch;
+            track->prefetch = false;
+            SDL_UnlockMutex(decoder_lock);
+
+            /* Reads from disk without holding the lock */
+            if (fetch && track->LoadUnlocked())
+            {
+                SDL_LockMutex(decoder_lock);
+                enforce_memory_budget(track);
+                SDL_UnlockMutex(decoder_lock);
+            }
+        }
+
+        SDL_LockMutex(decoder_lock);
+        for (size_t i = 0; i < musicTracks.size(); i++)
+        {
+            MusicTrack* track = &musicTracks[i];
+            if (track->decoding)
+            {
+                track->Decode(track->ring_capacity);
+            }
+        }
+        SDL_UnlockMutex(decoder_lock);
+    }
+
+    return 0;
+}
+
+static void start_decoder_thread(void)
+{
+    SDL_AtomicSet(&decoder_quit, 0);
+    decoder_lock = SDL_CreateMutex();
+    decoder_wake = SDL_CreateSemaphore(0);
+    if (decoder_lock == NULL || decoder_wake == NULL)
+    {
+        vlog_error("Unable to create music decoder sync objects: %s", SDL_GetError());
+        return;
+    }
+
+    decoder_thread = SDL_CreateThread(decoder_thread_func, "Music decoder", NULL);
+    if (decoder_thread == NULL)
+    {
+        vlog_error("Unable to create music decoder thread: %s", SDL_GetError());
+    }
+}
+
+static void stop_decoder_thread(void)
+{
+    if (decoder_thread != NULL)
+    {
+        SDL_AtomicSet(&decoder_quit, 1);
+        SDL_SemPost(decoder_wake);
+        SDL_WaitThread(decoder_thread, NULL);
+        decoder_thread = NULL;
+    }
+    VVV_freefunc(SDL_DestroySemaphore, decoder_wake);
+    VVV_freefunc(SDL_DestroyMutex, decoder_lock);
+}
+
+static float render_pcm_sample(const Uint8* data, const int bits, const Uint32 index)
+{
+    switch (bits)
+    {
+    case 8:
+        return (data[index] - 128) / 128.0f;
+    case 16:
+        return (Sint16) SDL_SwapLE16(((const Uint16*) data)[index]) / 32768.0f;
+    case 32:
+        return (Sint32) SDL_SwapLE32(((const Uint32*) data)[index]) / 2147483648.0f;
+    }
+    return 0.0f;
+}
+
+/* Returns false once the effect has finished playing */
+static bool render_mix_sound(struct RenderVoice* voice, float* mix, const int frames)
+{
+    const SoundTrack* track = voice->track;
+    const int channels = track->format.nChannels;
+    const int bytes = track->format.wBitsPerSample / 8;
+    Uint32 length;
+
+    if (track->render_pcm != NULL)
+    {
+        length = track->render_pcm_frames;
+    }
+    else if (bytes > 0 && channels > 0)
+    {
+        length = track->wav_length / bytes / channels;
+    }
+    else
+    {
+        return false;
+    }
+
+    for (int i = 0; i < frames; i++)
+    {
+        if (voice->cursor >= length)
+        {
+            return false;
+        }
+
+        for (int c = 0; c < 2; c++)
+        {
+            const Uint32 index = voice->cursor * channels + SDL_min(c, channels - 1);
+            float sample;
+            if (track->render_pcm != NULL)
+            {
+                sample = track->render_pcm[index];
+            }
+            else
+            {
+                sample = render_pcm_sample(track->wav_buffer, track->format.wBitsPerSample, index);
+            }
+            mix[i * 2 + c] += sample * SoundTrack::volume;
+        }
+
+        /* Nearest-neighbour resampling is good enough for comparing output */
+        voice->phase += track->format.nSamplesPerSec;
+        voice->cursor += voice->phase / VVV_RENDER_RATE;
+        voice->phase %= VVV_RENDER_RATE;
+    }
+
+    return true;
+}
+
+static void render_mix_music(float* mix, const int frames)
+{
+    MusicTrack* track = MusicTrack::active;
+
+    if (track == NULL || MusicTrack::paused)
+    {
+        return;
+    }
+
+    for (int i = 0; i < frames; i++)
+    {
+        while (track->render_cursor >= track->render_frames)
+        {
+            track->render_cursor -= track->render_frames;
+
+            /* Decode synchronously, so the output doesn't depend on how far
+             * ahead the decoder thread happened to get */
+            SDL_LockMutex(decoder_lock);
+            track->Decode(track->size / sizeof(float));
+            SDL_UnlockMutex(decoder_lock);
+
+            track->render_frames = track->ReadRing(track->decoded_buf_playing);
+            if (track->render_frames == 0)
+            {
+                /* Finished, and not looping */
+                track->render_cursor = 0;
+                return;
+            }
+        }
+
+        const float* pcm = (const float*) track->decoded_buf_playing;
+        for (int c = 0; c < 2; c++)
+        {
+            const Uint32 index = track->render_cursor * track->channels + SDL_min(c, track->channels - 1);
+            mix[i * 2 + c] += pcm[index] * MusicTrack::volume;
+        }
+
+        track->render_phase += track->format.nSamplesPerSec;
+        track->render_cursor += track->render_phase / VVV_RENDER_RATE;
+        track->render_phase %= VVV_RENDER_RATE;
+    }
+}
+
+static void render_write_header(void)
+{
+    SDL_RWseek(render_out, 0, RW_SEEK_SET);
+    SDL_RWwrite(render_out, "RIFF", 4, 1);
+    SDL_WriteLE32(render_out, 36 + render_data_bytes);
+    SDL_RWwrite(render_out, "WAVEfmt ", 8, 1);
+    SDL_WriteLE32(render_out, 16);
+    SDL_WriteLE16(render_out, 1); /* PCM */
+    SDL_WriteLE16(render_out, 2); /* Channels */
+    SDL_WriteLE32(render_out, VVV_RENDER_RATE);
+    SDL_WriteLE32(render_out, VVV_RENDER_RATE * 2 * sizeof(Sint16));
+    SDL_WriteLE16(render_out, 2 * sizeof(Sint16));
+    SDL_WriteLE16(render_out, 16);
+    SDL_RWwrite(render_out, "data", 4, 1);
+    SDL_WriteLE32(render_out, render_data_bytes);
+    SDL_RWseek(render_out, 0, RW_SEEK_END);
+}
+
+static void render_open(const char* path)
+{
+    rendering = true;
+
+    if (render_out != NULL)
+    {
+        return;
+    }
+
+    /* init() runs again whenever resources are reloaded, keep appending */
+    if (render_data_bytes == 0)
+    {
+        render_out = SDL_RWFromFile(path, "wb");
+        render_start = SDL_GetPerformanceCounter();
+    }
+    else
+    {
+        render_out = SDL_RWFromFile(path, "r+b");
+    }
+    if (render_out == NULL)
+    {
+        vlog_error("Unable to open %s for rendering audio: %s", path, SDL_GetError());
+        return;
+    }
+    render_write_header();
+}
+
+static void render_close(const char* path)
+{
+    SDL_zeroa(render_voices);
+
+    if (render_out == NULL)
+    {
+        return;
+    }
+
+    render_write_header();
+    SDL_RWclose(render_out);
+    render_out = NULL;
+
+    /* Called on every resource reload too, so keep it out of the normal log */
+    vlog_debug(
+        "Rendered %.2f seconds of audio to %s in %.2f seconds",
+        (double) render_data_bytes / (VVV_RENDER_RATE * 2 * sizeof(Sint16)),
+        path,
+        (double) (SDL_GetPerformanceCounter() - render_start) / SDL_GetPerformanceFrequency()
+    );
+}
+
+static void render_step(const int timestep_ms)
+{
+    float mix[VVV_RENDER_CHUNK * 2];
+    Sint16 out[VVV_RENDER_CHUNK * 2];
+    int frames;
+
+    if (render_out == NULL)
+    {
+        return;
+    }
+
+    /* Carry the remainder, so the output stays exactly in step with the game */
+    render_remainder += VVV_RENDER_RATE * timestep_ms;
+    frames = render_remainder / 1000;
+    render_remainder %= 1000;
+
+    while (frames > 0)
+    {
+        const int chunk = SDL_min(frames, VVV_RENDER_CHUNK);
+
+        SDL_zeroa(mix);
+        render_mix_music(mix, chunk);
+        for (size_t i = 0; i < SDL_arraysize(render_voices); i++)
+        {
+            if (render_voices[i].track == NULL || render_sounds_paused)
+            {
+                continue;
+            }
+            if (!render_mix_sound(&render_voices[i], mix, chunk))
+            {
+                render_voices[i].track = NULL;
+            }
+        }
+
+        for (int i = 0; i < chunk * 2; i++)
+        {
+            const float sample = SDL_clamp(mix[i], -1.0f, 1.0f);
+            out[i] = SDL_SwapLE16((Sint16) (sample * 32767.0f));
+        }
+        SDL_RWwrite(render_out, out, 2 * sizeof(Sint16), chunk);
+        render_data_bytes += chunk * 2 * sizeof(Sint16);
+
+        frames -= chunk;
+    }
+}
 
 musicclass::musicclass(void)
 {
@@ -727,23 +1686,30 @@ musicclass::musicclass(void)
     quick_fade = true;
 
     usingmmmmmm = false;
+
+    memorybudget = 0;
+    renderpath = NULL;
 }
 
 void musicclass::init(void)
 {
-    if (FAudioCreate(&faudioctx, 0, FAUDIO_DEFAULT_PROCESSOR))
+    const Uint64 init_start = SDL_GetPerformanceCounter();
+
+    if (renderpath != NULL)
+    {
+        render_open(renderpath);
+    }
+    else if (FAudioCreate(&faudioctx, 0, FAUDIO_DEFAULT_PROCESSOR))
     {
         vlog_error("Unable to initialize FAudio");
         return;
     }
-    if (FAudio_CreateMasteringVoice(faudioctx, &masteringvoice, 2, 44100, 0, 0, NULL))
+    else if (FAudio_CreateMasteringVoice(faudioctx, &masteringvoice, 2, 44100, 0, 0, NULL))
     {
         vlog_error("Unable to create mastering voice");
         return;
     }
 
-    SoundTrack::Init(44100);
-
     soundTracks.push_back(SoundTrack( "sounds/jump.wav" ));
     soundTracks.push_back(SoundTrack( "sounds/jump2.wav" ));
     soundTracks.push_back(SoundTrack( "sounds/hurt.wav" ));
@@ -773,6 +1739,13 @@ void musicclass::init(void)
     soundTracks.push_back(SoundTrack( "sounds/trophy.wav" ));
     soundTracks.push_back(SoundTrack( "sounds/rescue.wav" ));
 
+    for (size_t i = 0; i < soundTracks.size(); i++)
+    {
+        soundTracks[i].priority = sound_priority(i);
+    }
+
+    SoundTrack::Init(soundTracks);
+
 #ifdef VVV_COMPILEMUSIC
     binaryBlob musicWriteBlob;
 #define FOREACH_TRACK(blob, track_name) blob.AddFileToBinaryBlob("data/" track_name);
@@ -796,21 +1769,16 @@ void musicclass::init(void)
             usingmmmmmm=false;
 
             int index;
-            SDL_RWops* rw;
 
 #define TRACK_LOAD_BLOB(blob, track_name) \
     index = blob.getIndex("data/" track_name); \
     if (index >= 0 && index < blob.max_headers) \
     { \
-        rw = SDL_RWFromConstMem(blob.getAddress(index), blob.getSize(index)); \
-        if (rw == NULL) \
-        { \
-            vlog_error("Unable to read music file header: %s", SDL_GetError()); \
-        } \
-        else \
-        { \
-            musicTracks.push_back(MusicTrack(rw)); \
-        } \
+        musicTracks.push_back(MusicTrack( \
+            blob.m_headers[index].name, \
+            (const Uint8*) blob.getAddress(index), \
+            blob.getSize(index) \
+        )); \
     }
 
 #define FOREACH_TRACK(blob, track_name) TRACK_LOAD_BLOB(blob, track_name)
@@ -833,7 +1801,8 @@ void musicclass::init(void)
     } \
     else \
     { \
-        musicTracks.push_back(MusicTrack(rw)); \
+        SDL_RWclose(rw); \
+        musicTracks.push_back(MusicTrack(track_name)); \
     }
 
             TRACK_NAMES(_)
@@ -847,7 +1816,6 @@ void musicclass::init(void)
 
         mmmmmm = true;
         int index;
-        SDL_RWops* rw;
 
 #define FOREACH_TRACK(blob, track_name) TRACK_LOAD_BLOB(blob, track_name)
 
@@ -858,8 +1826,11 @@ void musicclass::init(void)
         size_t index_ = 0;
         while (mmmmmm_blob.nextExtra(&index_))
         {
-            rw = SDL_RWFromConstMem(mmmmmm_blob.getAddress(index_), mmmmmm_blob.getSize(index_));
-            musicTracks.push_back(MusicTrack( rw ));
+            musicTracks.push_back(MusicTrack(
+                mmmmmm_blob.m_headers[index_].name,
+                (const Uint8*) mmmmmm_blob.getAddress(index_),
+                mmmmmm_blob.getSize(index_)
+            ));
 
             num_mmmmmm_tracks++;
             index_++;
@@ -876,20 +1847,36 @@ void musicclass::init(void)
 
     num_pppppp_tracks += musicTracks.size() - num_mmmmmm_tracks;
 
-    SDL_RWops* rw;
     size_t index_ = 0;
     while (pppppp_blob.nextExtra(&index_))
     {
-        rw = SDL_RWFromConstMem(pppppp_blob.getAddress(index_), pppppp_blob.getSize(index_));
-        musicTracks.push_back(MusicTrack( rw ));
+        musicTracks.push_back(MusicTrack(
+            pppppp_blob.m_headers[index_].name,
+            (const Uint8*) pppppp_blob.getAddress(index_),
+            pppppp_blob.getSize(index_)
+        ));
 
         num_pppppp_tracks++;
         index_++;
     }
+
+    memory_budget = memorybudget;
+    start_decoder_thread();
+
+    vlog_info(
+        "Music initialized in %.2f ms (%i tracks, loaded on demand)",
+        (SDL_GetPerformanceCounter() - init_start) * 1000.0 / SDL_GetPerformanceFrequency(),
+        (int) musicTracks.size()
+    );
 }
 
 void musicclass::destroy(void)
 {
+    if (rendering)
+    {
+        render_close(renderpath);
+    }
+
     for (size_t i = 0; i < soundTracks.size(); ++i)
     {
         soundTracks[i].Dispose();
@@ -897,6 +1884,9 @@ void musicclass::destroy(void)
     soundTracks.clear();
     SoundTrack::Destroy();
 
+    MusicTrack::Halt();
+    stop_decoder_thread();
+
     for (size_t i = 0; i < musicTracks.size(); ++i)
     {
         musicTracks[i].Dispose();
@@ -919,7 +1909,7 @@ void musicclass::set_sound_volume(int volume)
     SoundTrack::SetVolume(volume * user_sound_volume / USER_VOLUME_MAX);
 }
 
-void musicclass::play(int t)
+int musicclass::resolvetrack(int t)
 {
     if (mmmmmm && usingmmmmmm)
     {
@@ -939,6 +1929,46 @@ void musicclass::play(int t)
         t += num_mmmmmm_tracks;
     }
 
+    return t;
+}
+
+void musicclass::predecode(int t)
+{
+    if (t == -1)
+    {
+        return;
+    }
+
+    t = resolvetrack(t);
+
+    if (!INBOUNDS_VEC(t, musicTracks))
+    {
+        return;
+    }
+
+    musicTracks[t].Predecode();
+}
+
+void musicclass::prefetch(int t)
+{
+    t = resolvetrack(t);
+
+    if (!INBOUNDS_VEC(t, musicTracks) || decoder_thread == NULL)
+    {
+        return;
+    }
+
+    /* The decoder thread will pick this up */
+    SDL_LockMutex(decoder_lock);
+    musicTracks[t].prefetch = !musicTracks[t].loaded;
+    SDL_UnlockMutex(decoder_lock);
+    SDL_SemPost(decoder_wake);
+}
+
+void musicclass::play(int t)
+{
+    t = resolvetrack(t);
+
     safeToProcessMusic = true;
 
     if (currentsong == t && !m_doFadeOutVol)
@@ -1045,6 +2075,7 @@ void musicclass::haltdasmusik(const bool from_fade)
     {
         nicefade = false;
         nicechange = -1;
+        MusicTrack::CancelPredecode();
     }
 }
 
@@ -1133,6 +2164,13 @@ void musicclass::fadeMusicVolumeOut(const int fadeout_ms)
     fade.duration_ms = fadeout_ms * controlVolume / VVV_MAX_VOLUME;
     fade.start_volume = controlVolume;
     fade.end_volume = 0;
+
+    /* Get the next song decoding while this one fades out.
+     * niceplay() sets nicechange first, so this is the right track. */
+    if (nicefade && nicechange != -1)
+    {
+        predecode(nicechange);
+    }
 }
 
 void musicclass::fadeout(const bool quick_fade_ /*= true*/)
@@ -1163,6 +2201,11 @@ void musicclass::processmusicfadeout(void)
 
 void musicclass::processmusic(void)
 {
+    if (rendering)
+    {
+        render_step(game.get_timestep());
+    }
+
     if(!safeToProcessMusic)
     {
         return;
@@ -1195,11 +2238,14 @@ void musicclass::niceplay(int t)
     || (mmmmmm && usingmmmmmm && currentsong != t)
     || (mmmmmm && !usingmmmmmm && currentsong != t + num_mmmmmm_tracks))
     {
+        /* Before fading out, which predecodes nicechange */
+        nicechange = t;
+        nicefade = true;
         if (currentsong != -1)
         {
             fadeout(false);
         }
-        nicefade = true;
+        predecode(t);
     }
     nicechange = t;
 }
@@ -1229,22 +2275,17 @@ static const int areamap[] = {
 
 SDL_COMPILE_TIME_ASSERT(areamap, SDL_arraysize(areamap) == 20 * 20);
 
-void musicclass::changemusicarea(int x, int y)
+static int getareatrack(const int x, const int y)
 {
     int room;
     int track;
 
-    if (script.running)
-    {
-        return;
-    }
-
     room = musicroom(x, y);
 
     if (!INBOUNDS_ARR(room, areamap))
     {
         SDL_assert(0 && "Music map index out-of-bounds!");
-        return;
+        return -1;
     }
 
     track = areamap[room];
@@ -1253,7 +2294,7 @@ void musicclass::changemusicarea(int x, int y)
     {
     case -1:
         /* Don't change music. */
-        return;
+        return -1;
     case -2:
         /* Special case: Tower music, changes with Flip Mode. */
         if (graphics.setflipmode)
@@ -1278,7 +2319,41 @@ void musicclass::changemusicarea(int x, int y)
         break;
     }
 
+    return track;
+}
+
+void musicclass::changemusicarea(int x, int y)
+{
+    int track;
+
+    if (script.running)
+    {
+        return;
+    }
+
+    track = getareatrack(x, y);
+
+    if (track == -1)
+    {
+        return;
+    }
+
     niceplay(track);
+
+    /* Get the music of the neighbouring areas loaded in the background,
+     * so walking into them doesn't have to wait on it */
+    static const int offsets[4][2] = {{-1, 0}, {1, 0}, {0, -1}, {0, 1}};
+    for (size_t i = 0; i < SDL_arraysize(offsets); i++)
+    {
+        const int neighbour = getareatrack(
+            (x + offsets[i][0] + 20) % 20,
+            (y + offsets[i][1] + 20) % 20
+        );
+        if (neighbour != -1 && neighbour != track)
+        {
+            prefetch(neighbour);
+        }
+    }
 }
 
 void musicclass::playef(int t)
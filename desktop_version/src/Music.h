@@ -73,6 +73,9 @@ public:
     void set_music_volume(int volume);
     void set_sound_volume(int volume);
 
+    int resolvetrack(int t);
+    void predecode(int t);
+    void prefetch(int t);
     void play(int t);
     void resume(void);
     void resumefade(const int fadein_ms);
@@ -124,6 +127,14 @@ public:
     binaryBlob mmmmmm_blob;
     int num_pppppp_tracks;
     int num_mmmmmm_tracks;
+
+    /* Bytes loaded music tracks may use before the least recently played
+     * ones are unloaded again, 0 for no limit. Applied on init(). */
+    size_t memorybudget;
+
+    /* If not NULL, don't use FAudio at all and instead mix everything into
+     * this WAV file, one fixed step at a time. Set before init(). */
+    const char* renderpath;
 };
 
 #ifndef MUSIC_DEFINITION
@@ -1235,6 +1235,20 @@ static void menurender(void)
             }
             break;
         }
+        case 4:
+        {
+            font::print(PR_2X | PR_CEN, -1, 30, loc::gettext("Binary Saves"), tr, tg, tb);
+            int next_y = font::print_wrap(PR_CEN, -1, 65, loc::gettext("Save the game in a compact format that loads faster, instead of as editable XML."), tr, tg, tb);
+            if (!game.binarysaves)
+            {
+                font::print_wrap(PR_CEN, -1, next_y, loc::gettext("Binary saves are OFF"), tr / 2, tg / 2, tb / 2);
+            }
+            else
+            {
+                font::print_wrap(PR_CEN, -1, next_y, loc::gettext("Binary saves are ON"), tr, tg, tb);
+            }
+            break;
+        }
         }
         break;
     case Menu::accessibility:
@@ -2226,6 +2240,23 @@ void gamecompleterender(void)
     graphics.render();
 }
 
+void loadingrender(void)
+{
+    graphics.clear();
+
+    char buffer[SCREEN_WIDTH_CHARS + 1];
+    vformat_buf(
+        buffer, sizeof(buffer),
+        loc::gettext("LOADING... {percent|digits=2|spaces}%"),
+        "percent:int",
+        cl.loadingprogress()
+    );
+
+    font::print(PR_RIGHT | PR_CJK_HIGH | PR_RTL_XFLIP, 282, 204, buffer, 124, 112, 218);
+
+    graphics.render();
+}
+
 void gamecompleterender2(void)
 {
     graphics.clear();
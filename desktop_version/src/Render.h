@@ -13,4 +13,6 @@ void gamecompleterender(void);
 
 void gamecompleterender2(void);
 
+void loadingrender(void);
+
 #endif /* RENDER_H */
@@ -7,6 +7,7 @@
 #include "Constants.h"
 #include "Exit.h"
 #include "FileSystemUtils.h"
+#include "Font.h"
 #include "Game.h"
 #include "Graphics.h"
 #include "GraphicsUtil.h"
@@ -365,6 +366,8 @@ void Screen::recacheTextures(void)
     graphics.foregrounddrawn = false;
     graphics.towerbg.tdrawback = true;
     graphics.titlebg.tdrawback = true;
+    font::clear_text_cache();
+    font::redraw_atlas();
 
     if (game.ingame_titlemode)
     {
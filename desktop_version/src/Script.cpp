@@ -28,6 +28,7 @@
 
 scriptclass::scriptclass(void)
 {
+    loadingmode = Start_MAINGAME;
     position = 0;
     scriptdelay = 0;
     running = false;
@@ -2617,6 +2618,27 @@ DECLARE_MODE_FUNC(is_intermission_2, INTERMISSION2)
 
 #undef DECLARE_MODE_FUNC
 
+void scriptclass::loadgamemode(const enum StartMode mode)
+{
+    switch (mode)
+    {
+    case Start_CUSTOM:
+    case Start_CUSTOM_QUICKSAVE:
+        if (INBOUNDS_VEC(game.playcustomlevel, cl.ListOfMetaData))
+        {
+            cl.startloading(cl.ListOfMetaData[game.playcustomlevel].filename);
+            loadingmode = mode;
+            game.gamestate = LOADINGMODE;
+            return;
+        }
+        break;
+    default:
+        break;
+    }
+
+    startgamemode(mode);
+}
+
 void scriptclass::startgamemode(const enum StartMode mode)
 {
     if (mode == Start_QUIT)
@@ -93,6 +93,10 @@ public:
 
     void startgamemode(enum StartMode mode);
 
+    /* Same as startgamemode(), but custom levels are read in the
+     * background while LOADINGMODE shows a progress screen */
+    void loadgamemode(enum StartMode mode);
+
     void teleport(void);
 
     void hardreset(void);
@@ -131,6 +135,7 @@ public:
 
     //Custom level stuff
     std::vector<Script> customscripts;
+    enum StartMode loadingmode;
 };
 
 #ifndef SCRIPT_DEFINITION
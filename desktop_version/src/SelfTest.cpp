@@ -0,0 +1,318 @@
+#include "SelfTest.h"
+
+#include <SDL.h>
+#include <string>
+#include <vector>
+
+#include "CustomLevels.h"
+#include "UtilityClass.h"
+#include "Vlogging.h"
+
+namespace selftest
+{
+
+static int num_checks;
+static int num_failed;
+
+static void check(const bool ok, const char* what, const char* detail)
+{
+    num_checks++;
+    if (!ok)
+    {
+        num_failed++;
+        vlog_error("Check failed: %s (%s)", what, detail);
+    }
+}
+
+/* The parsing customlevelclass::load() did before next_split_int() */
+static void split_ints_old(const char* str, std::vector<int>& values, std::vector<size_t>& starts)
+{
+    char buffer[16];
+    size_t start = 0;
+    while (next_split_s(buffer, sizeof(buffer), &start, str, ','))
+    {
+        values.push_back(help.Int(buffer));
+        starts.push_back(start);
+    }
+}
+
+static void split_ints_new(const char* str, std::vector<int>& values, std::vector<size_t>& starts)
+{
+    int value;
+    size_t start = 0;
+    while (next_split_int(&value, &start, str, ','))
+    {
+        values.push_back(value);
+        starts.push_back(start);
+    }
+}
+
+static void check_split_int(const char* str)
+{
+    std::vector<int> old_values, new_values;
+    std::vector<size_t> old_starts, new_starts;
+    split_ints_old(str, old_values, old_starts);
+    split_ints_new(str, new_values, new_starts);
+
+    check(
+        old_values == new_values && old_starts == new_starts,
+        "next_split_int() reads the same as next_split_s() and help.Int()",
+        str
+    );
+}
+
+static void test_split_int(void)
+{
+    static const char* const cases[] = {
+        "",
+        ",",
+        ",,",
+        "0",
+        "0,1,2,3",
+        "1,2,3,",
+        "1,,2",
+        ",5",
+        "-1,-20,-300,",
+        "-0,-,--1,",
+        "007,08,0x10,",
+        "abc,1x,x1,",
+        " 1, 2,",
+        "+5,",
+        "999999999,1000000000,2147483647,2147483648,",
+        "-2147483648,-2147483649,",
+        "12345678901234567890,",
+        "000000000000000000001,"
+    };
+    for (size_t i = 0; i < SDL_arraysize(cases); i++)
+    {
+        check_split_int(cases[i]);
+    }
+
+    /* And a lot of random lists, from the characters that matter */
+    static const char chars[] = "0123456789-,,,x ";
+    Uint32 seed = 1;
+    for (int i = 0; i < 2000; i++)
+    {
+        char str[32];
+        seed = seed * 1103515245 + 12345;
+        const size_t len = (seed >> 16) % (sizeof(str) - 1);
+        for (size_t j = 0; j < len; j++)
+        {
+            seed = seed * 1103515245 + 12345;
+            str[j] = chars[(seed >> 16) % (sizeof(chars) - 1)];
+        }
+        str[len] = '\0';
+        check_split_int(str);
+    }
+}
+
+static void test_append_split_ints(void)
+{
+    const int values[] = {0, 1, -1, 42, -300, 2147483647, -2147483647 - 1};
+    std::string str = "x";
+    append_split_ints(str, values, SDL_arraysize(values), ',');
+    check(
+        str == "x0,1,-1,42,-300,2147483647,-2147483648,",
+        "append_split_ints() formats like help.String()",
+        str.c_str()
+    );
+
+    std::vector<int> read_back;
+    std::vector<size_t> starts;
+    split_ints_new(str.c_str() + 1, read_back, starts);
+    check(
+        read_back == std::vector<int>(values, values + SDL_arraysize(values)),
+        "next_split_int() reads back what append_split_ints() wrote",
+        str.c_str()
+    );
+}
+
+/* storeroomband() takes a row of rooms, laid out like one row of the map */
+static const int band_width = SCREEN_WIDTH_TILES * customlevelclass::maxwidth;
+static const int band_tiles = band_width * SCREEN_HEIGHT_TILES;
+
+/* A tile that's different for every room and spot, with long runs and
+ * some empty rooms in the band */
+static int band_tile(const int rx, const int x, const int y)
+{
+    if (rx % 5 == 4)
+    {
+        return 0;
+    }
+    if (rx % 5 == 3)
+    {
+        return (x * 7 + y * 13 + rx) % 3 == 0 ? rx + 1 : 0;
+    }
+    return y < 10 + rx ? 0 : (x < 20 ? rx + 1 : 680 + rx);
+}
+
+static void fill_band(std::vector<int>& tiles)
+{
+    tiles.assign(band_tiles, 0);
+    for (int rx = 0; rx < customlevelclass::maxwidth; rx++)
+    {
+        for (int y = 0; y < SCREEN_HEIGHT_TILES; y++)
+        {
+            for (int x = 0; x < SCREEN_WIDTH_TILES; x++)
+            {
+                tiles[rx*SCREEN_WIDTH_TILES + x + y*band_width] = band_tile(rx, x, y);
+            }
+        }
+    }
+}
+
+static void test_room_band(const bool compress)
+{
+    const char* mode = compress ? "compressed" : "uncompressed";
+    cl.reset();
+    cl.compressrooms = compress;
+
+    std::vector<int> tiles;
+    fill_band(tiles);
+    cl.storeroomband(3, tiles.data());
+
+    std::vector<int> read_back(band_tiles, -1);
+    cl.loadroomband(3, read_back.data());
+    check(read_back == tiles, "loadroomband() reads back what storeroomband() stored", mode);
+
+    bool tiles_match = true;
+    for (int rx = 0; rx < customlevelclass::maxwidth; rx++)
+    {
+        for (int y = 0; y < SCREEN_HEIGHT_TILES; y += 7)
+        {
+            for (int x = 0; x < SCREEN_WIDTH_TILES; x += 3)
+            {
+                tiles_match &= cl.gettile(rx, 3, x, y) == band_tile(rx, x, y);
+            }
+        }
+    }
+    check(tiles_match, "gettile() sees the tiles in a stored band", mode);
+
+    cl.loadroomband(2, read_back.data());
+    check(
+        read_back == std::vector<int>(band_tiles, 0),
+        "A band that was never stored reads back empty",
+        mode
+    );
+    check(
+        cl.roomtiles[4 + 3*customlevelclass::maxwidth].tiles == NULL
+        && cl.roomtiles[4 + 3*customlevelclass::maxwidth].runs.empty(),
+        "Empty rooms in a band take no memory",
+        mode
+    );
+
+    /* Storing it again, with one room changed */
+    tiles[SCREEN_WIDTH_TILES + 29*band_width] = 123;
+    cl.storeroomband(3, tiles.data());
+    cl.loadroomband(3, read_back.data());
+    check(read_back == tiles, "Storing a band again replaces what was there", mode);
+
+    cl.reset();
+    cl.compressrooms = false;
+}
+
+static void test_room_eviction(void)
+{
+    const int max = customlevelclass::maxdecodedrooms;
+    cl.reset();
+    cl.compressrooms = true;
+
+    std::vector<int> tiles;
+    fill_band(tiles);
+    cl.storeroomband(0, tiles.data());
+    check(cl.numdecodedrooms == 0, "Storing a compressed band decodes nothing", "");
+
+    /* Every fifth room is empty, so these all have tiles. The oldest is room 0 */
+    const int rooms[] = {0, 1, 2, 3, 5, 6, 7, 8};
+    for (size_t i = 0; i < SDL_arraysize(rooms); i++)
+    {
+        cl.gettile(rooms[i], 0, 0, 29);
+    }
+    check(cl.numdecodedrooms == max, "Every room read is kept decoded, up to the limit", "");
+
+    /* Touch room 0 again, and change room 1 */
+    cl.gettile(0, 0, 0, 0);
+    cl.settile(1, 0, 5, 5, 77);
+
+    cl.gettile(10, 0, 0, 29);
+    check(cl.numdecodedrooms == max, "Decoding past the limit stays at the limit", "");
+    check(
+        cl.roomtiles[0].tiles != NULL && cl.roomtiles[2].tiles == NULL,
+        "The least recently used room is the one that's evicted",
+        ""
+    );
+
+    const int more_rooms[] = {11, 12, 13, 15, 16, 17, 18};
+    for (size_t i = 0; i < SDL_arraysize(more_rooms); i++)
+    {
+        cl.gettile(more_rooms[i], 0, 0, 29);
+    }
+    check(cl.roomtiles[1].tiles == NULL, "A changed room can be evicted", "");
+    check(
+        cl.gettile(1, 0, 5, 5) == 77 && cl.gettile(1, 0, 0, 29) == 2,
+        "An evicted room keeps its changes when it's decoded again",
+        ""
+    );
+
+    /* Emptying a room and evicting it leaves nothing behind */
+    for (int y = 0; y < SCREEN_HEIGHT_TILES; y++)
+    {
+        for (int x = 0; x < SCREEN_WIDTH_TILES; x++)
+        {
+            cl.settile(12, 0, x, y, 0);
+        }
+    }
+    for (size_t i = 0; i < SDL_arraysize(rooms); i++)
+    {
+        cl.gettile(rooms[i], 0, 0, 29);
+    }
+    check(
+        cl.roomtiles[12].tiles == NULL && cl.roomtiles[12].runs.empty(),
+        "An evicted room that was emptied has no runs left",
+        ""
+    );
+    check(cl.numdecodedrooms <= max, "The limit holds after all that", "");
+
+    bool list_ok = true;
+    int listed = 0;
+    for (int room = cl.newestroom; room != -1 && listed <= max; room = cl.roomtiles[room].older)
+    {
+        list_ok &= cl.roomtiles[room].tiles != NULL;
+        listed++;
+    }
+    check(
+        list_ok && listed == cl.numdecodedrooms,
+        "The decoded rooms are exactly the ones in the list",
+        ""
+    );
+
+    cl.reset();
+    cl.compressrooms = false;
+    check(
+        cl.numdecodedrooms == 0 && cl.newestroom == -1 && cl.oldestroom == -1,
+        "Resetting the level frees every decoded room",
+        ""
+    );
+}
+
+bool run(void)
+{
+    num_checks = 0;
+    num_failed = 0;
+
+    test_split_int();
+    test_append_split_ints();
+    test_room_band(false);
+    test_room_band(true);
+    test_room_eviction();
+
+    if (num_failed > 0)
+    {
+        vlog_error("%i of %i checks failed", num_failed, num_checks);
+        return false;
+    }
+    vlog_info("All %i checks passed", num_checks);
+    return true;
+}
+
+} // namespace selftest
@@ -0,0 +1,14 @@
+#ifndef SELFTEST_H
+#define SELFTEST_H
+
+/* Checks for the parts of the game that can run without a window or any
+ * assets, like parsers and caches. Run with -selftest. */
+namespace selftest
+{
+
+/* Returns false if any check failed */
+bool run(void);
+
+} // namespace selftest
+
+#endif /* SELFTEST_H */
@@ -0,0 +1,260 @@
+#include "StringPool.h"
+
+#include <SDL.h>
+
+#include "Alloc.h"
+#include "Hash.h"
+#include "Vlogging.h"
+
+/* Enough for anything we store raw (like TextboxFormat) */
+#define RAW_ALIGN 8
+
+void stringpool_init(StringPool* pool)
+{
+    SDL_zerop(pool);
+}
+
+void stringpool_clear(StringPool* pool)
+{
+    if (pool->protect)
+    {
+        return;
+    }
+
+    for (short p = 0; p < pool->pages_used; p++)
+    {
+        VVV_free(pool->page[p]);
+    }
+    pool->pages_used = 0;
+
+    VVV_free(pool->strings);
+    VVV_free(pool->hashes);
+    VVV_free(pool->table);
+    pool->num_strings = 0;
+    pool->strings_cap = 0;
+    pool->table_size = 0;
+
+    pool->num_requests = 0;
+    pool->bytes_requested = 0;
+}
+
+void stringpool_set_protected(StringPool* pool, bool protect)
+{
+    /* A protected pool is silently not cleared when requested.
+     * Not a memory leak as long as you unprotect and clear at some point. */
+    pool->protect = protect;
+}
+
+static void* pool_alloc(StringPool* pool, size_t data_len, size_t align)
+{
+    if (data_len > STRINGPOOL_PAGE_SIZE)
+    {
+        vlog_warn(
+            "Cannot store data of %lu bytes in StringPool, max page size is %d",
+            (unsigned long) data_len,
+            STRINGPOOL_PAGE_SIZE
+        );
+        return NULL;
+    }
+
+    /* Find a suitable page to place our data on */
+    short found_page = -1;
+    size_t cursor = 0;
+    for (short p = 0; p < pool->pages_used; p++)
+    {
+        cursor = (pool->page_len[p] + align-1) & ~(align-1);
+
+        if (cursor + data_len <= STRINGPOOL_PAGE_SIZE)
+        {
+            found_page = p;
+            break;
+        }
+    }
+
+    if (found_page == -1)
+    {
+        /* Create a new page then */
+        found_page = pool->pages_used;
+
+        if (found_page >= STRINGPOOL_MAX_PAGES)
+        {
+            vlog_warn(
+                "StringPool is full! %hd pages used (%d chars per page)",
+                pool->pages_used,
+                STRINGPOOL_PAGE_SIZE
+            );
+            return NULL;
+        }
+
+        pool->page[found_page] = (char*) SDL_malloc(STRINGPOOL_PAGE_SIZE);
+        if (pool->page[found_page] == NULL)
+        {
+            return NULL;
+        }
+
+        pool->page_len[found_page] = 0;
+        pool->pages_used++;
+        cursor = 0;
+    }
+
+    pool->page_len[found_page] = cursor + data_len;
+
+    return &pool->page[found_page][cursor];
+}
+
+static bool grow_table(StringPool* pool)
+{
+    Uint32 new_size = pool->table_size == 0 ? 1024 : pool->table_size*2;
+    StringHandle* new_table = (StringHandle*) SDL_calloc(new_size, sizeof(StringHandle));
+    if (new_table == NULL)
+    {
+        return false;
+    }
+
+    /* The hashes are kept, so the strings themselves don't need to be read again */
+    for (StringHandle handle = 1; handle < pool->num_strings; handle++)
+    {
+        Uint32 slot = pool->hashes[handle] & (new_size-1);
+        while (new_table[slot] != 0)
+        {
+            slot = (slot+1) & (new_size-1);
+        }
+        new_table[slot] = handle;
+    }
+
+    VVV_free(pool->table);
+    pool->table = new_table;
+    pool->table_size = new_size;
+    return true;
+}
+
+static bool grow_strings(StringPool* pool)
+{
+    Uint32 new_cap = pool->strings_cap == 0 ? 512 : pool->strings_cap*2;
+
+    const char** new_strings = (const char**) SDL_realloc((void*) pool->strings, new_cap*sizeof(const char*));
+    if (new_strings == NULL)
+    {
+        return false;
+    }
+    pool->strings = new_strings;
+
+    Uint32* new_hashes = (Uint32*) SDL_realloc(pool->hashes, new_cap*sizeof(Uint32));
+    if (new_hashes == NULL)
+    {
+        return false;
+    }
+    pool->hashes = new_hashes;
+
+    if (pool->strings_cap == 0)
+    {
+        /* Handle 0 */
+        pool->strings[0] = NULL;
+        pool->hashes[0] = 0;
+        pool->num_strings = 1;
+    }
+    pool->strings_cap = new_cap;
+    return true;
+}
+
+StringHandle stringpool_intern(StringPool* pool, const char* text)
+{
+    if (text == NULL)
+    {
+        return 0;
+    }
+
+    size_t len = SDL_strlen(text);
+    pool->num_requests++;
+    pool->bytes_requested += len+1;
+
+    /* Keep the table at most half full */
+    if ((pool->num_strings+1)*2 > pool->table_size && !grow_table(pool))
+    {
+        return 0;
+    }
+
+    Uint32 hash = hash_fnv1a32_str(HASH_FNV1A32_INIT, text);
+    Uint32 slot = hash & (pool->table_size-1);
+    while (pool->table[slot] != 0)
+    {
+        StringHandle handle = pool->table[slot];
+        if (pool->hashes[handle] == hash && SDL_strcmp(pool->strings[handle], text) == 0)
+        {
+            return handle;
+        }
+        slot = (slot+1) & (pool->table_size-1);
+    }
+
+    if (pool->num_strings >= pool->strings_cap && !grow_strings(pool))
+    {
+        return 0;
+    }
+
+    char* stored = (char*) pool_alloc(pool, len+1, 1);
+    if (stored == NULL)
+    {
+        return 0;
+    }
+    SDL_memcpy(stored, text, len+1);
+
+    StringHandle handle = pool->num_strings++;
+    pool->strings[handle] = stored;
+    pool->hashes[handle] = hash;
+    pool->table[slot] = handle;
+
+    return handle;
+}
+
+const char* stringpool_get(const StringPool* pool, StringHandle handle)
+{
+    if (handle == 0 || handle >= pool->num_strings)
+    {
+        return NULL;
+    }
+
+    return pool->strings[handle];
+}
+
+const char* stringpool_store(StringPool* pool, const char* text)
+{
+    return stringpool_get(pool, stringpool_intern(pool, text));
+}
+
+const void* stringpool_store_raw(StringPool* pool, const void* data, size_t data_len)
+{
+    /* Raw data isn't deduplicated, and doesn't get a handle */
+    if (data == NULL)
+    {
+        return NULL;
+    }
+
+    void* stored = pool_alloc(pool, data_len, RAW_ALIGN);
+    if (stored == NULL)
+    {
+        return NULL;
+    }
+    SDL_memcpy(stored, data, data_len);
+
+    pool->num_requests++;
+    pool->bytes_requested += data_len;
+
+    return stored;
+}
+
+void stringpool_get_stats(const StringPool* pool, StringPoolStats* stats)
+{
+    stats->num_strings = pool->num_strings > 0 ? pool->num_strings-1 : 0;
+    stats->num_requests = pool->num_requests;
+    stats->bytes_requested = pool->bytes_requested;
+
+    stats->bytes_stored = 0;
+    for (short p = 0; p < pool->pages_used; p++)
+    {
+        stats->bytes_stored += pool->page_len[p];
+    }
+
+    stats->bytes_allocated = (size_t) pool->pages_used * STRINGPOOL_PAGE_SIZE
+        + (size_t) pool->strings_cap * (sizeof(const char*) + sizeof(Uint32))
+        + (size_t) pool->table_size * sizeof(StringHandle);
+}
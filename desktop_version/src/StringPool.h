@@ -0,0 +1,70 @@
+#ifndef STRINGPOOL_H
+#define STRINGPOOL_H
+
+#include <SDL_stdinc.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/* A StringPool stores, potentially, a lot of text on a pile that shouldn't go anywhere
+ * until we change languages or (for example) unload an entire level's text.
+ *
+ * Every string is only stored once: storing the same text again gives back the same
+ * handle and pointer. Pointers stay valid until the pool is cleared, because the
+ * pages they're on are never moved or resized. */
+#define STRINGPOOL_MAX_PAGES 1000
+#define STRINGPOOL_PAGE_SIZE 50000
+
+/* 0 is never a valid handle */
+typedef Uint32 StringHandle;
+
+typedef struct _StringPool
+{
+    char* page[STRINGPOOL_MAX_PAGES];
+    size_t page_len[STRINGPOOL_MAX_PAGES];
+    short pages_used;
+
+    /* Indexed by handle */
+    const char** strings;
+    Uint32* hashes;
+    Uint32 num_strings; /* Including the unused handle 0 */
+    Uint32 strings_cap;
+
+    /* Open addressing with linear probing, size is a power of two, 0 means empty */
+    StringHandle* table;
+    Uint32 table_size;
+
+    /* What storing everything would have taken without deduplication */
+    Uint32 num_requests;
+    size_t bytes_requested;
+
+    bool protect;
+} StringPool;
+
+typedef struct _StringPoolStats
+{
+    Uint32 num_strings;
+    Uint32 num_requests;
+    size_t bytes_requested;
+    size_t bytes_stored; /* Text and raw data on the pages */
+    size_t bytes_allocated; /* Pages plus the handle arrays and lookup table */
+} StringPoolStats;
+
+void stringpool_init(StringPool* pool);
+void stringpool_clear(StringPool* pool);
+void stringpool_set_protected(StringPool* pool, bool protect);
+StringHandle stringpool_intern(StringPool* pool, const char* text);
+const char* stringpool_get(const StringPool* pool, StringHandle handle);
+const char* stringpool_store(StringPool* pool, const char* text);
+const void* stringpool_store_raw(StringPool* pool, const void* data, size_t data_len);
+void stringpool_get_stats(const StringPool* pool, StringPoolStats* stats);
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+#endif /* STRINGPOOL_H */
@@ -101,6 +101,101 @@ bool next_split_s(
     return retval;
 }
 
+bool next_split_int(
+    int* value,
+    size_t* start,
+    const char* str,
+    const char delim
+) {
+    const char* token = &str[*start];
+    const char* cursor = token;
+
+    if (*cursor == '\0')
+    {
+        return false;
+    }
+
+    const bool negative = *cursor == '-';
+    cursor += negative;
+
+    const char* digits = cursor;
+    unsigned int number = 0;
+    while ((unsigned char) (*cursor - '0') < 10)
+    {
+        number = number*10 + (*cursor - '0');
+        ++cursor;
+    }
+
+    const size_t num_digits = cursor - digits;
+
+    /* Fast path: a plain decimal number that can't overflow. Leading zeroes
+     * are octal to SDL_strtol(), so those go the slow way. */
+    if ((*cursor == delim || *cursor == '\0')
+    && num_digits > 0 && num_digits <= 9
+    && (digits[0] != '0' || num_digits == 1))
+    {
+        *value = negative ? -(int) number : (int) number;
+    }
+    else
+    {
+        while (*cursor != delim && *cursor != '\0')
+        {
+            ++cursor;
+        }
+
+        char buffer[16];
+        const size_t length = SDL_min(sizeof(buffer) - 1, (size_t) (cursor - token));
+        SDL_memcpy(buffer, token, length);
+        buffer[length] = '\0';
+        *value = UtilityClass::Int(buffer);
+    }
+
+    if (*cursor == delim)
+    {
+        ++cursor;
+    }
+
+    *start += cursor - token;
+    return true;
+}
+
+void append_split_ints(
+    std::string& str,
+    const int* values,
+    const size_t count,
+    const char delim
+) {
+    /* At most "-2147483648" plus the delimiter per value */
+    size_t len = str.size();
+    str.resize(len + count * 12);
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        char digits[10];
+        size_t num_digits = 0;
+        unsigned int number = values[i] < 0 ? 0u - (unsigned int) values[i] : (unsigned int) values[i];
+
+        do
+        {
+            digits[num_digits++] = '0' + number % 10;
+            number /= 10;
+        }
+        while (number > 0);
+
+        if (values[i] < 0)
+        {
+            str[len++] = '-';
+        }
+        while (num_digits > 0)
+        {
+            str[len++] = digits[--num_digits];
+        }
+        str[len++] = delim;
+    }
+
+    str.resize(len);
+}
+
 UtilityClass::UtilityClass(void) :
 glow(0),
     glowdir(0)
@@ -21,6 +21,24 @@ bool next_split_s(
     const char delim
 );
 
+/* Same as next_split_s() followed by help.Int() on the result, but reads the
+ * number in the same pass instead of copying it out first. Only for splitting
+ * big lists of plain integers, like the tiles of a level. */
+bool next_split_int(
+    int* value,
+    size_t* start,
+    const char* str,
+    const char delim
+);
+
+/* Appends each value followed by the delimiter, without any temporaries */
+void append_split_ints(
+    std::string& str,
+    const int* values,
+    const size_t count,
+    const char delim
+);
+
 bool is_number(const char* str);
 
 bool is_positive_num(const char* str, const bool hex);
@@ -71,7 +71,18 @@ tinyxml2::XMLElement* update_element_delete_contents(tinyxml2::XMLNode* parent,
 // string. Returns the element.
 tinyxml2::XMLElement* update_tag(tinyxml2::XMLNode* parent, const char* name, const char* value)
 {
-    tinyxml2::XMLElement* element = update_element_delete_contents(parent, name);
+    tinyxml2::XMLElement* element = parent != NULL ? parent->FirstChildElement(name) : NULL;
+    if (element != NULL
+    && element->FirstChild() != NULL
+    && element->FirstChild() == element->LastChild()
+    && element->FirstChild()->ToText() != NULL
+    && SDL_strcmp(element->FirstChild()->Value(), value) == 0)
+    {
+        // Already up to date, leave the node alone
+        return element;
+    }
+
+    element = update_element_delete_contents(parent, name);
 
     element->InsertNewText(value);
 
@@ -4,6 +4,7 @@
 #include <emscripten/html5.h>
 #endif
 
+#include "BinarySave.h"
 #include "ButtonGlyphs.h"
 #include "CustomLevels.h"
 #include "DeferCallbacks.h"
@@ -22,6 +23,7 @@
 #include "KeyPoll.h"
 #include "LevelDebugger.h"
 #include "Localization.h"
+#include "LocalizationMaint.h"
 #include "LocalizationStorage.h"
 #include "Logic.h"
 #include "Map.h"
@@ -33,6 +35,7 @@
 #include "RenderFixed.h"
 #include "Screen.h"
 #include "Script.h"
+#include "SelfTest.h"
 #include "UtilityClass.h"
 #include "Vlogging.h"
 
@@ -189,6 +192,13 @@ static const inline struct ImplFunc* get_gamestate_funcs(
         {Func_delta, preloaderrender},
     FUNC_LIST_END
 
+    FUNC_LIST_BEGIN(LOADINGMODE)
+        /* No input, but keep polling so the window stays responsive */
+        {Func_input, NULL},
+        {Func_fixed, loadinglogic},
+        {Func_delta, loadingrender},
+    FUNC_LIST_END
+
 #undef FUNC_LIST_END
 #undef FUNC_LIST_BEGIN
 
@@ -390,6 +400,11 @@ int main(int argc, char *argv[])
     bool open_console = false;
     bool print_version = false;
     bool print_addresses = false;
+    const char* convert_save_in = NULL;
+    const char* convert_save_out = NULL;
+    const char* benchmark_save = NULL;
+    bool run_selftest = false;
+    bool compile_lang = false;
     int invalid_arg = 0;
     int invalid_partial_arg = 0;
 
@@ -485,6 +500,53 @@ int main(int argc, char *argv[])
                 playassets = "levels/" + std::string(argv[i]) + ".vvvvvv";
             })
         }
+        else if (ARG("-musicbudget"))
+        {
+            ARG_INNER({
+                i++;
+                // In megabytes
+                music.memorybudget = (size_t) SDL_max(help.Int(argv[i]), 0) * 1024 * 1024;
+            })
+        }
+        else if (ARG("-compressrooms"))
+        {
+            cl.compressrooms = true;
+        }
+        else if (ARG("-renderaudio"))
+        {
+            ARG_INNER({
+                i++;
+                music.renderpath = argv[i];
+            })
+        }
+        else if (ARG("-convertsave"))
+        {
+            if (i + 2 < argc)
+            {
+                convert_save_in = argv[i + 1];
+                convert_save_out = argv[i + 2];
+                i += 2;
+            }
+            else
+            {
+                invalid_partial_arg = i;
+            }
+        }
+        else if (ARG("-benchmarksave"))
+        {
+            ARG_INNER({
+                i++;
+                benchmark_save = argv[i];
+            })
+        }
+        else if (ARG("-selftest"))
+        {
+            run_selftest = true;
+        }
+        else if (ARG("-compilelang"))
+        {
+            compile_lang = true;
+        }
         else if (ARG("-leveldebugger"))
         {
             level_debugger::set_forced();
@@ -556,6 +618,12 @@ int main(int argc, char *argv[])
         keep_console_open(open_console);
         VVV_exit(1);
     }
+    else if (invalid_partial_arg > 0 && SDL_strcmp(argv[invalid_partial_arg], "-convertsave") == 0)
+    {
+        vlog_error("-convertsave option requires two arguments.");
+        keep_console_open(open_console);
+        VVV_exit(1);
+    }
     else if (invalid_partial_arg > 0)
     {
         vlog_error("%s option requires one argument.", argv[invalid_partial_arg]);
@@ -598,6 +666,29 @@ int main(int argc, char *argv[])
         VVV_exit(0);
     }
 
+    if (convert_save_in != NULL)
+    {
+        /* Converts between XML and binary saves, then exits */
+        const bool success = binsave::convert_file(convert_save_in, convert_save_out);
+        keep_console_open(open_console);
+        VVV_exit(success ? 0 : 1);
+    }
+
+    if (benchmark_save != NULL)
+    {
+        /* Compares the save formats on an existing save, then exits */
+        const bool success = binsave::benchmark_file(benchmark_save, 1000);
+        keep_console_open(open_console);
+        VVV_exit(success ? 0 : 1);
+    }
+
+    if (run_selftest)
+    {
+        const bool success = selftest::run();
+        keep_console_open(open_console);
+        VVV_exit(success ? 0 : 1);
+    }
+
     SDL_SetHintWithPriority(SDL_HINT_IME_SHOW_UI, "1", SDL_HINT_OVERRIDE);
     SDL_SetHintWithPriority(SDL_HINT_IME_SUPPORT_EXTENDED_TEXT, "1", SDL_HINT_OVERRIDE);
 
@@ -710,6 +801,13 @@ int main(int argc, char *argv[])
 
     loc::loadtext(false);
     loc::loadlanguagelist();
+
+    if (compile_lang)
+    {
+        /* Writes lang/XX/compiled.vvvl for every language, then exits */
+        const bool success = loc::compile_lang_files();
+        VVV_exit(success ? 0 : 1);
+    }
     game.createmenu(Menu::mainmenu);
 
     graphics.create_buffers();
@@ -813,6 +911,7 @@ int main(int argc, char *argv[])
             cl.ListOfMetaData.push_back(meta);
         } else {
             cl.loadZips();
+            cl.mountZipFor(playtestname);
             if (cl.getLevelMetaDataAndPlaytestArgs(playtestname, meta, &pt_args)) {
                 cl.ListOfMetaData.clear();
                 cl.ListOfMetaData.push_back(meta);
@@ -866,6 +965,17 @@ int main(int argc, char *argv[])
 #else
     while (true)
     {
+        if (music.renderpath != NULL)
+        {
+            /* Rendering audio offline: run exactly one fixed step per
+             * iteration, as fast as we can, independent of the real clock */
+            timePrev = time_;
+            time_ += game.get_timestep();
+
+            deltaloop();
+            continue;
+        }
+
         f_time = SDL_GetTicks64();
 
         const Uint64 f_timetaken = f_time - f_timePrev;
@@ -900,6 +1010,7 @@ static void cleanup(void)
     }
 
     graphics.grphx.destroy();
+    GraphicsResources::destroy_parked();
     graphics.destroy_buffers();
     graphics.destroy();
     font::bidi_destroy();